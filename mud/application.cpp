@@ -15,6 +15,7 @@
 #include "utils/asset_manager.hpp"
 #include "utils/asset.hpp"
 #include "utils/console.hpp"
+#include "utils/job_system.hpp"
 #include "utils/logger.hpp"
 #include "utils/stopwatch.hpp"
 #include "utils/text_input_buffer.hpp"
@@ -55,6 +56,7 @@ namespace mud
     Application::~Application()
     {
         console::destroy();
+        job_system::destroy();
         AssetManager::getInstance().unloadAssets();
         delete m_applicationGraphicsContext;
     }
@@ -65,6 +67,9 @@ namespace mud
         Stopwatch renderStopwatch;
         double elapsedSinceDraw;
 
+        // Started from the main thread, which is the only thread allowed to call into GLFW
+        job_system::init();
+
         WindowProperties windowProperties;
         windowProperties.width = MUD_RESOLUTION_X;
         windowProperties.height = MUD_RESOLUTION_Y;
@@ -126,34 +131,38 @@ namespace mud
         camera.setPosition(Vector3(1, 3, 5));
 
         Scene scene;
-        SceneGraph::Node * selectedNode = nullptr;
+        SceneGraph::Handle selectedNode;
+
+        const SceneGraph::Handle lights = scene.getGraph().newNode();
+        scene.getGraph().getData(lights).pointLights.push_back(PointLight{Vector3(10, 0.25, 0), Color::white, 1.0f, 0.35f, 0.44f});
+        scene.getGraph().getData(lights).pointLights.push_back(PointLight{Vector3(2, 7, 0), Color::orange, 1.0f, 0.35f, 0.44f});
+        scene.getGraph().getData(lights).pointLights.push_back(PointLight{Vector3(-5, 1, 0), Color::cornflowerBlue, 1.0f, 0.35f, 0.44f});
 
-        SceneGraph::Node * lights = scene.getGraph().newNode();
-        lights->data.pointLights.push_back(PointLight{Vector3(10, 0.25, 0), Color::white, 1.0f, 0.35f, 0.44f});
-        lights->data.pointLights.push_back(PointLight{Vector3(2, 7, 0), Color::orange, 1.0f, 0.35f, 0.44f});
-        lights->data.pointLights.push_back(PointLight{Vector3(-5, 1, 0), Color::cornflowerBlue, 1.0f, 0.35f, 0.44f});
+        const SceneGraph::Handle cube1 = scene.getGraph().newNode();
+        scene.getGraph().setNodeTransform(cube1, transform_t(-2.0f, 0.0f, 0.0f));
+        scene.getGraph().getData(cube1).materialMeshPairs.push_back({ cubeMaterial, cubeMesh });
 
-        SceneGraph::Node * cube1 = scene.getGraph().newNode();
-        cube1->data.transform = transform_t(-2.0f, 0.0f, 0.0f);
-        cube1->data.materialMeshPairs.push_back({ cubeMaterial, cubeMesh });
+        const SceneGraph::Handle cube2 = scene.getGraph().newNode();
+        scene.getGraph().setNodeTransform(cube2, transform_t(0.0f, 0.0f, 0.0f));
+        scene.getGraph().getData(cube2).materialMeshPairs.push_back({ cubeMaterial, cubeMesh });
 
-        SceneGraph::Node * cube2 = scene.getGraph().newNode();
-        cube2->data.transform = transform_t(0.0f, 0.0f, 0.0f);
-        cube2->data.materialMeshPairs.push_back({ cubeMaterial, cubeMesh });
+        const SceneGraph::Handle cube3 = scene.getGraph().newNode();
+        scene.getGraph().setNodeTransform(cube3, transform_t(2.0f, 0.0f, 0.0f));
+        scene.getGraph().getData(cube3).materialMeshPairs.push_back({ cubeMaterial, cubeMesh });
 
-        SceneGraph::Node * cube3 = scene.getGraph().newNode();
-        cube3->data.transform = transform_t(2.0f, 0.0f, 0.0f);
-        cube3->data.materialMeshPairs.push_back({ cubeMaterial, cubeMesh });
+        const SceneGraph::Handle cube4 = scene.getGraph().newNode();
+        scene.getGraph().setNodeTransform(cube4, transform_t(4.0f, 0.0f, 0.0f));
+        scene.getGraph().getData(cube4).materialMeshPairs.push_back({ cubeMaterial, cubeMesh });
 
-        SceneGraph::Node * cube4 = scene.getGraph().newNode();
-        cube4->data.transform = transform_t(4.0f, 0.0f, 0.0f);
-        cube4->data.materialMeshPairs.push_back({ cubeMaterial, cubeMesh });
+        const SceneGraph::Handle model1 = scene.getGraph().copyNodeTree(*sceneGraph1->get());
+        scene.getGraph().setNodeTransform(model1, transform_s(0.01f));
 
-        SceneGraph::Node * model1 = scene.getGraph().copyNodeTree(*sceneGraph1->get());
-        model1->data.transform = transform_s(0.01f);
+        // Copied nodes are not batched, and the imported batches are in the imported graph's world space
+        if (!sceneGraph1->get()->getStaticBatches().empty())
+            scene.getGraph().buildStaticBatches();
 
-        //SceneGraph::Node * model2 = scene.getGraph().copyNodeTree(*sceneGraph2->get());
-        //model2->data.transform = Matrix4::identity;
+        //SceneGraph::Handle model2 = scene.getGraph().copyNodeTree(*sceneGraph2->get());
+        //scene.getGraph().setNodeTransform(model2, Matrix4::identity);
         
         RenderPassOptions renderPassOptions;
         renderPassOptions.clearColorBuffer = true;
@@ -164,19 +173,19 @@ namespace mud
         forwardRenderer.getDirectionalLight().color = Color(Vector3(0.05f));
 
         Scene gizmoScene;
-        SceneGraph::Node * selectedGizmo = nullptr;
+        SceneGraph::Handle selectedGizmo;
 
-        SceneGraph::Node * translateGizmoX = gizmoScene.getGraph().newNode();
-        translateGizmoX->data.materialMeshPairs.push_back({ redMaterial, cubeMesh });
-        translateGizmoX->data.isHidden = true;
+        const SceneGraph::Handle translateGizmoX = gizmoScene.getGraph().newNode();
+        gizmoScene.getGraph().getData(translateGizmoX).materialMeshPairs.push_back({ redMaterial, cubeMesh });
+        gizmoScene.getGraph().getData(translateGizmoX).isHidden = true;
 
-        SceneGraph::Node * translateGizmoY = gizmoScene.getGraph().newNode();
-        translateGizmoY->data.materialMeshPairs.push_back({ greenMaterial, cubeMesh });
-        translateGizmoY->data.isHidden = true;
+        const SceneGraph::Handle translateGizmoY = gizmoScene.getGraph().newNode();
+        gizmoScene.getGraph().getData(translateGizmoY).materialMeshPairs.push_back({ greenMaterial, cubeMesh });
+        gizmoScene.getGraph().getData(translateGizmoY).isHidden = true;
         
-        SceneGraph::Node * translateGizmoZ = gizmoScene.getGraph().newNode();
-        translateGizmoZ->data.materialMeshPairs.push_back({ blueMaterial, cubeMesh });
-        translateGizmoZ->data.isHidden = true;
+        const SceneGraph::Handle translateGizmoZ = gizmoScene.getGraph().newNode();
+        gizmoScene.getGraph().getData(translateGizmoZ).materialMeshPairs.push_back({ blueMaterial, cubeMesh });
+        gizmoScene.getGraph().getData(translateGizmoZ).isHidden = true;
         
         renderPassOptions.clearColorBuffer = false;
         renderPassOptions.clearDepthBuffer = true;
@@ -201,12 +210,18 @@ namespace mud
         console::init(*window);
 
         console::Command * newSceneNodeCommand = new console::Command("newSceneNode", "Sets the camera field of view", {}, [&](const std::vector<console::Argument *> & arguments) -> std::string {
-            SceneGraph::Node * newNode = scene.getGraph().newNode();
-            newNode->data.transform = Matrix4::identity;
-            newNode->data.materialMeshPairs.push_back({ cubeMaterial, cubeMesh });
+            const SceneGraph::Handle newNode = scene.getGraph().newNode();
+            scene.getGraph().setNodeTransform(newNode, Matrix4::identity);
+            scene.getGraph().getData(newNode).materialMeshPairs.push_back({ cubeMaterial, cubeMesh });
             return "Spawned new entity";
         });
         console::registerCommand(newSceneNodeCommand);
+
+        console::Command * occlusionCullingCommand = new console::Command("occlusionCulling", "Enables or disables software occlusion culling", { console::ParameterInfo{ console::ParameterType::Bool, "enabled", "Whether hidden meshes are culled" } }, [&](const std::vector<console::Argument *> & arguments) -> std::string {
+            scene.setOcclusionCullingEnabled(arguments[0]->getValue<bool>());
+            return scene.getOcclusionCullingEnabled() ? "Occlusion culling enabled" : "Occlusion culling disabled";
+        });
+        console::registerCommand(occlusionCullingCommand);
         
         mainLoopStopwatch.start();
         while (!window->getShouldClose())
@@ -262,67 +277,76 @@ namespace mud
                         }
                         else if (mouseState.buttons[MouseButton::Left].action == MouseButtonAction::Released)
                         {
-                            if (selectedGizmo == nullptr)
+                            if (!selectedGizmo.isValid())
                             {
                                 selectedNode = scene.rayCastQuery(window->getNormalisedDeviceCoordinates(mouseState.cursorPosition), camera);
 
-                                const bool isNodeSelected = selectedNode != nullptr;
+                                const bool isNodeSelected = selectedNode.isValid();
 
-                                translateGizmoX->data.isHidden = !isNodeSelected;
-                                translateGizmoY->data.isHidden = !isNodeSelected;
-                                translateGizmoZ->data.isHidden = !isNodeSelected;
+                                gizmoScene.getGraph().getData(translateGizmoX).isHidden = !isNodeSelected;
+                                gizmoScene.getGraph().getData(translateGizmoY).isHidden = !isNodeSelected;
+                                gizmoScene.getGraph().getData(translateGizmoZ).isHidden = !isNodeSelected;
+                                gizmoScene.getGraph().invalidateNode(translateGizmoX);
+                                gizmoScene.getGraph().invalidateNode(translateGizmoY);
+                                gizmoScene.getGraph().invalidateNode(translateGizmoZ);
 
                                 if (isNodeSelected)
                                 {
-                                    const Vector3 nodePosition = SceneGraph::getNodeWorldTransform(*selectedNode)[3];
+                                    const Vector3 nodePosition = scene.getGraph().getNodeWorldTransform(selectedNode)[3];
 
-                                    translateGizmoX->data.transform = transform_t(nodePosition + Vector3::posX) * transform_s(0.25f);
-                                    translateGizmoY->data.transform = transform_t(nodePosition + Vector3::posY) * transform_s(0.25f);
-                                    translateGizmoZ->data.transform = transform_t(nodePosition + Vector3::posZ) * transform_s(0.25f);
+                                    gizmoScene.getGraph().setNodeTransform(translateGizmoX, Transform(nodePosition + Vector3::posX, Quaternion::identity, Vector3(0.25f)).toMatrix());
+                                    gizmoScene.getGraph().setNodeTransform(translateGizmoY, Transform(nodePosition + Vector3::posY, Quaternion::identity, Vector3(0.25f)).toMatrix());
+                                    gizmoScene.getGraph().setNodeTransform(translateGizmoZ, Transform(nodePosition + Vector3::posZ, Quaternion::identity, Vector3(0.25f)).toMatrix());
                                 }
                             }
                             
-                            selectedGizmo = nullptr;
+                            selectedGizmo = SceneGraph::Handle();
                         }
 
                         if (mouseState.buttons[MouseButton::Left].isPressed)
                         {
-                            if (selectedGizmo != nullptr)
+                            if (selectedGizmo.isValid())
                             {
-                                const Matrix4 nodeWorldTransform = SceneGraph::getNodeWorldTransform(*selectedNode);
+                                const Matrix4 nodeWorldTransform = scene.getGraph().getNodeWorldTransform(selectedNode);
                                 
                                 const Vector2 cursorPosNDC = window->getNormalisedDeviceCoordinates(mouseState.cursorPosition);
-                                Vector4 worldSpacePosition = camera.getProjectionViewMatrix().inverse() * Vector4(cursorPosNDC.x, -cursorPosNDC.y, -1, 1);
+                                Vector4 worldSpacePosition = camera.getInverseProjectionViewMatrix() * Vector4(cursorPosNDC.x, -cursorPosNDC.y, -1, 1);
                                 worldSpacePosition /= worldSpacePosition.w;
                                 Vector3 rayDirection = Vector3(Vector3(worldSpacePosition) - camera.getPosition()).normal();
 
                                 if (selectedGizmo == translateGizmoX)
                                 {
-                                    RayCastResult result = intersection_test::rayCastPlane(camera.getPosition(), rayDirection, selectedNode->data.transform[3], Vector3::posY);
+                                    RayCastResult result = intersection_test::rayCastPlane(camera.getPosition(), rayDirection, scene.getGraph().getData(selectedNode).getTransform()[3], Vector3::posY);
                                     Vector3 planePos = camera.getPosition() + rayDirection * result.distance;
 
-                                    selectedNode->data.transform[3][0] = (planePos.x - 1) * (1 / nodeWorldTransform[0][0]);
+                                    Matrix4 nodeTransform = scene.getGraph().getData(selectedNode).getTransform();
+                                    nodeTransform[3][0] = (planePos.x - 1) * (1 / nodeWorldTransform[0][0]);
+                                    scene.getGraph().setNodeTransform(selectedNode, nodeTransform);
                                 }
                                 else if (selectedGizmo == translateGizmoY)
                                 {
-                                    RayCastResult result = intersection_test::rayCastPlane(camera.getPosition(), rayDirection, selectedNode->data.transform[3], Vector3::posX);
+                                    RayCastResult result = intersection_test::rayCastPlane(camera.getPosition(), rayDirection, scene.getGraph().getData(selectedNode).getTransform()[3], Vector3::posX);
                                     Vector3 planePos = camera.getPosition() + rayDirection * result.distance;
 
-                                    selectedNode->data.transform[3][1] = (planePos.y - 1) * (1 / nodeWorldTransform[1][1]);
+                                    Matrix4 nodeTransform = scene.getGraph().getData(selectedNode).getTransform();
+                                    nodeTransform[3][1] = (planePos.y - 1) * (1 / nodeWorldTransform[1][1]);
+                                    scene.getGraph().setNodeTransform(selectedNode, nodeTransform);
                                 }
                                 else if (selectedGizmo == translateGizmoZ)
                                 {
-                                    RayCastResult result = intersection_test::rayCastPlane(camera.getPosition(), rayDirection, selectedNode->data.transform[3], Vector3::posY);
+                                    RayCastResult result = intersection_test::rayCastPlane(camera.getPosition(), rayDirection, scene.getGraph().getData(selectedNode).getTransform()[3], Vector3::posY);
                                     Vector3 planePos = camera.getPosition() + rayDirection * result.distance;
 
-                                    selectedNode->data.transform[3][2] = (planePos.z - 1) * (1 / nodeWorldTransform[2][2]);
+                                    Matrix4 nodeTransform = scene.getGraph().getData(selectedNode).getTransform();
+                                    nodeTransform[3][2] = (planePos.z - 1) * (1 / nodeWorldTransform[2][2]);
+                                    scene.getGraph().setNodeTransform(selectedNode, nodeTransform);
                                 }
                                 
                                 const Vector3 nodePosition = nodeWorldTransform[3];
                                 
-                                translateGizmoX->data.transform = transform_t(nodePosition + Vector3::posX) * transform_s(0.25f);
-                                translateGizmoY->data.transform = transform_t(nodePosition + Vector3::posY) * transform_s(0.25f);
-                                translateGizmoZ->data.transform = transform_t(nodePosition + Vector3::posZ) * transform_s(0.25f);
+                                gizmoScene.getGraph().setNodeTransform(translateGizmoX, Transform(nodePosition + Vector3::posX, Quaternion::identity, Vector3(0.25f)).toMatrix());
+                                gizmoScene.getGraph().setNodeTransform(translateGizmoY, Transform(nodePosition + Vector3::posY, Quaternion::identity, Vector3(0.25f)).toMatrix());
+                                gizmoScene.getGraph().setNodeTransform(translateGizmoZ, Transform(nodePosition + Vector3::posZ, Quaternion::identity, Vector3(0.25f)).toMatrix());
                             }
                         }
                     }
@@ -377,6 +401,7 @@ namespace mud
             }
 
             window->pollEvents();
+            job_system::processMainThreadJobs();
         }
 
         window->getGraphicsContext().getSwapchain().waitUntilIdle();
@@ -0,0 +1,134 @@
+#include "archetype.hpp"
+
+#include <cstring>
+
+namespace mud::ecs
+{
+    namespace
+    {
+        size_t alignUp(size_t offset, size_t alignment)
+        {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    Archetype::Archetype(ComponentMask mask)
+        : m_mask(mask), m_chunkCapacity(0)
+    {
+        m_offsets.fill(k_noOffset);
+
+        size_t rowSize = sizeof(Entity);
+        for (ComponentTypeId type = 0; type < k_maxComponentTypes; ++type)
+            if ((mask & (ComponentMask(1) << type)) != 0)
+            {
+                m_types.push_back(type);
+                m_typeSizes.push_back(getComponentTypeInfo(type).size);
+                rowSize += m_typeSizes.back();
+            }
+
+        // Start from the capacity ignoring alignment padding, and shrink it until the padded arrays fit
+        for (size_t capacity = k_chunkSizeBytes / rowSize; capacity > 0; --capacity)
+        {
+            size_t offset = sizeof(Entity) * capacity;
+            for (size_t idx = 0; idx < m_types.size(); ++idx)
+            {
+                offset = alignUp(offset, getComponentTypeInfo(m_types[idx]).alignment);
+                m_offsets[m_types[idx]] = static_cast<uint32_t>(offset);
+                offset += m_typeSizes[idx] * capacity;
+            }
+
+            if (offset <= k_chunkSizeBytes)
+            {
+                m_chunkCapacity = static_cast<uint32_t>(capacity);
+                break;
+            }
+        }
+    }
+
+    ComponentMask Archetype::getMask() const
+    {
+        return m_mask;
+    }
+
+    bool Archetype::hasComponent(ComponentTypeId type) const
+    {
+        return (m_mask & (ComponentMask(1) << type)) != 0;
+    }
+
+    uint32_t Archetype::getChunkCapacity() const
+    {
+        return m_chunkCapacity;
+    }
+
+    size_t Archetype::getNumChunks() const
+    {
+        return m_chunks.size();
+    }
+
+    size_t Archetype::getNumEntities() const
+    {
+        return m_chunks.empty() ? 0 : (m_chunks.size() - 1) * m_chunkCapacity + m_chunkNumEntities.back();
+    }
+
+    uint32_t Archetype::getNumEntities(size_t chunkIdx) const
+    {
+        return m_chunkNumEntities[chunkIdx];
+    }
+
+    const Entity * Archetype::getEntities(size_t chunkIdx) const
+    {
+        return reinterpret_cast<const Entity *>(m_chunks[chunkIdx]->data);
+    }
+
+    void * Archetype::getComponents(size_t chunkIdx, ComponentTypeId type) const
+    {
+        return m_chunks[chunkIdx]->data + m_offsets[type];
+    }
+
+    Archetype::Location Archetype::add(Entity entity)
+    {
+        if (m_chunks.empty() || m_chunkNumEntities.back() == m_chunkCapacity)
+        {
+            m_chunks.push_back(std::make_unique<Chunk>());
+            m_chunkNumEntities.push_back(0);
+        }
+
+        const Location location{ static_cast<uint32_t>(m_chunks.size() - 1), m_chunkNumEntities.back()++ };
+        std::byte * data = m_chunks.back()->data;
+
+        reinterpret_cast<Entity *>(data)[location.row] = entity;
+        for (size_t idx = 0; idx < m_types.size(); ++idx)
+            std::memset(data + m_offsets[m_types[idx]] + m_typeSizes[idx] * location.row, 0, m_typeSizes[idx]);
+
+        return location;
+    }
+
+    Entity Archetype::remove(const Location & location)
+    {
+        const uint32_t lastRow = --m_chunkNumEntities.back();
+        std::byte * lastData = m_chunks.back()->data;
+        std::byte * data = m_chunks[location.chunkIdx]->data;
+
+        Entity movedEntity;
+        if (location.chunkIdx != m_chunks.size() - 1 || location.row != lastRow)
+        {
+            movedEntity = reinterpret_cast<Entity *>(lastData)[lastRow];
+            reinterpret_cast<Entity *>(data)[location.row] = movedEntity;
+
+            for (size_t idx = 0; idx < m_types.size(); ++idx)
+            {
+                const size_t offset = m_offsets[m_types[idx]];
+                const size_t size = m_typeSizes[idx];
+                std::memcpy(data + offset + size * location.row, lastData + offset + size * lastRow, size);
+            }
+        }
+
+        if (lastRow == 0)
+        {
+            m_chunks.pop_back();
+            m_chunkNumEntities.pop_back();
+        }
+
+        return movedEntity;
+    }
+}
\ No newline at end of file
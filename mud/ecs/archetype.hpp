@@ -0,0 +1,92 @@
+#ifndef ECS_ARCHETYPE_HPP
+#define ECS_ARCHETYPE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "component.hpp"
+#include "entity.hpp"
+
+namespace mud::ecs
+{
+    // Storage for all entities having exactly the same set of components. Entities are packed into fixed-size chunks,
+    // each holding one contiguous array per component type (structure of arrays) along with the array of entities,
+    // so systems touching a few components stream through just those arrays. Every chunk but the last is full.
+    class Archetype
+    {
+    public:
+
+        static constexpr size_t k_chunkSizeBytes = 16 * 1024;
+
+        // Where an entity's components are stored
+        struct Location
+        {
+            uint32_t chunkIdx;
+            uint32_t row;
+        };
+
+        explicit Archetype(ComponentMask mask);
+
+        Archetype(const Archetype &) = delete;
+
+        Archetype & operator=(const Archetype &) = delete;
+
+        ComponentMask getMask() const;
+
+        bool hasComponent(ComponentTypeId type) const;
+
+        // Entities that fit in one chunk
+        uint32_t getChunkCapacity() const;
+
+        size_t getNumChunks() const;
+
+        size_t getNumEntities() const;
+
+        uint32_t getNumEntities(size_t chunkIdx) const;
+
+        const Entity * getEntities(size_t chunkIdx) const;
+
+        // The chunk's array of the component type, which must be part of the archetype
+        void * getComponents(size_t chunkIdx, ComponentTypeId type) const;
+
+        template<typename T>
+        T * getComponents(size_t chunkIdx) const
+        {
+            return static_cast<T *>(getComponents(chunkIdx, getComponentTypeId<T>()));
+        }
+
+        // Appends a row for the entity, with its components zero-initialised
+        Location add(Entity entity);
+
+        // Fills the row with the last entity of the archetype, so the chunks stay packed. Returns the entity that was
+        // moved into the row, or an invalid entity when the removed one was the last.
+        Entity remove(const Location & location);
+
+    private:
+
+        static constexpr uint32_t k_noOffset = UINT32_MAX;
+
+        struct alignas(64) Chunk
+        {
+            std::byte data[k_chunkSizeBytes];
+        };
+
+        ComponentMask m_mask;
+        std::vector<ComponentTypeId> m_types;
+
+        // Size of the component type at the same index in m_types
+        std::vector<size_t> m_typeSizes;
+
+        // Byte offset of each component type's array in a chunk, k_noOffset for types not in the archetype
+        std::array<uint32_t, k_maxComponentTypes> m_offsets;
+
+        uint32_t m_chunkCapacity;
+        std::vector<std::unique_ptr<Chunk>> m_chunks;
+        std::vector<uint32_t> m_chunkNumEntities;
+    };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "component.hpp"
+
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#include "utils/logger.hpp"
+
+namespace mud::ecs
+{
+    namespace
+    {
+        std::mutex _componentTypesMutex;
+        std::vector<ComponentTypeInfo> _componentTypes;
+    }
+
+    ComponentTypeId registerComponentType(size_t size, size_t alignment)
+    {
+        std::lock_guard<std::mutex> lock(_componentTypesMutex);
+
+        // Ids past the limit have no bit in ComponentMask and would alias other types in every archetype, so this is fatal
+        if (_componentTypes.size() == k_maxComponentTypes)
+        {
+            log(LogLevel::Error, fmt::format("Too many component types registered, the limit is {0}\n", k_maxComponentTypes), "ECS");
+            std::abort();
+        }
+
+        _componentTypes.push_back({ size, alignment });
+        return static_cast<ComponentTypeId>(_componentTypes.size() - 1);
+    }
+
+    const ComponentTypeInfo & getComponentTypeInfo(ComponentTypeId type)
+    {
+        std::lock_guard<std::mutex> lock(_componentTypesMutex);
+        return _componentTypes[type];
+    }
+}
\ No newline at end of file
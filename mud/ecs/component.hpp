@@ -0,0 +1,47 @@
+#ifndef ECS_COMPONENT_HPP
+#define ECS_COMPONENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace mud::ecs
+{
+    using ComponentTypeId = uint32_t;
+
+    // One bit per component type, an archetype is identified by the mask of the components its entities have
+    using ComponentMask = uint64_t;
+
+    constexpr size_t k_maxComponentTypes = sizeof(ComponentMask) * 8;
+
+    struct ComponentTypeInfo
+    {
+        size_t size;
+        size_t alignment;
+    };
+
+    // Assigns the next component type id. Use getComponentTypeId instead.
+    ComponentTypeId registerComponentType(size_t size, size_t alignment);
+
+    const ComponentTypeInfo & getComponentTypeInfo(ComponentTypeId type);
+
+    // Ids are assigned on first use, so they can differ between runs and must not be saved. Components are moved
+    // between chunks with memcpy and never destroyed, so they must be plain data: the math types qualify despite
+    // their hand-written assignment operators, anything owning memory does not.
+    template<typename T>
+    ComponentTypeId getComponentTypeId()
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "Components must be plain data");
+
+        static const ComponentTypeId type = registerComponentType(sizeof(T), alignof(T));
+        return type;
+    }
+
+    template<typename... Ts>
+    ComponentMask getComponentMask()
+    {
+        return ((ComponentMask(1) << getComponentTypeId<Ts>()) | ... | ComponentMask(0));
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef ECS_ENTITY_HPP
+#define ECS_ENTITY_HPP
+
+#include <cstdint>
+
+namespace mud::ecs
+{
+    // Generational handle to an entity of a World. Stays valid until the entity is destroyed, after which its index
+    // may be reused with a new generation.
+    struct Entity
+    {
+        static constexpr uint32_t k_invalidIndex = UINT32_MAX;
+
+        uint32_t index = k_invalidIndex;
+        uint32_t generation = 0;
+
+        bool isValid() const
+        {
+            return index != k_invalidIndex;
+        }
+
+        bool operator==(const Entity & other) const
+        {
+            return index == other.index && generation == other.generation;
+        }
+
+        bool operator!=(const Entity & other) const
+        {
+            return !(*this == other);
+        }
+    };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "world.hpp"
+
+#include <cstring>
+
+namespace mud::ecs
+{
+    World::World()
+        : m_numEntities(0)
+    { }
+
+    Entity World::create()
+    {
+        return create(ComponentMask(0));
+    }
+
+    Entity World::create(ComponentMask mask)
+    {
+        Entity entity;
+        if (!m_freeIndices.empty())
+        {
+            entity.index = m_freeIndices.back();
+            m_freeIndices.pop_back();
+        }
+        else
+        {
+            entity.index = static_cast<uint32_t>(m_records.size());
+            m_records.push_back({ nullptr, {}, 0 });
+        }
+
+        EntityRecord & record = m_records[entity.index];
+        entity.generation = record.generation;
+
+        record.archetype = &getArchetype(mask);
+        record.location = record.archetype->add(entity);
+
+        ++m_numEntities;
+        return entity;
+    }
+
+    void World::destroy(Entity entity)
+    {
+        EntityRecord & record = m_records[entity.index];
+        removeRow(record);
+
+        // Bumping the generation invalidates any handle still held to the entity
+        record.archetype = nullptr;
+        ++record.generation;
+        m_freeIndices.push_back(entity.index);
+
+        --m_numEntities;
+    }
+
+    void World::clear()
+    {
+        m_records.clear();
+        m_freeIndices.clear();
+        m_numEntities = 0;
+        m_archetypes.clear();
+        m_archetypesByMask.clear();
+    }
+
+    bool World::isAlive(Entity entity) const
+    {
+        return entity.index < m_records.size() && m_records[entity.index].archetype != nullptr && m_records[entity.index].generation == entity.generation;
+    }
+
+    size_t World::getNumEntities() const
+    {
+        return m_numEntities;
+    }
+
+    void World::getChunks(ComponentMask mask, std::vector<ChunkView> & chunks) const
+    {
+        for (const auto & archetype : m_archetypes)
+            if ((archetype->getMask() & mask) == mask)
+                for (size_t chunkIdx = 0; chunkIdx < archetype->getNumChunks(); ++chunkIdx)
+                    chunks.push_back({ archetype.get(), chunkIdx });
+    }
+
+    Archetype & World::getArchetype(ComponentMask mask)
+    {
+        const auto it = m_archetypesByMask.find(mask);
+        if (it != m_archetypesByMask.end())
+            return *it->second;
+
+        m_archetypes.push_back(std::make_unique<Archetype>(mask));
+        m_archetypesByMask.emplace(mask, m_archetypes.back().get());
+        return *m_archetypes.back();
+    }
+
+    void World::move(Entity entity, ComponentMask mask)
+    {
+        EntityRecord & record = m_records[entity.index];
+        const EntityRecord source = record;
+
+        Archetype & destination = getArchetype(mask);
+        const Archetype::Location location = destination.add(entity);
+
+        const ComponentMask sharedMask = source.archetype->getMask() & mask;
+        for (ComponentTypeId type = 0; type < k_maxComponentTypes; ++type)
+            if ((sharedMask & (ComponentMask(1) << type)) != 0)
+            {
+                const size_t size = getComponentTypeInfo(type).size;
+                std::memcpy(static_cast<std::byte *>(destination.getComponents(location.chunkIdx, type)) + size * location.row,
+                    static_cast<const std::byte *>(source.archetype->getComponents(source.location.chunkIdx, type)) + size * source.location.row, size);
+            }
+
+        removeRow(source);
+
+        record.archetype = &destination;
+        record.location = location;
+    }
+
+    void World::removeRow(const EntityRecord & record)
+    {
+        const Entity movedEntity = record.archetype->remove(record.location);
+        if (movedEntity.isValid())
+            m_records[movedEntity.index].location = record.location;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#ifndef ECS_WORLD_HPP
+#define ECS_WORLD_HPP
+
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "archetype.hpp"
+#include "component.hpp"
+#include "entity.hpp"
+
+namespace mud::ecs
+{
+    // The entities of one chunk and their component arrays, for systems processing entities a chunk at a time
+    struct ChunkView
+    {
+        Archetype * archetype;
+        size_t chunkIdx;
+
+        uint32_t getNumEntities() const
+        {
+            return archetype->getNumEntities(chunkIdx);
+        }
+
+        const Entity * getEntities() const
+        {
+            return archetype->getEntities(chunkIdx);
+        }
+
+        template<typename T>
+        T * getComponents() const
+        {
+            return archetype->getComponents<T>(chunkIdx);
+        }
+    };
+
+    // Owns entities and their components, grouped into archetypes by component set. Adding or removing a component
+    // moves the entity to another archetype, so pointers to components are only stable until the next structural
+    // change. Queries iterate whole chunks, and separate chunks may be processed by separate threads as long as no
+    // entities are created, destroyed or change components meanwhile.
+    class World
+    {
+    public:
+
+        World();
+
+        World(const World &) = delete;
+
+        World & operator=(const World &) = delete;
+
+        Entity create();
+
+        template<typename... Ts>
+        Entity create(const Ts &... components)
+        {
+            const Entity entity = create(getComponentMask<Ts...>());
+            (set(entity, components), ...);
+            return entity;
+        }
+
+        void destroy(Entity entity);
+
+        // Destroys every entity and archetype
+        void clear();
+
+        bool isAlive(Entity entity) const;
+
+        size_t getNumEntities() const;
+
+        template<typename T>
+        bool has(Entity entity) const
+        {
+            return m_records[entity.index].archetype->hasComponent(getComponentTypeId<T>());
+        }
+
+        // nullptr if the entity does not have the component
+        template<typename T>
+        T * get(Entity entity) const
+        {
+            const EntityRecord & record = m_records[entity.index];
+            if (!record.archetype->hasComponent(getComponentTypeId<T>()))
+                return nullptr;
+
+            return record.archetype->getComponents<T>(record.location.chunkIdx) + record.location.row;
+        }
+
+        // Adds the component if the entity does not have it yet
+        template<typename T>
+        void set(Entity entity, const T & component)
+        {
+            const ComponentTypeId type = getComponentTypeId<T>();
+            if (!m_records[entity.index].archetype->hasComponent(type))
+                move(entity, m_records[entity.index].archetype->getMask() | (ComponentMask(1) << type));
+
+            *get<T>(entity) = component;
+        }
+
+        template<typename T>
+        void remove(Entity entity)
+        {
+            const ComponentTypeId type = getComponentTypeId<T>();
+            if (m_records[entity.index].archetype->hasComponent(type))
+                move(entity, m_records[entity.index].archetype->getMask() & ~(ComponentMask(1) << type));
+        }
+
+        // Appends the non-empty chunks of every archetype having at least the components Ts, in archetype creation
+        // order
+        template<typename... Ts>
+        void getChunks(std::vector<ChunkView> & chunks) const
+        {
+            getChunks(getComponentMask<Ts...>(), chunks);
+        }
+
+        void getChunks(ComponentMask mask, std::vector<ChunkView> & chunks) const;
+
+        // Calls function(entity, components...) for every entity having at least the components Ts
+        template<typename... Ts, typename Function>
+        void forEach(Function function) const
+        {
+            const ComponentMask mask = getComponentMask<Ts...>();
+
+            for (const auto & archetype : m_archetypes)
+            {
+                if ((archetype->getMask() & mask) != mask)
+                    continue;
+
+                for (size_t chunkIdx = 0; chunkIdx < archetype->getNumChunks(); ++chunkIdx)
+                {
+                    const ChunkView chunk{ archetype.get(), chunkIdx };
+                    const Entity * entities = chunk.getEntities();
+                    const std::tuple<Ts *...> components{ chunk.getComponents<Ts>()... };
+
+                    for (uint32_t row = 0; row < chunk.getNumEntities(); ++row)
+                        function(entities[row], std::get<Ts *>(components)[row]...);
+                }
+            }
+        }
+
+    private:
+
+        struct EntityRecord
+        {
+            Archetype * archetype;
+            Archetype::Location location;
+            uint32_t generation;
+        };
+
+        Entity create(ComponentMask mask);
+
+        Archetype & getArchetype(ComponentMask mask);
+
+        // Moves the entity to the archetype of the mask, keeping the components both archetypes share
+        void move(Entity entity, ComponentMask mask);
+
+        // Removes the entity's row from its archetype and fixes up the record of the entity moved into it
+        void removeRow(const EntityRecord & record);
+
+        std::vector<EntityRecord> m_records;
+        std::vector<uint32_t> m_freeIndices;
+        size_t m_numEntities;
+
+        std::vector<std::unique_ptr<Archetype>> m_archetypes;
+        std::unordered_map<ComponentMask, Archetype *> m_archetypesByMask;
+    };
+}
+
+#endif
\ No newline at end of file
@@ -65,14 +65,21 @@ namespace mud::graphics_backend::spirv
         return {result.cbegin(), result.cend()};
     }
 
-    std::vector<uint32_t> compileSourceToSPIRV(const std::string & sourceName, ShaderType type, const std::string & source, bool optimize)
+    std::vector<uint32_t> compileSourceToSPIRV(const std::string & sourceName, ShaderType type, const std::string & source, ShaderBuildProfile profile)
     {
         shaderc::Compiler compiler;
         shaderc::CompileOptions options;
 
-        if (optimize)
+        switch (profile)
         {
-            options.SetOptimizationLevel(shaderc_optimization_level_size);
+            case ShaderBuildProfile::Debug:
+                options.SetOptimizationLevel(shaderc_optimization_level_zero);
+                options.SetGenerateDebugInfo();
+                break;
+            case ShaderBuildProfile::Performance:
+                // The performance level runs spirv-opt's -O recipe which includes aggressive dead code elimination
+                options.SetOptimizationLevel(shaderc_optimization_level_performance);
+                break;
         }
 
         shaderc_shader_kind kind;
@@ -87,13 +94,25 @@ namespace mud::graphics_backend::spirv
 
         if (module.GetCompilationStatus() != shaderc_compilation_status_success)
         {
-            log (LogLevel::Error, fmt::format("Failed to compile shader to SPIR-V: {0}", module.GetErrorMessage()), "SPIR-V");
+            log (LogLevel::Error, fmt::format("Failed to compile shader '{0}' to SPIR-V: {1}", sourceName, module.GetErrorMessage()), "SPIR-V");
             return std::vector<uint32_t>();
         }
 
         return {module.cbegin(), module.cend()};
     }
 
+    std::string getSPIRVBlobFilepath(const std::string & sourceFilepath, ShaderBuildProfile profile)
+    {
+        const char * profileName = profile == ShaderBuildProfile::Debug ? "debug" : "performance";
+        return fmt::format("{0}.{1}.v{2}.spv", sourceFilepath, profileName, k_spirvBlobVersion);
+    }
+
+    bool isValidSPIRV(const std::vector<uint32_t> & spirv)
+    {
+        // 5 word header: magic, version, generator, bound, schema
+        return spirv.size() > 5 && spirv[0] == SpvMagicNumber;
+    }
+
     std::string spirvToGLSL(const std::vector<uint32_t> & spirv)
     {
         spirv_cross::CompilerGLSL glsl(spirv);
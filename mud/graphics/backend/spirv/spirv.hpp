@@ -1,6 +1,7 @@
 #include <string>
 #include <vector>
 
+#include "graphics/e_shader_build_profile.hpp"
 #include "graphics/e_shader_type.hpp"
 
 #include "spirv_reflect.h"
@@ -13,8 +14,19 @@ namespace mud::graphics_backend::spirv
     // Compiles a shader to SPIR-V assembly. Returns the assembly text as a string.
     std::string compileSourceToSPIRVAssembly(const std::string & sourceName, ShaderType type, const std::string & source, bool optimize = false);
 
-    // Compiles a shader to a SPIR-V binary. Returns the binary as a vector of 32-bit words.
-    std::vector<uint32_t> compileSourceToSPIRV(const std::string & sourceName, ShaderType type, const std::string & source, bool optimize = false);
+    // Compiles a shader to a SPIR-V binary using the compile options of the given build profile.
+    // Returns the binary as a vector of 32-bit words.
+    std::vector<uint32_t> compileSourceToSPIRV(const std::string & sourceName, ShaderType type, const std::string & source, ShaderBuildProfile profile);
+
+    // Bumped whenever precompiled blobs become incompatible with the engine (shader interface, compile options).
+    constexpr uint32_t k_spirvBlobVersion = 1;
+
+    // Returns the path of the precompiled blob for a shader source file and build profile,
+    // eg. "pbr.frag" -> "pbr.frag.performance.v1.spv".
+    std::string getSPIRVBlobFilepath(const std::string & sourceFilepath, ShaderBuildProfile profile);
+
+    // Returns true if the words look like a SPIR-V module (magic number and header present).
+    bool isValidSPIRV(const std::vector<uint32_t> & spirv);
 
     std::string spirvToGLSL(const std::vector<uint32_t> & spirv);
 
@@ -154,11 +154,13 @@ namespace mud::graphics_backend::vk
 
 		MUD__checkVulkanCall(vkCreateCommandPool(m_vkDevice, &vkCommanPoolCreateInfo, nullptr, &m_vkCommandPool), "Failed to create command pool");
 
-		std::array<VkDescriptorPoolSize, 2> poolSizes{};
+		std::array<VkDescriptorPoolSize, 3> poolSizes{};
 		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		poolSizes[0].descriptorCount = static_cast<uint32_t>(256);
 		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 		poolSizes[1].descriptorCount = static_cast<uint32_t>(256);
+		poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSizes[2].descriptorCount = static_cast<uint32_t>(256);
 
 		VkDescriptorPoolCreateInfo vkDescriptorPoolCreateInfo{};
 		vkDescriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
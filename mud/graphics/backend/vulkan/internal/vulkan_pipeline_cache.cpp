@@ -0,0 +1,172 @@
+#include "vulkan_pipeline_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fmt/format.h>
+#include <fstream>
+
+#include "utils/logger.hpp"
+#include "utils/stopwatch.hpp"
+#include "vulkan_debug.hpp"
+#include "vulkan_logical_device.hpp"
+
+namespace mud::graphics_backend::vk
+{
+	VulkanPipelineCache::~VulkanPipelineCache()
+	{
+		if (m_vkPipelineCache == VK_NULL_HANDLE)
+			return;
+
+		save();
+
+		log(LogLevel::Info, fmt::format("Pipeline cache: {0} pipelines created in {1:.2f}ms, {2} cache hits ({3} without driver feedback)\n", m_statistics.pipelinesCreated, m_statistics.totalCreationTimeMs, m_statistics.pipelineCacheHits, m_statistics.pipelinesWithoutFeedback), "Vulkan");
+
+		vkDestroyPipelineCache(m_logicalDevice->getVulkanHandle(), m_vkPipelineCache, nullptr);
+	}
+
+	bool VulkanPipelineCache::init(const VulkanLogicalDevice & logicalDevice, const std::string & filepath)
+	{
+		log(LogLevel::Trace, "Creating pipeline cache...\n", "Vulkan");
+
+		m_logicalDevice = &logicalDevice;
+		m_filepath = filepath;
+
+		vkGetPhysicalDeviceProperties(m_logicalDevice->getPhysicalDevice()->getVulkanHandle(), &m_vkPhysicalDeviceProperties);
+
+		std::vector<char> cacheData;
+		std::ifstream file(m_filepath, std::ios::in | std::ios::binary | std::ios::ate);
+
+		if (file.is_open())
+		{
+			cacheData.resize(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(cacheData.data(), cacheData.size());
+
+			if (!file.good() || !isCompatible(cacheData))
+			{
+				log(LogLevel::Warning, fmt::format("Discarding pipeline cache '{0}': data is corrupt or was created by a different driver or device\n", m_filepath), "Vulkan");
+				cacheData.clear();
+			}
+		}
+
+		VkPipelineCacheCreateInfo pipelineCacheCreateInfo{};
+		pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		pipelineCacheCreateInfo.initialDataSize = cacheData.size();
+		pipelineCacheCreateInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+		if (!MUD__checkVulkanCall(vkCreatePipelineCache(m_logicalDevice->getVulkanHandle(), &pipelineCacheCreateInfo, nullptr, &m_vkPipelineCache), "Failed to create pipeline cache"))
+			return false;
+
+		m_statistics.loadedSizeBytes = cacheData.size();
+		log(LogLevel::Info, fmt::format("Pipeline cache loaded {0} bytes from '{1}'\n", m_statistics.loadedSizeBytes, m_filepath), "Vulkan");
+
+		return true;
+	}
+
+	bool VulkanPipelineCache::save() const
+	{
+		if (m_vkPipelineCache == VK_NULL_HANDLE)
+			return false;
+
+		size_t dataSize = 0;
+		if (!MUD__checkVulkanCall(vkGetPipelineCacheData(m_logicalDevice->getVulkanHandle(), m_vkPipelineCache, &dataSize, nullptr), "Failed to query pipeline cache size"))
+			return false;
+
+		std::vector<char> cacheData(dataSize);
+		if (!MUD__checkVulkanCall(vkGetPipelineCacheData(m_logicalDevice->getVulkanHandle(), m_vkPipelineCache, &dataSize, cacheData.data()), "Failed to get pipeline cache data"))
+			return false;
+
+		// Write to a temporary file first so a crash mid-write never leaves a truncated cache behind
+		const std::string temporaryFilepath = m_filepath + ".tmp";
+		std::ofstream file(temporaryFilepath, std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if (file.fail())
+		{
+			log(LogLevel::Error, fmt::format("Failed to open file '{0}' for write\n", temporaryFilepath), "Vulkan");
+			return false;
+		}
+
+		file.write(cacheData.data(), dataSize);
+		file.close();
+
+		if (file.fail())
+		{
+			log(LogLevel::Error, fmt::format("Error while writing pipeline cache to '{0}'\n", temporaryFilepath), "Vulkan");
+			return false;
+		}
+
+		std::remove(m_filepath.c_str());
+		if (std::rename(temporaryFilepath.c_str(), m_filepath.c_str()) != 0)
+		{
+			log(LogLevel::Error, fmt::format("Failed to move pipeline cache to '{0}'\n", m_filepath), "Vulkan");
+			return false;
+		}
+
+		log(LogLevel::Trace, fmt::format("Saved {0} bytes of pipeline cache to '{1}'\n", dataSize, m_filepath), "Vulkan");
+
+		return true;
+	}
+
+	VkPipelineCache VulkanPipelineCache::getVulkanHandle() const
+	{
+		return m_vkPipelineCache;
+	}
+
+	bool VulkanPipelineCache::createGraphicsPipeline(const VkGraphicsPipelineCreateInfo & pipelineCreateInfo, VkPipeline & vkPipeline)
+	{
+		VkGraphicsPipelineCreateInfo createInfo = pipelineCreateInfo;
+
+		// Creation feedback is core in Vulkan 1.3; older devices just don't get hit statistics
+		const bool useFeedback = m_vkPhysicalDeviceProperties.apiVersion >= VK_API_VERSION_1_3;
+
+		VkPipelineCreationFeedback pipelineFeedback{};
+		std::vector<VkPipelineCreationFeedback> stageFeedbacks(createInfo.stageCount);
+
+		VkPipelineCreationFeedbackCreateInfo feedbackCreateInfo{};
+		feedbackCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+		feedbackCreateInfo.pNext = createInfo.pNext;
+		feedbackCreateInfo.pPipelineCreationFeedback = &pipelineFeedback;
+		feedbackCreateInfo.pipelineStageCreationFeedbackCount = createInfo.stageCount;
+		feedbackCreateInfo.pPipelineStageCreationFeedbacks = stageFeedbacks.data();
+
+		if (useFeedback)
+			createInfo.pNext = &feedbackCreateInfo;
+
+		Stopwatch stopwatch;
+		stopwatch.start();
+
+		if (!MUD__checkVulkanCall(vkCreateGraphicsPipelines(m_logicalDevice->getVulkanHandle(), m_vkPipelineCache, 1, &createInfo, nullptr, &vkPipeline), "Failed to create graphics pipeline"))
+			return false;
+
+		m_statistics.totalCreationTimeMs += stopwatch.stop();
+		++m_statistics.pipelinesCreated;
+
+		if (!useFeedback || (pipelineFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) == 0)
+			++m_statistics.pipelinesWithoutFeedback;
+		else if (pipelineFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT)
+			++m_statistics.pipelineCacheHits;
+
+		return true;
+	}
+
+	const VulkanPipelineCache::Statistics & VulkanPipelineCache::getStatistics() const
+	{
+		return m_statistics;
+	}
+
+	bool VulkanPipelineCache::isCompatible(const std::vector<char> & cacheData) const
+	{
+		VkPipelineCacheHeaderVersionOne header;
+
+		if (cacheData.size() < sizeof(header))
+			return false;
+
+		std::memcpy(&header, cacheData.data(), sizeof(header));
+
+		return header.headerSize >= sizeof(header)
+			&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& header.vendorID == m_vkPhysicalDeviceProperties.vendorID
+			&& header.deviceID == m_vkPhysicalDeviceProperties.deviceID
+			&& std::memcmp(header.pipelineCacheUUID, m_vkPhysicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef VULKAN_PIPELINE_CACHE_HPP
+#define VULKAN_PIPELINE_CACHE_HPP
+
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace mud::graphics_backend::vk
+{
+	class VulkanLogicalDevice;
+
+	class VulkanPipelineCache
+	{
+	public:
+
+		struct Statistics
+		{
+			size_t loadedSizeBytes = 0;
+			uint32_t pipelinesCreated = 0;
+			uint32_t pipelineCacheHits = 0;
+			uint32_t pipelinesWithoutFeedback = 0;
+			double totalCreationTimeMs = 0.0;
+		};
+
+		~VulkanPipelineCache();
+
+		// Creates the cache, seeding it with the contents of filepath if the file was written by the same driver and device
+		bool init(const VulkanLogicalDevice & logicalDevice, const std::string & filepath);
+
+		// Writes the current cache contents back to the file the cache was initialised from
+		bool save() const;
+
+		VkPipelineCache getVulkanHandle() const;
+
+		bool createGraphicsPipeline(const VkGraphicsPipelineCreateInfo & pipelineCreateInfo, VkPipeline & vkPipeline);
+
+		const Statistics & getStatistics() const;
+
+	private:
+
+		const VulkanLogicalDevice * m_logicalDevice = nullptr;
+		VkPipelineCache m_vkPipelineCache = VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties m_vkPhysicalDeviceProperties{};
+		std::string m_filepath;
+		Statistics m_statistics;
+
+		bool isCompatible(const std::vector<char> & cacheData) const;
+	};
+}
+
+#endif
@@ -35,6 +35,7 @@ namespace mud::graphics_backend::vk
 		m_physicalDevice.init(m_context, VulkanPhysicalDevice::Requirements{ k_deviceExtensions });
 		mainWindowGraphicsContext.getSurface().init(m_context, *m_mainWindow);
 		m_logicalDevice.init(m_context, m_physicalDevice, m_physicalDevice.getQueueFamilyDetails(mainWindowGraphicsContext.getSurface()), k_deviceExtensions, k_layers);
+		m_pipelineCache.init(m_logicalDevice, k_pipelineCacheFilepath);
 		mainWindowGraphicsContext.getSwapchain().init(m_logicalDevice, mainWindowGraphicsContext.getSurface());
 
 		s_instance = this;
@@ -55,4 +56,9 @@ namespace mud::graphics_backend::vk
 	{
 		return m_logicalDevice;
 	}
+
+	VulkanPipelineCache & VulkanApplicationGraphicsContext::getPipelineCache()
+	{
+		return m_pipelineCache;
+	}
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include "internal/vulkan_context.hpp"
 #include "internal/vulkan_logical_device.hpp"
 #include "internal/vulkan_physical_device.hpp"
+#include "internal/vulkan_pipeline_cache.hpp"
 #include "math/vector.hpp"
 
 namespace mud::graphics_backend::vk
@@ -28,6 +29,8 @@ namespace mud::graphics_backend::vk
 
 		const VulkanLogicalDevice & getLogicalDevice() const;
 
+		VulkanPipelineCache & getPipelineCache();
+
 	private:
 
 		static VulkanApplicationGraphicsContext * s_instance;
@@ -36,6 +39,8 @@ namespace mud::graphics_backend::vk
 			"VK_LAYER_KHRONOS_validation"
 		};
 
+		const std::string k_pipelineCacheFilepath = "pipeline_cache.bin";
+
 		const std::vector<std::string> k_deviceExtensions {
 			VK_KHR_SWAPCHAIN_EXTENSION_NAME
 		};
@@ -44,6 +49,7 @@ namespace mud::graphics_backend::vk
 		VulkanContext m_context;
 		VulkanPhysicalDevice m_physicalDevice;
 		VulkanLogicalDevice m_logicalDevice;
+		VulkanPipelineCache m_pipelineCache;
 	};
 }
 
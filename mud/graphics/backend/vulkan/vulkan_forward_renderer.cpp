@@ -1,5 +1,8 @@
 #include "vulkan_forward_renderer.hpp"
 
+#include <algorithm>
+#include <limits>
+
 #include "graphics/backend/spirv/spirv.hpp"
 #include "graphics/camera.hpp"
 #include "graphics/shader_module.hpp"
@@ -13,7 +16,9 @@
 #include "utils/logger.hpp"
 #include "vulkan_application_graphics_context.hpp"
 
-#define MAX_OBJECTS 32768
+// Objects and lights the storage buffers initially have room for, they grow when a frame needs more
+#define INITIAL_OBJECTS_CAPACITY 4096
+#define INITIAL_LIGHTS_CAPACITY 256
 
 namespace mud::graphics_backend::vk
 {
@@ -25,42 +30,28 @@ namespace mud::graphics_backend::vk
 
 		m_descriptorSetManager = new VulkanDescriptorSetManager(*swapchain.getLogicalDevice());
 
-		m_uniformBuffers.resize(swapchain.getImages().size());
-		m_uniformBuffersLights.resize(swapchain.getImages().size());
+		m_storageBuffersObjects.resize(swapchain.getImages().size(), nullptr);
+		m_storageBuffersLights.resize(swapchain.getImages().size());
 
 		const ShaderModule * vertexShaderModule = m_renderPass->getSubpasses()[0]->getShaderModule(ShaderType::Vertex);
 		const ShaderModule * fragmentShaderModule = m_renderPass->getSubpasses()[0]->getShaderModule(ShaderType::Fragment);
 
 		for (size_t idx = 0; idx < swapchain.getImages().size(); idx++)
 		{
-			// ubos
-
-			m_uniformBuffers[idx] = new VulkanBuffer(*swapchain.getLogicalDevice(), sizeof(UBO_PerObject) * MAX_OBJECTS, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-			VulkanDescriptorSet * newDescriptorSet = m_descriptorSetManager->allocate(*vertexShaderModule->getDescriptorSetLayouts()[0]);
-
-			VkDescriptorBufferInfo vkDescriptorBufferInfo{};
-			vkDescriptorBufferInfo.buffer = m_uniformBuffers[idx]->getVulkanHandle();
-			vkDescriptorBufferInfo.offset = 0;
-			vkDescriptorBufferInfo.range = sizeof(UBO_PerObject);
+			// objects
 
-			m_descriptorSetManager->update(newDescriptorSet, 0, vkDescriptorBufferInfo);
-
-			m_uboDescriptorSets.push_back(newDescriptorSet);
+			m_objectsDescriptorSets.push_back(m_descriptorSetManager->allocate(*vertexShaderModule->getDescriptorSetLayouts()[0]));
+			reserveStorageBuffer(*swapchain.getLogicalDevice(), m_storageBuffersObjects[idx], m_objectsDescriptorSets[idx], 0, sizeof(GLSLObject) * INITIAL_OBJECTS_CAPACITY);
 
 			// lights
 			
-			m_uniformBuffersLights[idx] = new VulkanBuffer(*swapchain.getLogicalDevice(), sizeof(UBO_Lights), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-			newDescriptorSet = m_descriptorSetManager->allocate(*fragmentShaderModule->getDescriptorSetLayouts()[0]);
-
-			vkDescriptorBufferInfo.buffer = m_uniformBuffersLights[idx]->getVulkanHandle();
-			vkDescriptorBufferInfo.offset = 0;
-			vkDescriptorBufferInfo.range = sizeof(UBO_Lights);
+			m_lightsDescriptorSets.push_back(m_descriptorSetManager->allocate(*fragmentShaderModule->getDescriptorSetLayouts()[0]));
+			m_storageBuffersLights[idx].fill(nullptr);
 
-			m_descriptorSetManager->update(newDescriptorSet, 0, vkDescriptorBufferInfo);
-
-			m_lightsDescriptorSets.push_back(newDescriptorSet);
+			std::array<VulkanBuffer *, LightsBinding_Count> & storageBuffers = m_storageBuffersLights[idx];
+			reserveStorageBuffer(*swapchain.getLogicalDevice(), storageBuffers[LightsBinding_PointLights], m_lightsDescriptorSets[idx], LightsBinding_PointLights, sizeof(GLSLPointLight) * INITIAL_LIGHTS_CAPACITY);
+			reserveStorageBuffer(*swapchain.getLogicalDevice(), storageBuffers[LightsBinding_Clusters], m_lightsDescriptorSets[idx], LightsBinding_Clusters, sizeof(GLSLLightClusterGridInfo) + sizeof(LightClusterGrid::Cluster) * LightClusterGrid::k_numClusters);
+			reserveStorageBuffer(*swapchain.getLogicalDevice(), storageBuffers[LightsBinding_LightIndices], m_lightsDescriptorSets[idx], LightsBinding_LightIndices, sizeof(uint32_t) * INITIAL_LIGHTS_CAPACITY);
 		}
 
 		m_descriptorSetManager->doAllocates();
@@ -105,11 +96,12 @@ namespace mud::graphics_backend::vk
 
 		delete m_descriptorSetManager;
 
-		for (VulkanBuffer * uniformBuffer : m_uniformBuffers)
-			delete uniformBuffer;
+		for (VulkanBuffer * storageBuffer : m_storageBuffersObjects)
+			delete storageBuffer;
 
-		for (VulkanBuffer * uniformBuffer : m_uniformBuffersLights)
-			delete uniformBuffer;
+		for (auto & storageBuffers : m_storageBuffersLights)
+			for (VulkanBuffer * storageBuffer : storageBuffers)
+				delete storageBuffer;
 
 		for (VkSampler vkSampler : m_vkTextureSamplers)
 			vkDestroySampler(vkDevice, vkSampler, nullptr);
@@ -139,7 +131,76 @@ namespace mud::graphics_backend::vk
 		bindTextureToDescriptorSet(descriptorSet, 3, material->roughnessMap->get());
 	}
 
-	void VulkanForwardRenderer::prepareDraw(const VulkanSwapchain & swapchain)
+	void VulkanForwardRenderer::reserveStorageBuffer(const VulkanLogicalDevice & logicalDevice, VulkanBuffer *& storageBuffer, VulkanDescriptorSet * descriptorSet, uint32_t binding, size_t size)
+	{
+		if (storageBuffer != nullptr && storageBuffer->getSize() >= size)
+			return;
+
+		// The frame's previous commands are done with the buffer by the time it is prepared again
+		const size_t newSize = storageBuffer != nullptr ? std::max(size, storageBuffer->getSize() * 2) : size;
+		delete storageBuffer;
+		storageBuffer = new VulkanBuffer(logicalDevice, newSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		VkDescriptorBufferInfo vkDescriptorBufferInfo{};
+		vkDescriptorBufferInfo.buffer = storageBuffer->getVulkanHandle();
+		vkDescriptorBufferInfo.offset = 0;
+		vkDescriptorBufferInfo.range = VK_WHOLE_SIZE;
+
+		m_descriptorSetManager->update(descriptorSet, binding, vkDescriptorBufferInfo);
+	}
+
+	void VulkanForwardRenderer::prepareLights(const VulkanSwapchain & swapchain, const Camera & camera)
+	{
+		const VulkanSwapchain::FrameInfo & frameInfo = swapchain.getCurrentFrameInfo();
+		const VulkanLogicalDevice & logicalDevice = *swapchain.getLogicalDevice();
+		std::array<VulkanBuffer *, LightsBinding_Count> & storageBuffers = m_storageBuffersLights[frameInfo.index];
+
+		m_lightClusterGrid.build(camera.getProjectionMatrix(), camera.getViewMatrix(), camera.getZNear(), camera.getZFar(), m_lights);
+
+		// Point lights, with their cut off radius in the attenuation's last component
+
+		m_glslPointLights.resize(m_lights.size());
+		for (size_t idx = 0; idx < m_lights.size(); ++idx)
+		{
+			m_glslPointLights[idx].position = Vector4(m_lights[idx].position, 1.0f);
+			m_glslPointLights[idx].color = m_lights[idx].color;
+			m_glslPointLights[idx].attenuation.x = m_lights[idx].attenuationK;
+			m_glslPointLights[idx].attenuation.y = m_lights[idx].attenuationL;
+			m_glslPointLights[idx].attenuation.z = m_lights[idx].attenuationQ;
+			m_glslPointLights[idx].attenuation.w = std::max(LightClusterGrid::getLightRadius(m_lights[idx]), std::numeric_limits<float>::min());
+		}
+
+		if (!m_glslPointLights.empty())
+		{
+			reserveStorageBuffer(logicalDevice, storageBuffers[LightsBinding_PointLights], m_lightsDescriptorSets[frameInfo.index], LightsBinding_PointLights, sizeof(GLSLPointLight) * m_glslPointLights.size());
+			storageBuffers[LightsBinding_PointLights]->set(0, sizeof(GLSLPointLight) * m_glslPointLights.size(), m_glslPointLights.data());
+		}
+
+		// Cluster grid
+
+		const VkExtent2D vkExtent = swapchain.getImageExtent2D();
+
+		GLSLLightClusterGridInfo gridInfo{};
+		gridInfo.size[0] = LightClusterGrid::k_numClustersX;
+		gridInfo.size[1] = LightClusterGrid::k_numClustersY;
+		gridInfo.size[2] = LightClusterGrid::k_numClustersZ;
+		gridInfo.params = Vector4(m_lightClusterGrid.getDepthSliceScale(), m_lightClusterGrid.getDepthSliceBias(), 1.0f / vkExtent.width, 1.0f / vkExtent.height);
+
+		const auto & clusters = m_lightClusterGrid.getClusters();
+		storageBuffers[LightsBinding_Clusters]->set(0, sizeof(GLSLLightClusterGridInfo), &gridInfo);
+		storageBuffers[LightsBinding_Clusters]->set(sizeof(GLSLLightClusterGridInfo), sizeof(LightClusterGrid::Cluster) * clusters.size(), const_cast<LightClusterGrid::Cluster *>(clusters.data()));
+
+		// Light indices of every cluster
+
+		const auto & lightIndices = m_lightClusterGrid.getLightIndices();
+		if (!lightIndices.empty())
+		{
+			reserveStorageBuffer(logicalDevice, storageBuffers[LightsBinding_LightIndices], m_lightsDescriptorSets[frameInfo.index], LightsBinding_LightIndices, sizeof(uint32_t) * lightIndices.size());
+			storageBuffers[LightsBinding_LightIndices]->set(0, sizeof(uint32_t) * lightIndices.size(), const_cast<uint32_t *>(lightIndices.data()));
+		}
+	}
+
+	void VulkanForwardRenderer::prepareDraw(const VulkanSwapchain & swapchain, const Camera & camera)
 	{
 		const VulkanSwapchain::FrameInfo &frameInfo = swapchain.getCurrentFrameInfo();
 		auto & frameSamplerDescriptorSets = m_samplerDescriptorSets[frameInfo.index];
@@ -150,40 +211,52 @@ namespace mud::graphics_backend::vk
 		m_descriptorSetManager->doFrees();
 		frameSamplerDescriptorSets.clear();
 		
-		std::sort(m_commands.begin(), m_commands.end());
+		// Commands sharing a material and mesh end up next to each other, and are drawn as instances of one draw call
+		sortCommands(camera);
 
-		m_ubos.resize(m_commands.size());
-		const Material * lastMaterial = nullptr;
+		m_objects.resize(m_commands.size());
+		m_drawBatches.clear();
 		
 		const ShaderModule * fragmentShaderModule = m_renderPass->getSubpasses()[0]->getShaderModule(ShaderType::Fragment);
+		const RenderCommand * previousCommand = nullptr;
 
-		for (size_t idx = 0; idx < m_commands.size(); ++idx)
+		for (size_t idx = 0; idx < m_sortedCommands.size(); ++idx)
 		{
-			RenderCommand & command = m_commands[idx];
+			const RenderCommand & command = m_commands[m_sortedCommands[idx].value];
 			
-			m_ubos[idx].model = m_commands[idx].transform;
-			m_ubos[idx].data[0] = m_commands[idx].material->baseColor;
+			m_objects[idx].model = command.transform;
+			m_objects[idx].data[0] = command.material->baseColor;
+
+			// Keys of different materials or meshes can collide once their ids wrap, so the pointers decide batches
+			const bool isSameMaterial = previousCommand != nullptr && command.material == previousCommand->material;
+			const bool isSameMesh = previousCommand != nullptr && command.mesh == previousCommand->mesh &&
+				command.firstIndex == previousCommand->firstIndex && command.numIndices == previousCommand->numIndices;
+			previousCommand = &command;
+
+			if (isSameMaterial && isSameMesh)
+			{
+				++m_drawBatches.back().numInstances;
+				continue;
+			}
 
-			if (command.material != lastMaterial)
+			if (!isSameMaterial)
 			{
 				VulkanDescriptorSet * descriptorSet = m_descriptorSetManager->allocate(*fragmentShaderModule->getDescriptorSetLayouts()[1]);
 				bindMaterialToDescriptorSets(descriptorSet, command.material);
 				frameSamplerDescriptorSets.emplace_back(command.material, descriptorSet);
-				lastMaterial = command.material;
 			}
-		}
 
-		m_uboLights.num = static_cast<uint32_t>(m_lights.size());
-		for (size_t idx = 0; idx < m_lights.size(); ++idx)
-		{
-			m_uboLights.lights[idx].position = m_lights[idx].position;
-			m_uboLights.lights[idx].color = m_lights[idx].color;
-			m_uboLights.lights[idx].attenuation.x = m_lights[idx].attenuationK;
-			m_uboLights.lights[idx].attenuation.y = m_lights[idx].attenuationL;
-			m_uboLights.lights[idx].attenuation.z = m_lights[idx].attenuationQ;
-			m_uboLights.lights[idx].attenuation.w = 0.0f; // padding
+			// A command without a range draws all of its mesh's indices, or vertices if it has none
+			const uint32_t numIndices = command.numIndices != 0 ? command.numIndices :
+				static_cast<uint32_t>(command.mesh->getIndices().empty() ? command.mesh->getVertices().size() : command.mesh->getIndices().size());
+
+			m_drawBatches.push_back(DrawBatch{ command.mesh, frameSamplerDescriptorSets.back().second, command.firstIndex, numIndices, static_cast<uint32_t>(idx), 1 });
 		}
-		m_uniformBuffersLights[frameInfo.index]->set(0, sizeof(UBO_Lights), &m_uboLights);
+
+		reserveStorageBuffer(*swapchain.getLogicalDevice(), m_storageBuffersObjects[frameInfo.index], m_objectsDescriptorSets[frameInfo.index], 0, sizeof(GLSLObject) * m_objects.size());
+		m_storageBuffersObjects[frameInfo.index]->set(0, sizeof(GLSLObject) * m_objects.size(), m_objects.data());
+
+		prepareLights(swapchain, camera);
 
 		m_descriptorSetManager->doAllocates();
 		m_descriptorSetManager->doUpdates();
@@ -200,7 +273,7 @@ namespace mud::graphics_backend::vk
 		VulkanSwapchain & swapchain = context->getMainWindow()->getGraphicsContext().getSwapchain();
 		const VulkanSwapchain::FrameInfo & frameInfo = swapchain.getCurrentFrameInfo();
 
-		prepareDraw(swapchain);
+		prepareDraw(swapchain, camera);
 
 		// Push constants
 
@@ -232,60 +305,45 @@ namespace mud::graphics_backend::vk
 			static_cast<uint32_t>(fragmentShaderPushConstants->getSize()),
 			fragmentShaderPushConstants->getData());
 
-		// Fill uniform buffer
+		const VulkanDescriptorSet * lastMaterialDescriptorSet = nullptr;
 
-		m_uniformBuffers[frameInfo.index]->set(0, sizeof(UBO_PerObject) * m_ubos.size(), m_ubos.data());
-
-		const Material * lastMaterial = nullptr;
-
-		size_t commandIdx = 0;
-		for (; commandIdx < m_commands.size(); ++commandIdx)
+		for (const DrawBatch & batch : m_drawBatches)
 		{
-			const RenderCommand &command = m_commands[commandIdx];
-
 			// Vertex buffer
 
-			const Mesh *mesh = command.mesh;
+			const Mesh *mesh = batch.mesh;
 
 			VkBuffer vertexBuffers[] = {mesh->getVertexBuffer()->getVulkanHandle()};
 			VkDeviceSize offsets[] = {0};
 			vkCmdBindVertexBuffers(frameInfo.commandBuffer, 0, 1, vertexBuffers, offsets);
 
-			// Descriptor sets
+			// Descriptor sets, bound from the first set on, so only when the material changes. The objects and lights
+			// sets are the same for the whole frame.
 
-			uint32_t dynamicOffset = commandIdx * sizeof(UBO_PerObject);
-			m_descriptorSetManager->bind(m_uboDescriptorSets[frameInfo.index], dynamicOffset);
-			m_descriptorSetManager->bind(m_lightsDescriptorSets[frameInfo.index], 0);
-
-			if (command.material != lastMaterial)
+			if (batch.materialDescriptorSet != lastMaterialDescriptorSet)
 			{
-				for (const auto & pair : m_samplerDescriptorSets[frameInfo.index])
-					if (pair.first == command.material)
-					{
-						m_descriptorSetManager->bind(pair.second);
-						break;
-					}
-
-				lastMaterial = command.material;
-			}
+				m_descriptorSetManager->bind(m_objectsDescriptorSets[frameInfo.index]);
+				m_descriptorSetManager->bind(m_lightsDescriptorSets[frameInfo.index]);
+				m_descriptorSetManager->bind(batch.materialDescriptorSet);
+				m_descriptorSetManager->doBinds(frameInfo.commandBuffer, m_renderPass->getSubpasses()[0]->getPipelineLayout());
 
-			m_descriptorSetManager->doBinds(frameInfo.commandBuffer, m_renderPass->getSubpasses()[0]->getPipelineLayout());
+				lastMaterialDescriptorSet = batch.materialDescriptorSet;
+			}
 
-			// DRAW!
+			// DRAW! The instance index picks each instance's object data
 
 			if (mesh->getIndices().empty())
 			{
-				vkCmdDraw(frameInfo.commandBuffer, mesh->getVertices().size(), 1, 0, 0);
+				vkCmdDraw(frameInfo.commandBuffer, batch.numIndices, batch.numInstances, batch.firstIndex, batch.firstInstance);
 			}
 			else
 			{
 				vkCmdBindIndexBuffer(frameInfo.commandBuffer, mesh->getIndexBuffer()->getVulkanHandle(), 0, VK_INDEX_TYPE_UINT32);
-				vkCmdDrawIndexed(frameInfo.commandBuffer, static_cast<uint32_t>(mesh->getIndices().size()), 1, 0, 0, 0);
+				vkCmdDrawIndexed(frameInfo.commandBuffer, batch.numIndices, batch.numInstances, batch.firstIndex, 0, batch.firstInstance);
 			}
 		}
 
-		m_commands.erase(m_commands.begin(), m_commands.begin() + commandIdx);
-		m_ubos.erase(m_ubos.begin(), m_ubos.begin() + commandIdx);
+		m_commands.clear();
 		m_lights.clear();
 
 		m_renderPass->end();
@@ -8,6 +8,7 @@
 #include <vulkan/vulkan.h>
 
 #include "graphics/interface/forward_renderer_base.hpp"
+#include "graphics/light_clusters.hpp"
 #include "graphics/material.hpp"
 #include "internal/vulkan_descriptor_set.hpp"
 #include "math/matrix.hpp"
@@ -29,12 +30,24 @@ namespace mud::graphics_backend::vk
 
 	private:
 
-		struct UBO_PerObject
+		// Per instance data, read by the vertex shader at gl_InstanceIndex
+		struct GLSLObject
 		{
 			Matrix4 model;
 			Matrix4 data;
 		};
 
+		// Consecutive commands sharing a mesh, index range and material, drawn with a single instanced draw call
+		struct DrawBatch
+		{
+			const Mesh * mesh;
+			VulkanDescriptorSet * materialDescriptorSet;
+			uint32_t firstIndex;
+			uint32_t numIndices;
+			uint32_t firstInstance;
+			uint32_t numInstances;
+		};
+
 		struct GLSLPointLight
 		{
 			Vector4 position;
@@ -48,20 +61,35 @@ namespace mud::graphics_backend::vk
 			Vector4 color;
 		};	
 
-		struct UBO_Lights
+		struct GLSLLightClusterGridInfo
+		{
+			uint32_t size[4];
+			Vector4 params;
+		};
+
+		// Bindings of the storage buffers in the fragment shader's lights descriptor set
+		enum LightsBinding : uint32_t
 		{
-			GLSLPointLight lights[256];
-			uint32_t num;
+			LightsBinding_PointLights,
+			LightsBinding_Clusters,
+			LightsBinding_LightIndices,
+			LightsBinding_Count
 		};
 
 		VulkanDescriptorSetManager * m_descriptorSetManager;
 
-		std::vector<UBO_PerObject> m_ubos;
-		std::vector<VulkanBuffer *> m_uniformBuffers;
-		std::vector<VulkanDescriptorSet *> m_uboDescriptorSets;
+		std::vector<GLSLObject> m_objects;
+		std::vector<DrawBatch> m_drawBatches;
+
+		// Per swapchain image, grown to fit the frame's objects
+		std::vector<VulkanBuffer *> m_storageBuffersObjects;
+		std::vector<VulkanDescriptorSet *> m_objectsDescriptorSets;
+
+		LightClusterGrid m_lightClusterGrid;
+		std::vector<GLSLPointLight> m_glslPointLights;
 
-		UBO_Lights m_uboLights;
-		std::vector<VulkanBuffer *> m_uniformBuffersLights;
+		// Per swapchain image, grown to fit the frame's lights
+		std::vector<std::array<VulkanBuffer *, LightsBinding_Count>> m_storageBuffersLights;
 		std::vector<VulkanDescriptorSet *> m_lightsDescriptorSets;
 
 		std::vector<VkSampler> m_vkTextureSamplers;
@@ -72,7 +100,13 @@ namespace mud::graphics_backend::vk
 
 		void bindMaterialToDescriptorSets(VulkanDescriptorSet * descriptorSets, const Material * material);
 
-		void prepareDraw(const VulkanSwapchain & swapchain);
+		// Replaces the storage buffer with a larger one when it holds less than size bytes, pointing the descriptor set's
+		// binding at the new buffer
+		void reserveStorageBuffer(const VulkanLogicalDevice & logicalDevice, VulkanBuffer *& storageBuffer, VulkanDescriptorSet * descriptorSet, uint32_t binding, size_t size);
+
+		void prepareLights(const VulkanSwapchain & swapchain, const Camera & camera);
+
+		void prepareDraw(const VulkanSwapchain & swapchain, const Camera & camera);
 	};
 }
 
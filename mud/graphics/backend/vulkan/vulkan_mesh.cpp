@@ -67,6 +67,10 @@ namespace mud::graphics_backend::vk
 	{
 		VulkanApplicationGraphicsContext * vulkan = VulkanApplicationGraphicsContext::getInstance();
 
+		// Headless (no graphics context, eg. offline tools): keep the CPU side data only
+		if (vulkan == nullptr)
+			return;
+
 		size_t bufferSize = sizeof(m_vertices[0]) * m_vertices.size();
 
 		if (m_vertexBuffer == nullptr || m_vertexBuffer->getSize() != bufferSize)
@@ -5,6 +5,7 @@
 #include "internal/vulkan_debug.hpp"
 #include "internal/vulkan_helpers.hpp"
 #include "internal/vulkan_logical_device.hpp"
+#include "internal/vulkan_pipeline_cache.hpp"
 #include "internal/vulkan_swapchain.hpp"
 #include "utils/logger.hpp"
 #include "vulkan_application_graphics_context.hpp"
@@ -205,7 +206,7 @@ namespace mud::graphics_backend::vk
 
 			log(LogLevel::Trace, "Creating render subpass pipeline...\n", "Vulkan");
 
-			MUD__checkVulkanCall(vkCreateGraphicsPipelines(m_swapchain->getLogicalDevice()->getVulkanHandle(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_vkSubpassPipelines[idx]), "Failed to create graphics pipeline");
+			vulkanContext->getPipelineCache().createGraphicsPipeline(pipelineInfo, m_vkSubpassPipelines[idx]);
 		}
 		
 		m_swapchain->createRenderPassFramebuffers(m_vkFramebuffers, m_vkRenderPass);
@@ -1,5 +1,6 @@
 #include "vulkan_shader_module.hpp"
 
+#include <algorithm>
 #include <spirv_cross/spirv_glsl.hpp>
 
 #include "graphics/backend/spirv/spirv.hpp"
@@ -155,6 +156,12 @@ namespace mud::graphics_backend::vk
 			std::vector<SpvReflectInterfaceVariable *> inputVariables(count);
 			result = spvReflectEnumerateInputVariables(&module, &count, inputVariables.data());
 
+			// Built-in inputs such as gl_FragCoord have no location
+			inputVariables.erase(std::remove_if(inputVariables.begin(), inputVariables.end(), [](const SpvReflectInterfaceVariable * variable) {
+				return (variable->decoration_flags & SPV_REFLECT_DECORATION_BUILT_IN) != 0;
+			}), inputVariables.end());
+			count = static_cast<uint32_t>(inputVariables.size());
+
 			m_inputVariableDetails.resize(count);
 			for (size_t idx = 0; idx < count; ++idx)
 			{
@@ -125,36 +125,33 @@ namespace mud::graphics_backend::vk
 				indices[spriteIdx * 6 + 4] = last + 1;
 				indices[spriteIdx * 6 + 5] = last + 3;
 
-				vIter->position.x = 0; // left top
-				vIter->position.y = 0;
+				// The corners of the unit quad transform to the translation plus the X and/or Y axes, no multiplies needed
+				const Vector3 origin(command.transform[3]);
+				const Vector3 xAxis(command.transform[0]);
+				const Vector3 yAxis(command.transform[1]);
+
+				vIter->position = origin; // left top
 				vIter->colour = command.color;
 				vIter->textureCoordinates.x = 0;
 				vIter->textureCoordinates.y = 0;
-				vIter->position = Vector3(command.transform * Vector4(vIter->position, 1.0f));
 
 				vIter++;
-				vIter->position.x = 0; // left bottom
-				vIter->position.y = 1.0f;
+				vIter->position = origin + yAxis; // left bottom
 				vIter->colour = command.color;
 				vIter->textureCoordinates.x = 0;
 				vIter->textureCoordinates.y = 1;
-				vIter->position = Vector3(command.transform * Vector4(vIter->position, 1.0f));
 
 				vIter++;
-				vIter->position.x = 1.0f; // right top
-				vIter->position.y = 0;
+				vIter->position = origin + xAxis; // right top
 				vIter->colour = command.color;
 				vIter->textureCoordinates.x = 1;
 				vIter->textureCoordinates.y = 0;
-				vIter->position = Vector3(command.transform * Vector4(vIter->position, 1.0f));
 
 				vIter++;
-				vIter->position.x = 1.0f; // right bottom
-				vIter->position.y = 1.0f;
+				vIter->position = origin + xAxis + yAxis; // right bottom
 				vIter->colour = command.color;
 				vIter->textureCoordinates.x = 1;
 				vIter->textureCoordinates.y = 1;
-				vIter->position = Vector3(command.transform * Vector4(vIter->position, 1.0f));
 
 				spriteIdx++;
 			}
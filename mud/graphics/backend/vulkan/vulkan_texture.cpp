@@ -15,7 +15,8 @@ namespace mud::graphics_backend::vk
 
 	VulkanTexture::~VulkanTexture()
 	{
-		vkDestroyImageView(m_logicalDevice->getVulkanHandle(), m_vkImageView, nullptr);
+		if (m_logicalDevice != nullptr)
+			vkDestroyImageView(m_logicalDevice->getVulkanHandle(), m_vkImageView, nullptr);
 		delete m_image;
 	}
 
@@ -30,7 +31,13 @@ namespace mud::graphics_backend::vk
 			return;
 
 		if (m_logicalDevice == nullptr)
+		{
+			// Headless (no graphics context, eg. offline tools): keep the CPU side data only
+			if (VulkanApplicationGraphicsContext::getInstance() == nullptr)
+				return;
+
 			m_logicalDevice = &VulkanApplicationGraphicsContext::getInstance()->getLogicalDevice();
+		}
 
 		VulkanBuffer stagingBuffer(*m_logicalDevice, m_sizeBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 		stagingBuffer.set(0, m_sizeBytes, m_data);
@@ -52,8 +59,10 @@ namespace mud::graphics_backend::vk
 	{
 		TextureBase::freeData();
 
-		vkDestroyImageView(m_logicalDevice->getVulkanHandle(), m_vkImageView, nullptr);
+		if (m_logicalDevice != nullptr)
+			vkDestroyImageView(m_logicalDevice->getVulkanHandle(), m_vkImageView, nullptr);
 		m_vkImageView = VK_NULL_HANDLE;
 		delete m_image;
+		m_image = nullptr;
 	}
 }
\ No newline at end of file
@@ -6,7 +6,7 @@
 namespace mud
 {
 	Camera::Camera()
-		: m_position(0), m_forward(Vector3::negZ), m_right(Vector3::posX), m_up(Vector3::posY), m_zNear(0), m_zFar(0), m_orientation(Quaternion::identity), m_projection(Matrix4::identity), m_view(Matrix4::identity), m_dirtyView(false)
+		: m_position(0), m_forward(Vector3::negZ), m_right(Vector3::posX), m_up(Vector3::posY), m_zNear(0), m_zFar(0), m_orientation(Quaternion::identity), m_projection(Matrix4::identity), m_inverseProjection(Matrix4::identity), m_view(Matrix4::identity), m_dirtyView(false)
 	{}
 
 	const Vector3 & Camera::getPosition() const
@@ -80,9 +80,15 @@ namespace mud
 		return getProjectionMatrix() * getViewMatrix();
 	}
 
+	Matrix4 Camera::getInverseProjectionViewMatrix() const
+	{
+		return inverseRigid(getViewMatrix()) * m_inverseProjection;
+	}
+
 	void Camera::setPerspective(float verticalFOV, float aspectRatio, float zNear, float zFar)
 	{
 		m_projection = perspective(_TAU_DIV_360 * verticalFOV, aspectRatio, zNear, zFar);
+		m_inverseProjection = m_projection.inverse();
 		m_aspectRatio = aspectRatio;
 		m_zNear = zNear;
 		m_zFar = zFar;
@@ -93,6 +99,7 @@ namespace mud
 		const float halfWidth = width * 0.5f;
 		const float halfHeight = height * 0.5f;
 		m_projection = orthographic(-halfWidth, halfWidth, -halfHeight, halfHeight, zNear, zFar);
+		m_inverseProjection = m_projection.inverse();
 		m_aspectRatio = width / height;
 		m_zNear = zNear;
 		m_zFar = zFar;
@@ -36,6 +36,9 @@ namespace mud
 
 		Matrix4 getProjectionViewMatrix();
 
+		// Cheaper than inverting getProjectionViewMatrix(), the view is rigid and the projection inverse is cached
+		Matrix4 getInverseProjectionViewMatrix() const;
+
 		void setPerspective(float verticalFOV, float aspectRatio, float zNear, float zFar);
 
 		void setOrthographic(float width, float height, float zNear, float zFar);
@@ -56,6 +59,7 @@ namespace mud
 		float m_zFar;
 		Quaternion m_orientation;
 		Matrix4 m_projection;
+		Matrix4 m_inverseProjection;
 		mutable Matrix4 m_view;
 		mutable bool m_dirtyView;
 	};
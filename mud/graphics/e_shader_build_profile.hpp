@@ -0,0 +1,16 @@
+#ifndef E_SHADER_BUILD_PROFILE
+#define E_SHADER_BUILD_PROFILE
+
+namespace mud
+{
+    enum class ShaderBuildProfile
+    {
+        // No optimization, debug info retained for graphics debuggers
+        Debug,
+
+        // spirv-opt performance recipe (-O, including dead code elimination), debug info stripped
+        Performance
+    };
+}
+
+#endif
@@ -1,26 +1,24 @@
 #include "deferred_renderer_base.hpp"
 
-#include "utils/file_io.hpp"
-
 namespace mud
 {
 	DeferredRendererBase::DeferredRendererBase(RenderPassOptions renderPassOptions)
 		: m_directionalLight{ Vector3(1, -3, 2).normal(), Color::white }
 	{
 		m_shaderModules.push_back(new ShaderModule(ShaderType::Vertex));
-		m_shaderModules.back()->setSource(file::readText("./../mud/graphics/shaders/deferred_geometry.vert"));
+		m_shaderModules.back()->loadSource("./../mud/graphics/shaders/deferred_geometry.vert");
 		m_shaderModules.back()->compileSource();
 		
 		m_shaderModules.push_back(new ShaderModule(ShaderType::Fragment));
-		m_shaderModules.back()->setSource(file::readText("./../mud/graphics/shaders/deferred_geometry"));
+		m_shaderModules.back()->loadSource("./../mud/graphics/shaders/deferred_geometry");
 		m_shaderModules.back()->compileSource();
         
 		m_shaderModules.push_back(new ShaderModule(ShaderType::Vertex));
-		m_shaderModules.back()->setSource(file::readText("./../mud/graphics/shaders/deferred_lighting.vert"));
+		m_shaderModules.back()->loadSource("./../mud/graphics/shaders/deferred_lighting.vert");
 		m_shaderModules.back()->compileSource();
 		
 		m_shaderModules.push_back(new ShaderModule(ShaderType::Fragment));
-		m_shaderModules.back()->setSource(file::readText("./../mud/graphics/shaders/deferred_lighting"));
+		m_shaderModules.back()->loadSource("./../mud/graphics/shaders/deferred_lighting");
 		m_shaderModules.back()->compileSource();
         
         std::vector<ShaderModule *> geometryPassShaderModules {
@@ -60,6 +58,16 @@ namespace mud
 		m_lights.push_back(light);
 	}
 
+	void DeferredRendererBase::submit(const RenderCommand * commands, size_t numCommands)
+	{
+		m_commands.insert(m_commands.end(), commands, commands + numCommands);
+	}
+
+	void DeferredRendererBase::submit(const PointLight * lights, size_t numLights)
+	{
+		m_lights.insert(m_lights.end(), lights, lights + numLights);
+	}
+
 	const DirectionalLight & DeferredRendererBase::getDirectionalLight() const
 	{
 		return m_directionalLight;
@@ -18,7 +18,12 @@ namespace mud
 		Matrix4 transform;
 		const Material * material;
 
-		bool operator <(const RenderCommand & rhs)
+		// Draws only this range of the mesh's indices, or of its vertices when it has none. The whole mesh when
+		// numIndices is 0.
+		uint32_t firstIndex = 0;
+		uint32_t numIndices = 0;
+
+		bool operator <(const RenderCommand & rhs) const
 		{
 			size_t textureAsInt = reinterpret_cast<size_t>(material);
 			size_t rhsTextureAsInt = reinterpret_cast<size_t>(rhs.material);
@@ -26,8 +31,8 @@ namespace mud
 			if (textureAsInt != rhsTextureAsInt)
 				return textureAsInt < rhsTextureAsInt;
 
-			size_t meshAsInt = reinterpret_cast<size_t>(material);
-			size_t rhsMeshAsInt = reinterpret_cast<size_t>(rhs.material);
+			size_t meshAsInt = reinterpret_cast<size_t>(mesh);
+			size_t rhsMeshAsInt = reinterpret_cast<size_t>(rhs.mesh);
 
 			return meshAsInt < rhsMeshAsInt;
 		}
@@ -47,6 +52,11 @@ namespace mud
 
 		virtual void submit(PointLight light);
 
+		// Appends many commands or lights at once, with a single call
+		virtual void submit(const RenderCommand * commands, size_t numCommands);
+
+		virtual void submit(const PointLight * lights, size_t numLights);
+
 		virtual void draw(const Camera & camera) = 0;
 
 		const DirectionalLight & getDirectionalLight() const;
@@ -1,18 +1,49 @@
 #include "forward_renderer_base.hpp"
 
-#include "utils/file_io.hpp"
+#include <algorithm>
+#include <cmath>
+
+#include "graphics/camera.hpp"
 
 namespace mud
 {
+	namespace
+	{
+		uint64_t toKeyField(uint32_t value, uint32_t numBits)
+		{
+			// Ids past the field's range wrap around. Commands then share keys with unrelated ones, which only costs
+			// batching, since batches are still split wherever the material or mesh actually changes.
+			return static_cast<uint64_t>(value) & ((uint64_t(1) << numBits) - 1);
+		}
+
+		// View depth quantised logarithmically between the near and far planes, so near objects get finer buckets. The
+		// logarithm needs a positive near plane, which orthographic cameras don't always have, and a range to divide by:
+		// depth is quantised linearly without the former and all commands share a bucket without the latter.
+		uint32_t getDepthBucket(float depth, float zNear, float zFar, uint32_t numBits)
+		{
+			if (!(zFar > zNear))
+				return 0;
+
+			const float maxBucket = static_cast<float>((uint32_t(1) << numBits) - 1);
+			const float t = zNear > 0.0f ? std::log(std::max(depth, zNear) / zNear) / std::log(zFar / zNear) : (depth - zNear) / (zFar - zNear);
+
+			// Also rejects NaN, from a NaN depth, which can't be converted to an integer
+			if (!(t > 0.0f))
+				return 0;
+
+			return static_cast<uint32_t>(std::min(t, 1.0f) * maxBucket);
+		}
+	}
+
 	ForwardRendererBase::ForwardRendererBase(RenderPassOptions renderPassOptions)
 		: m_directionalLight{ Vector3(1, -3, 2).normal(), Color::white }
 	{
 		m_shaderModules.push_back(new ShaderModule(ShaderType::Vertex));
-		m_shaderModules.back()->setSource(file::readText("./../mud/graphics/shaders/forward.vert"));
+		m_shaderModules.back()->loadSource("./../mud/graphics/shaders/forward.vert");
 		m_shaderModules.back()->compileSource();
 		
 		m_shaderModules.push_back(new ShaderModule(ShaderType::Fragment));
-		m_shaderModules.back()->setSource(file::readText("./../mud/graphics/shaders/pbr.frag"));
+		m_shaderModules.back()->loadSource("./../mud/graphics/shaders/pbr.frag");
 		m_shaderModules.back()->compileSource();
 
 		std::vector<FrameBufferAttachmentInfo> frameBufferAttachmentsInfo;
@@ -40,6 +71,42 @@ namespace mud
 		m_lights.push_back(light);
 	}
 
+	void ForwardRendererBase::submit(const RenderCommand * commands, size_t numCommands)
+	{
+		m_commands.insert(m_commands.end(), commands, commands + numCommands);
+	}
+
+	void ForwardRendererBase::submit(const PointLight * lights, size_t numLights)
+	{
+		m_lights.insert(m_lights.end(), lights, lights + numLights);
+	}
+
+	void ForwardRendererBase::sortCommands(const Camera & camera)
+	{
+		const Matrix4 & view = camera.getViewMatrix();
+
+		// Every command is drawn with the same pipeline for now
+		const uint32_t pipelineId = 0;
+
+		m_sortedCommands.resize(m_commands.size());
+		m_sortScratch.resize(m_commands.size());
+
+		for (size_t idx = 0; idx < m_commands.size(); ++idx)
+		{
+			const RenderCommand & command = m_commands[idx];
+			const float depth = -(view * command.transform[3]).z;
+
+			uint64_t key = toKeyField(pipelineId, k_sortKeyPipelineBits);
+			key = (key << k_sortKeyMaterialBits) | toKeyField(command.material->getRuntimeId(), k_sortKeyMaterialBits);
+			key = (key << k_sortKeyMeshBits) | toKeyField(command.mesh->getRuntimeId(), k_sortKeyMeshBits);
+			key = (key << k_sortKeyDepthBits) | getDepthBucket(depth, camera.getZNear(), camera.getZFar(), k_sortKeyDepthBits);
+
+			m_sortedCommands[idx] = RadixSortItem{ key, static_cast<uint32_t>(idx) };
+		}
+
+		radixSort(m_sortedCommands.data(), m_sortScratch.data(), m_sortedCommands.size());
+	}
+
 	const DirectionalLight & ForwardRendererBase::getDirectionalLight() const
 	{
 		return m_directionalLight;
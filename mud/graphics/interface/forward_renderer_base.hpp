@@ -9,6 +9,7 @@
 #include "graphics/render_pass.hpp"
 #include "graphics/texture.hpp"
 #include "math/matrix.hpp"
+#include "utils/radix_sort.hpp"
 
 namespace mud
 {
@@ -18,7 +19,12 @@ namespace mud
 		Matrix4 transform;
 		const Material * material;
 
-		bool operator <(const RenderCommand & rhs)
+		// Draws only this range of the mesh's indices, or of its vertices when it has none. The whole mesh when
+		// numIndices is 0.
+		uint32_t firstIndex = 0;
+		uint32_t numIndices = 0;
+
+		bool operator <(const RenderCommand & rhs) const
 		{
 			size_t textureAsInt = reinterpret_cast<size_t>(material);
 			size_t rhsTextureAsInt = reinterpret_cast<size_t>(rhs.material);
@@ -26,8 +32,8 @@ namespace mud
 			if (textureAsInt != rhsTextureAsInt)
 				return textureAsInt < rhsTextureAsInt;
 
-			size_t meshAsInt = reinterpret_cast<size_t>(material);
-			size_t rhsMeshAsInt = reinterpret_cast<size_t>(rhs.material);
+			size_t meshAsInt = reinterpret_cast<size_t>(mesh);
+			size_t rhsMeshAsInt = reinterpret_cast<size_t>(rhs.mesh);
 
 			return meshAsInt < rhsMeshAsInt;
 		}
@@ -47,6 +53,11 @@ namespace mud
 
 		virtual void submit(PointLight light);
 
+		// Appends many commands or lights at once, with a single call
+		virtual void submit(const RenderCommand * commands, size_t numCommands);
+
+		virtual void submit(const PointLight * lights, size_t numLights);
+
 		virtual void draw(const Camera & camera) = 0;
 
 		const DirectionalLight & getDirectionalLight() const;
@@ -55,11 +66,27 @@ namespace mud
 
 	protected:
 
+		// Sort key bit layout, from the most significant bits down: | pipeline | material | mesh | depth |
+		static constexpr uint32_t k_sortKeyPipelineBits = 4;
+		static constexpr uint32_t k_sortKeyMaterialBits = 20;
+		static constexpr uint32_t k_sortKeyMeshBits = 20;
+		static constexpr uint32_t k_sortKeyDepthBits = 20;
+		static_assert(k_sortKeyPipelineBits + k_sortKeyMaterialBits + k_sortKeyMeshBits + k_sortKeyDepthBits == 64);
+
+		// Orders m_commands by a packed 64-bit key per command, so that commands sharing a pipeline, then a material,
+		// then a mesh are adjacent, and each run of those is front to back. Only the keys and command indices are
+		// sorted, into m_sortedCommands; m_commands keeps its order.
+		void sortCommands(const Camera & camera);
+
 		std::vector<ShaderModule *> m_shaderModules;
 		RenderPass * m_renderPass;
 
 		std::vector<RenderCommand> m_commands;
 
+		// Values index m_commands, in draw order after sortCommands()
+		std::vector<RadixSortItem> m_sortedCommands;
+		std::vector<RadixSortItem> m_sortScratch;
+
 		DirectionalLight m_directionalLight;
 		std::vector<PointLight> m_lights;
 	};
@@ -6,11 +6,13 @@
 #include <fmt/format.h>
 #include <iterator>
 
+#include "math/intersection_test.hpp"
 #include "utils/logger.hpp"
 
 namespace mud
 {
 	MeshBase::MeshBase()
+		: m_isTriangleBVHBuilt(false)
 	{ }
 
 	MeshBase::MeshBase(const std::vector<MeshVertex> &vertices, const std::vector<uint32_t> & indices)
@@ -34,10 +36,82 @@ namespace mud
 		return m_boundingBox;
 	}
 
+	const TriangleBVH & MeshBase::getTriangleBVH() const
+	{
+		if (m_isTriangleBVHBuilt)
+			return m_triangleBVH;
+
+		std::lock_guard<std::mutex> lock(m_triangleBVHMutex);
+
+		if (!m_isTriangleBVHBuilt)
+		{
+			const size_t numTriangles = (m_indices.empty() ? m_vertices.size() : m_indices.size()) / 3;
+
+			std::vector<AABB> triangleBounds(numTriangles);
+			for (size_t idx = 0; idx < numTriangles; ++idx)
+			{
+				AABB & bounds = triangleBounds[idx] = AABB::empty;
+				for (size_t vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+				{
+					const Vector3 & position = m_vertices[m_indices.empty() ? idx * 3 + vertexIdx : m_indices[idx * 3 + vertexIdx]].position;
+					bounds.merge(AABB(position, position));
+				}
+			}
+
+			m_triangleBVH.build(triangleBounds);
+			m_isTriangleBVHBuilt = true;
+		}
+
+		return m_triangleBVH;
+	}
+
+	bool MeshBase::rayCast(const Vector3 & rayOrigin, const Vector3 & rayDirection, float & hitDistance) const
+	{
+		bool isHit = false;
+
+		getTriangleBVH().rayCast(rayOrigin, rayDirection, hitDistance, [&](uint32_t triangleIdx, float maxDistance) {
+			const size_t firstVertex = static_cast<size_t>(triangleIdx) * 3;
+			const Vector3 & p0 = m_vertices[m_indices.empty() ? firstVertex + 0 : m_indices[firstVertex + 0]].position;
+			const Vector3 & p1 = m_vertices[m_indices.empty() ? firstVertex + 1 : m_indices[firstVertex + 1]].position;
+			const Vector3 & p2 = m_vertices[m_indices.empty() ? firstVertex + 2 : m_indices[firstVertex + 2]].position;
+
+			if ((p0 - p1).cross(p0 - p2).dot(rayDirection) >= 0)
+				return maxDistance;
+
+			const RayCastResult result = intersection_test::rayCastTriangle(rayOrigin, rayDirection, p0, p1, p2);
+			if (!result.isIntersection || result.distance >= maxDistance)
+				return maxDistance;
+
+			hitDistance = result.distance;
+			isHit = true;
+			return result.distance;
+		});
+
+		return isHit;
+	}
+
+	uint32_t MeshBase::rayCast(const RayPacket<8> & rays, float * hitDistances) const
+	{
+		uint32_t hitMask = 0;
+
+		getTriangleBVH().rayCast(rays, hitDistances, [&](uint32_t triangleIdx) {
+			const size_t firstVertex = static_cast<size_t>(triangleIdx) * 3;
+			const Vector3 & p0 = m_vertices[m_indices.empty() ? firstVertex + 0 : m_indices[firstVertex + 0]].position;
+			const Vector3 & p1 = m_vertices[m_indices.empty() ? firstVertex + 1 : m_indices[firstVertex + 1]].position;
+			const Vector3 & p2 = m_vertices[m_indices.empty() ? firstVertex + 2 : m_indices[firstVertex + 2]].position;
+
+			hitMask |= intersection_test::rayCastTriangle(rays, p0, p1, p2, hitDistances, true);
+		});
+
+		return hitMask;
+	}
+
 	void MeshBase::setData(const std::vector<MeshVertex> & vertices, const std::vector<uint32_t> & indices)
 	{
 		m_vertices = vertices;
 		m_indices = indices;
+		m_triangleBVH.clear();
+		m_isTriangleBVHBuilt = false;
 		recalculateBoundingBox();
 		onSetData();
 	}
@@ -47,6 +121,24 @@ namespace mud
 		if (!serialization_helpers::deserializeVector(file, m_vertices) || !serialization_helpers::deserializeVector(file, m_indices))
 			return false;
 
+		// The triangle hierarchy is an optional trailing section, meshes saved without one build it on first use
+		m_isTriangleBVHBuilt = false;
+		m_triangleBVH.clear();
+		if (file.peek() != std::ifstream::traits_type::eof())
+		{
+			if (!m_triangleBVH.deserialize(file))
+				return false;
+
+			// A hierarchy that doesn't match the mesh would read out of bounds when traversed, rebuild it on first use
+			if (m_triangleBVH.isValid((m_indices.empty() ? m_vertices.size() : m_indices.size()) / 3))
+				m_isTriangleBVHBuilt = true;
+			else
+			{
+				log(LogLevel::Warning, "Failed to load the mesh triangle hierarchy: It doesn't match the mesh, it will be rebuilt\n", "Asset");
+				m_triangleBVH.clear();
+			}
+		}
+
 		recalculateBoundingBox();
 		onSetData();
 
@@ -56,7 +148,8 @@ namespace mud
 	bool MeshBase::serialize(std::ofstream & file) const
 	{
 		return serialization_helpers::serializeVector(file, m_vertices) &&
-			serialization_helpers::serializeVector(file, m_indices);
+			serialization_helpers::serializeVector(file, m_indices) &&
+			getTriangleBVH().serialize(file);
 	}
 
 	void MeshBase::recalculateBoundingBox()
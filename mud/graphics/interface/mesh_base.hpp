@@ -1,10 +1,13 @@
 #ifndef MESH_BASE_HPP
 #define MESH_BASE_HPP
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "math/aabb.hpp"
+#include "math/triangle_bvh.hpp"
 #include "math/vector.hpp"
 #include "utils/asset_object.hpp"
 
@@ -32,6 +35,15 @@ namespace mud
 
         const AABB & getBoundingBox() const;
 
+        // Triangle hierarchy used for ray queries, built on first use when it was not loaded with the mesh
+        const TriangleBVH & getTriangleBVH() const;
+
+        // Finds the nearest front-facing triangle hit closer than hitDistance, in units of the ray direction
+        bool rayCast(const Vector3 & rayOrigin, const Vector3 & rayDirection, float & hitDistance) const;
+
+        // Packet version of rayCast. Lowers hitDistances for the rays that hit and returns them as a bit mask.
+        uint32_t rayCast(const RayPacket<8> & rays, float * hitDistances) const;
+
         void setData(const std::vector<MeshVertex> & vertices, const std::vector<uint32_t> & indices = {});
 
         virtual bool deserialize(std::ifstream & file) override;
@@ -46,6 +58,12 @@ namespace mud
 
         AABB m_boundingBox;
 
+        mutable TriangleBVH m_triangleBVH;
+
+        mutable std::atomic<bool> m_isTriangleBVHBuilt;
+
+        mutable std::mutex m_triangleBVHMutex;
+
         virtual void onSetData() = 0;
 
         void recalculateBoundingBox();
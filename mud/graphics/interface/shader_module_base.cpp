@@ -1,11 +1,13 @@
 #include "shader_module_base.hpp"
 
+#include <filesystem>
 #include <sstream>
 
 #include <shaderc/shaderc.hpp>
 #include <spirv_cross/spirv_glsl.hpp>
 
 #include "graphics/backend/spirv/spirv.hpp"
+#include "utils/file_io.hpp"
 #include "utils/logger.hpp"
 
 namespace mud
@@ -168,8 +170,24 @@ namespace mud
 		return m_size;
 	}
 
+#ifdef NDEBUG
+	ShaderBuildProfile ShaderModuleBase::s_defaultBuildProfile = ShaderBuildProfile::Performance;
+#else
+	ShaderBuildProfile ShaderModuleBase::s_defaultBuildProfile = ShaderBuildProfile::Debug;
+#endif
+
+	ShaderBuildProfile ShaderModuleBase::getDefaultBuildProfile()
+	{
+		return s_defaultBuildProfile;
+	}
+
+	void ShaderModuleBase::setDefaultBuildProfile(ShaderBuildProfile profile)
+	{
+		s_defaultBuildProfile = profile;
+	}
+
 	ShaderModuleBase::ShaderModuleBase(ShaderType type)
-		: m_type(type)
+		: m_type(type), m_buildProfile(s_defaultBuildProfile), m_sourceName("mud shader")
 	{}
 
 	ShaderType ShaderModuleBase::getType() const
@@ -177,6 +195,16 @@ namespace mud
 		return m_type;
 	}
 
+	ShaderBuildProfile ShaderModuleBase::getBuildProfile() const
+	{
+		return m_buildProfile;
+	}
+
+	void ShaderModuleBase::setBuildProfile(ShaderBuildProfile profile)
+	{
+		m_buildProfile = profile;
+	}
+
 	const std::string & ShaderModuleBase::getSource() const
 	{
 		return m_source;
@@ -188,34 +216,40 @@ namespace mud
 		m_spirvByteCode.clear();
 	}
 
-	bool ShaderModuleBase::compileSource()
+	bool ShaderModuleBase::loadSource(const std::string & sourceFilepath)
 	{
-		shaderc::CompileOptions compileOptions;
-		compileOptions.SetOptimizationLevel(shaderc_optimization_level_zero);
-		compileOptions.SetGenerateDebugInfo();
+		m_sourceName = sourceFilepath;
 
-		shaderc_shader_kind kind;
-
-		switch (m_type)
+		if (m_buildProfile == ShaderBuildProfile::Performance)
 		{
-		case ShaderType::Vertex:
-			kind = shaderc_glsl_vertex_shader;
-			break;
-		case ShaderType::Fragment:
-			kind = shaderc_glsl_fragment_shader;
-			break;
-		}
+			const std::string blobFilepath = graphics_backend::spirv::getSPIRVBlobFilepath(sourceFilepath, m_buildProfile);
 
-		shaderc::Compiler compiler;
-		shaderc::SpvCompilationResult compilationResult = compiler.CompileGlslToSpv(m_source, kind, "mud shader", compileOptions);
+			std::error_code errorCode;
+			const bool blobIsUpToDate = std::filesystem::exists(blobFilepath, errorCode)
+				&& std::filesystem::last_write_time(blobFilepath, errorCode) >= std::filesystem::last_write_time(sourceFilepath, errorCode);
 
-		if (compilationResult.GetCompilationStatus() != shaderc_compilation_status_success)
-		{
-			log(LogLevel::Error, fmt::format("Failed to compile shader to SPIR-V: {0}", compilationResult.GetErrorMessage()), "SPIR-V");
-			return false;
+			std::vector<uint32_t> spirvByteCode;
+			if (blobIsUpToDate && file::readBinary(blobFilepath, spirvByteCode) && graphics_backend::spirv::isValidSPIRV(spirvByteCode))
+			{
+				m_source.clear();
+				m_spirvByteCode = std::move(spirvByteCode);
+				return true;
+			}
 		}
 
-		m_spirvByteCode = { compilationResult.cbegin(), compilationResult.cend() };
+		setSource(file::readText(sourceFilepath));
+
+		return !m_source.empty();
+	}
+
+	bool ShaderModuleBase::compileSource()
+	{
+		// Byte code is already present when a precompiled blob was loaded
+		if (m_spirvByteCode.empty())
+			m_spirvByteCode = graphics_backend::spirv::compileSourceToSPIRV(m_sourceName, m_type, m_source, m_buildProfile);
+
+		if (m_spirvByteCode.empty())
+			return false;
 
 		SpvReflectShaderModule module;
 		SpvReflectResult result = spvReflectCreateShaderModule(m_spirvByteCode.size() * sizeof(uint32_t), static_cast<void *>(m_spirvByteCode.data()), &module);
@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "graphics/e_shader_build_profile.hpp"
 #include "graphics/e_shader_type.hpp"
 
 namespace mud
@@ -59,14 +60,26 @@ namespace mud
 	{
 	public:
 
+		static ShaderBuildProfile getDefaultBuildProfile();
+
+		static void setDefaultBuildProfile(ShaderBuildProfile profile);
+
 		ShaderModuleBase(ShaderType type);
 
 		ShaderType getType() const;
 
+		ShaderBuildProfile getBuildProfile() const;
+
+		void setBuildProfile(ShaderBuildProfile profile);
+
 		const std::string & getSource() const;
 
 		void setSource(const std::string & source);
 
+		// Uses the precompiled SPIR-V blob next to the source file when building with the performance profile
+		// and the blob is up to date, otherwise reads the GLSL source to be compiled at runtime.
+		bool loadSource(const std::string & sourceFilepath);
+
 		virtual bool compileSource();
 
 		const std::vector<uint32_t> & getSpirvByteCode() const;
@@ -75,7 +88,11 @@ namespace mud
 
 	protected:
 
+		static ShaderBuildProfile s_defaultBuildProfile;
+
 		ShaderType m_type;
+		ShaderBuildProfile m_buildProfile;
+		std::string m_sourceName;
 		std::string m_source;
 		std::vector<uint32_t> m_spirvByteCode;
 		std::unordered_map<std::string, ShaderModulePushConstantBlockDetails> m_pushConstantBlocksDetails;
@@ -3,18 +3,16 @@
 #include <unordered_map>
 #include <vector>
 
-#include "utils/file_io.hpp"
-
 namespace mud
 {
 	TextRendererBase::TextRendererBase(RenderPassOptions renderPassOptions)
 	{
 		m_shaderModules.push_back(new ShaderModule(ShaderType::Vertex));
-		m_shaderModules.back()->setSource(file::readText("./../mud/graphics/shaders/text.vert"));
+		m_shaderModules.back()->loadSource("./../mud/graphics/shaders/text.vert");
 		m_shaderModules.back()->compileSource();
 		
 		m_shaderModules.push_back(new ShaderModule(ShaderType::Fragment));
-		m_shaderModules.back()->setSource(file::readText("./../mud/graphics/shaders/text.frag"));
+		m_shaderModules.back()->loadSource("./../mud/graphics/shaders/text.frag");
 		m_shaderModules.back()->compileSource();
 
 		std::vector<FrameBufferAttachmentInfo> frameBufferAttachmentsInfo;
@@ -0,0 +1,227 @@
+#include "light_clusters.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "math/vector/vector_2.hpp"
+#include "math/vector/vector_4.hpp"
+
+namespace mud
+{
+	namespace
+	{
+		uint32_t getClusterIdx(uint32_t x, uint32_t y, uint32_t z)
+		{
+			return (z * LightClusterGrid::k_numClustersY + y) * LightClusterGrid::k_numClustersX + x;
+		}
+
+		Vector3 unproject(const Matrix4 & inverseProjection, float x, float y, float z)
+		{
+			const Vector4 point = inverseProjection * Vector4(x, y, z, 1.0f);
+			return Vector3(point) / point.w;
+		}
+
+		// Tile range [first, last] covered by the normalised device coordinate range [min, max]
+		void getTileRange(float min, float max, uint32_t numTiles, uint32_t & first, uint32_t & last)
+		{
+			const float maxTile = static_cast<float>(numTiles - 1);
+			first = static_cast<uint32_t>(std::clamp(std::floor((min * 0.5f + 0.5f) * numTiles), 0.0f, maxTile));
+			last = static_cast<uint32_t>(std::clamp(std::floor((max * 0.5f + 0.5f) * numTiles), 0.0f, maxTile));
+		}
+
+		bool isSphereOverlappingAABB(const Vector3 & center, float radius, const AABB & aabb)
+		{
+			const Vector3 closestPoint(
+				std::clamp(center.x, aabb.min.x, aabb.max.x),
+				std::clamp(center.y, aabb.min.y, aabb.max.y),
+				std::clamp(center.z, aabb.min.z, aabb.max.z));
+
+			return (closestPoint - center).dot(closestPoint - center) <= radius * radius;
+		}
+	}
+
+	LightClusterGrid::LightClusterGrid()
+		: m_zNear(0), m_zFar(0), m_depthSliceScale(0), m_depthSliceBias(0), m_clusters(k_numClusters)
+	{ }
+
+	void LightClusterGrid::build(const Matrix4 & projection, const Matrix4 & view, float zNear, float zFar, const std::vector<PointLight> & lights)
+	{
+		if (m_clusterBounds.empty() || !(projection == m_projection) || zNear != m_zNear || zFar != m_zFar)
+			buildClusterBounds(projection, zNear, zFar);
+
+		m_clusterLightPairs.clear();
+
+		for (uint32_t lightIdx = 0; lightIdx < lights.size(); ++lightIdx)
+		{
+			const float radius = getLightRadius(lights[lightIdx]);
+			const Vector3 center = view * Vector4(lights[lightIdx].position, 1.0f);
+			const float depth = -center.z;
+
+			if (depth + radius < zNear || depth - radius > zFar)
+				continue;
+
+			const uint32_t firstSlice = getDepthSlice(std::max(depth - radius, zNear));
+			const uint32_t lastSlice = getDepthSlice(std::min(depth + radius, zFar));
+
+			// Screen tiles covered by the projected corners of the sphere's bounds. Corners behind the camera do not
+			// project sensibly, so spheres reaching past the near plane cover the whole screen.
+			uint32_t firstX = 0, lastX = k_numClustersX - 1;
+			uint32_t firstY = 0, lastY = k_numClustersY - 1;
+			const bool isInfinite = radius == std::numeric_limits<float>::infinity();
+
+			if (!isInfinite && depth - radius > zNear)
+			{
+				Vector2 min(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+				Vector2 max(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+
+				for (uint32_t corner = 0; corner < 8; ++corner)
+				{
+					const Vector4 clip = projection * Vector4(
+						center.x + ((corner & 1) ? radius : -radius),
+						center.y + ((corner & 2) ? radius : -radius),
+						center.z + ((corner & 4) ? radius : -radius),
+						1.0f);
+
+					min.x = std::min(min.x, clip.x / clip.w);
+					min.y = std::min(min.y, clip.y / clip.w);
+					max.x = std::max(max.x, clip.x / clip.w);
+					max.y = std::max(max.y, clip.y / clip.w);
+				}
+
+				getTileRange(min.x, max.x, k_numClustersX, firstX, lastX);
+
+				// Tile rows run from the top of the screen down, which is normalised device y = -1 in Vulkan, as in gl_FragCoord
+				getTileRange(min.y, max.y, k_numClustersY, firstY, lastY);
+			}
+
+			for (uint32_t z = firstSlice; z <= lastSlice; ++z)
+				for (uint32_t y = firstY; y <= lastY; ++y)
+					for (uint32_t x = firstX; x <= lastX; ++x)
+					{
+						const uint32_t clusterIdx = getClusterIdx(x, y, z);
+						if (isInfinite || isSphereOverlappingAABB(center, radius, m_clusterBounds[clusterIdx]))
+							m_clusterLightPairs.push_back({ clusterIdx, lightIdx });
+					}
+		}
+
+		// Group the light indices by cluster with a counting sort, keeping each cluster's lights in order
+		for (Cluster & cluster : m_clusters)
+			cluster = Cluster{ 0, 0 };
+
+		for (const auto & pair : m_clusterLightPairs)
+			++m_clusters[pair.first].numLights;
+
+		uint32_t firstLightIdx = 0;
+		for (Cluster & cluster : m_clusters)
+		{
+			cluster.firstLightIdx = firstLightIdx;
+			firstLightIdx += cluster.numLights;
+			cluster.numLights = 0;
+		}
+
+		m_lightIndices.resize(m_clusterLightPairs.size());
+		for (const auto & pair : m_clusterLightPairs)
+		{
+			Cluster & cluster = m_clusters[pair.first];
+			m_lightIndices[cluster.firstLightIdx + cluster.numLights++] = pair.second;
+		}
+	}
+
+	const std::vector<LightClusterGrid::Cluster> & LightClusterGrid::getClusters() const
+	{
+		return m_clusters;
+	}
+
+	const std::vector<uint32_t> & LightClusterGrid::getLightIndices() const
+	{
+		return m_lightIndices;
+	}
+
+	float LightClusterGrid::getDepthSliceScale() const
+	{
+		return m_depthSliceScale;
+	}
+
+	float LightClusterGrid::getDepthSliceBias() const
+	{
+		return m_depthSliceBias;
+	}
+
+	float LightClusterGrid::getLightRadius(const PointLight & light)
+	{
+		// Solves intensity / (K + L * d + Q * d^2) = k_minLightIntensity for d
+		const float intensity = std::max({ light.color.r, light.color.g, light.color.b });
+		const float k = light.attenuationK - intensity / k_minLightIntensity;
+
+		if (k >= 0.0f)
+			return 0.0f;
+
+		if (light.attenuationQ > 0.0f)
+			return (-light.attenuationL + std::sqrt(light.attenuationL * light.attenuationL - 4.0f * light.attenuationQ * k)) / (2.0f * light.attenuationQ);
+
+		if (light.attenuationL > 0.0f)
+			return -k / light.attenuationL;
+
+		return std::numeric_limits<float>::infinity();
+	}
+
+	void LightClusterGrid::buildClusterBounds(const Matrix4 & projection, float zNear, float zFar)
+	{
+		m_projection = projection;
+		m_zNear = zNear;
+		m_zFar = zFar;
+
+		const float logDepthRange = std::log(zFar / zNear);
+		m_depthSliceScale = k_numClustersZ / logDepthRange;
+		m_depthSliceBias = -static_cast<float>(k_numClustersZ) * std::log(zNear) / logDepthRange;
+
+		const Matrix4 inverseProjection = projection.inverse();
+
+		// The points of each tile corner's line of sight at the near and far planes, tile rows from the top down, which is
+		// normalised device y = -1 in Vulkan
+		std::vector<std::pair<Vector3, Vector3>> cornerLines((k_numClustersX + 1) * (k_numClustersY + 1));
+		for (uint32_t y = 0; y <= k_numClustersY; ++y)
+			for (uint32_t x = 0; x <= k_numClustersX; ++x)
+			{
+				const float ndcX = 2.0f * x / k_numClustersX - 1.0f;
+				const float ndcY = 2.0f * y / k_numClustersY - 1.0f;
+				cornerLines[y * (k_numClustersX + 1) + x] = { unproject(inverseProjection, ndcX, ndcY, -1.0f), unproject(inverseProjection, ndcX, ndcY, 1.0f) };
+			}
+
+		m_clusterBounds.resize(k_numClusters);
+		for (uint32_t z = 0; z < k_numClustersZ; ++z)
+		{
+			const float sliceDepths[2] = {
+				zNear * std::pow(zFar / zNear, static_cast<float>(z) / k_numClustersZ),
+				zNear * std::pow(zFar / zNear, static_cast<float>(z + 1) / k_numClustersZ)
+			};
+
+			for (uint32_t y = 0; y < k_numClustersY; ++y)
+				for (uint32_t x = 0; x < k_numClustersX; ++x)
+				{
+					AABB & bounds = m_clusterBounds[getClusterIdx(x, y, z)];
+					bounds = AABB::empty;
+
+					for (uint32_t corner = 0; corner < 4; ++corner)
+					{
+						const auto & line = cornerLines[(y + corner / 2) * (k_numClustersX + 1) + x + corner % 2];
+
+						for (float depth : sliceDepths)
+						{
+							// Where the line of sight crosses the slice's view depth
+							const float t = (-depth - line.first.z) / (line.second.z - line.first.z);
+							const Vector3 point = line.first + (line.second - line.first) * t;
+							bounds.merge(AABB(point, point));
+						}
+					}
+				}
+		}
+	}
+
+	uint32_t LightClusterGrid::getDepthSlice(float depth) const
+	{
+		const float slice = std::floor(std::log(depth) * m_depthSliceScale + m_depthSliceBias);
+		return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(k_numClustersZ - 1)));
+	}
+}
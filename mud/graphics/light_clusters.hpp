@@ -0,0 +1,80 @@
+#ifndef LIGHT_CLUSTERS_HPP
+#define LIGHT_CLUSTERS_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "graphics/lights.hpp"
+#include "math/aabb.hpp"
+#include "math/matrix/matrix_4.hpp"
+
+namespace mud
+{
+	// Grid of view-space clusters (froxels) over the view frustum, each holding the point lights that reach into it, so
+	// that fragments only shade with the lights of their own cluster. The grid is split into screen tiles along x and y
+	// and into slices exponentially spaced between the near and far planes along depth. Tiles are numbered from the top
+	// left of the screen.
+	class LightClusterGrid
+	{
+	public:
+
+		static constexpr uint32_t k_numClustersX = 16;
+		static constexpr uint32_t k_numClustersY = 9;
+		static constexpr uint32_t k_numClustersZ = 24;
+		static constexpr uint32_t k_numClusters = k_numClustersX * k_numClustersY * k_numClustersZ;
+
+		// Lights are cut off where their strongest colour channel falls below this intensity
+		static constexpr float k_minLightIntensity = 1.0f / 256.0f;
+
+		// The range of getLightIndices() holding the lights of a cluster
+		struct Cluster
+		{
+			uint32_t firstLightIdx;
+			uint32_t numLights;
+		};
+
+		LightClusterGrid();
+
+		// Assigns the lights to the clusters their spheres of influence overlap. The cluster bounds are only rebuilt
+		// when the projection or depth range changed since the last call.
+		void build(const Matrix4 & projection, const Matrix4 & view, float zNear, float zFar, const std::vector<PointLight> & lights);
+
+		// Indexed by (z * k_numClustersY + y) * k_numClustersX + x
+		const std::vector<Cluster> & getClusters() const;
+
+		// Indices into the lights of the last build call
+		const std::vector<uint32_t> & getLightIndices() const;
+
+		// The depth slice of a view depth d is floor(log(d) * getDepthSliceScale() + getDepthSliceBias())
+		float getDepthSliceScale() const;
+
+		float getDepthSliceBias() const;
+
+		// Distance at which the light's intensity falls to k_minLightIntensity, or infinity if it never does
+		static float getLightRadius(const PointLight & light);
+
+	private:
+
+		void buildClusterBounds(const Matrix4 & projection, float zNear, float zFar);
+
+		uint32_t getDepthSlice(float depth) const;
+
+		Matrix4 m_projection;
+		float m_zNear;
+		float m_zFar;
+		float m_depthSliceScale;
+		float m_depthSliceBias;
+
+		// View-space bounds of each cluster
+		std::vector<AABB> m_clusterBounds;
+
+		std::vector<Cluster> m_clusters;
+		std::vector<uint32_t> m_lightIndices;
+
+		// Cluster and light index of every overlap found, before they are grouped by cluster
+		std::vector<std::pair<uint32_t, uint32_t>> m_clusterLightPairs;
+	};
+}
+
+#endif
\ No newline at end of file
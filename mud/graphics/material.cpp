@@ -22,10 +22,13 @@ namespace mud
 	{
 		//log(LogLevel::Trace, "Serializing Material...\n", "Asset");
 		serialization_helpers::serialize(file, baseColor);
-		diffuseMap->serializeReference(file);
-		normalMap->serializeReference(file);
-		metalnessMap->serializeReference(file);
-		roughnessMap->serializeReference(file);
+
+		// Maps can be missing when a default texture failed to import, write them as null references
+		for (const Asset<Texture> * map : { diffuseMap, normalMap, metalnessMap, roughnessMap })
+			if (map != nullptr)
+				map->serializeReference(file);
+			else
+				UUID().serialize(file);
 
 		return true;
 	}
@@ -0,0 +1,303 @@
+#include "occlusion_buffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "math/simd.hpp"
+#include "math/vector/vector_4.hpp"
+#include "utils/job_system.hpp"
+
+namespace mud
+{
+	namespace
+	{
+		// Rows per raster job. Every job walks all occluder triangles but only touches its own rows, so no two jobs
+		// write the same pixel.
+		constexpr uint32_t k_rasterizeRowsPerJob = 16;
+
+		constexpr size_t k_minOccludersPerThread = 2;
+
+		// Depth the buffer is cleared to, the far plane
+		constexpr float k_clearDepth = 1.0f;
+
+		Vector3 toScreen(const Vector4 & clip)
+		{
+			const float invW = 1.0f / clip.w;
+			return Vector3(
+				(clip.x * invW * 0.5f + 0.5f) * OcclusionBuffer::k_width,
+				(clip.y * invW * 0.5f + 0.5f) * OcclusionBuffer::k_height,
+				clip.z * invW);
+		}
+
+		// Vertices behind the camera or in front of the near plane cannot be projected without clipping
+		bool isProjectable(const Vector4 & clip)
+		{
+			return clip.w > 0 && clip.z >= -clip.w;
+		}
+	}
+
+	OcclusionBuffer::OcclusionBuffer()
+		: m_projectionView(Matrix4::identity)
+	{
+		for (uint32_t level = 0; ; ++level)
+		{
+			const size_t numTexels = static_cast<size_t>(getLevelWidth(level)) * getLevelHeight(level);
+			m_levels.push_back(DepthLevel{ std::vector<float>(level > 0 ? numTexels : 0, k_clearDepth), std::vector<float>(numTexels, k_clearDepth) });
+			if (getLevelWidth(level) == 1 && getLevelHeight(level) == 1)
+				break;
+		}
+	}
+
+	void OcclusionBuffer::render(const Matrix4 & projectionView, const std::vector<Occluder> & occluders)
+	{
+		m_projectionView = projectionView;
+		std::fill(m_levels[0].farthestDepths.begin(), m_levels[0].farthestDepths.end(), k_clearDepth);
+
+		if (m_occluderTriangles.size() < occluders.size())
+			m_occluderTriangles.resize(occluders.size());
+
+		job_system::parallelFor(occluders.size(), k_minOccludersPerThread, [&](size_t first, size_t last) {
+			for (size_t idx = first; idx < last; ++idx)
+				transformOccluder(occluders[idx], m_occluderTriangles[idx]);
+		});
+
+		const uint32_t numBands = (k_height + k_rasterizeRowsPerJob - 1) / k_rasterizeRowsPerJob;
+		job_system::parallelFor(numBands, 1, [&](size_t firstBand, size_t lastBand) {
+			const uint32_t firstRow = static_cast<uint32_t>(firstBand) * k_rasterizeRowsPerJob;
+			const uint32_t lastRow = std::min(static_cast<uint32_t>(lastBand) * k_rasterizeRowsPerJob, k_height);
+
+			for (size_t idx = 0; idx < occluders.size(); ++idx)
+				for (const ScreenTriangle & triangle : m_occluderTriangles[idx])
+					rasterize(triangle, firstRow, lastRow);
+		});
+
+		buildHierarchy();
+	}
+
+	bool OcclusionBuffer::isOccluded(const AABB & aabb) const
+	{
+		if (aabb.isEmpty())
+			return false;
+
+		float minX = static_cast<float>(k_width);
+		float minY = static_cast<float>(k_height);
+		float maxX = 0;
+		float maxY = 0;
+		float nearestDepth = k_clearDepth;
+
+		for (unsigned int corner = 0; corner < 8; ++corner)
+		{
+			const Vector4 clip = m_projectionView * Vector4(
+				(corner & 1) ? aabb.max.x : aabb.min.x,
+				(corner & 2) ? aabb.max.y : aabb.min.y,
+				(corner & 4) ? aabb.max.z : aabb.min.z,
+				1.0f);
+
+			// Boxes reaching past the near plane are too close to be hidden
+			if (!isProjectable(clip))
+				return false;
+
+			const Vector3 screen = toScreen(clip);
+			minX = std::min(minX, screen.x);
+			minY = std::min(minY, screen.y);
+			maxX = std::max(maxX, screen.x);
+			maxY = std::max(maxY, screen.y);
+			nearestDepth = std::min(nearestDepth, screen.z);
+		}
+
+		if (maxX < 0 || maxY < 0 || minX >= k_width || minY >= k_height)
+			return false;
+
+		// Every pixel the box could touch, rounded outwards
+		uint32_t x0 = static_cast<uint32_t>(std::max(std::floor(minX), 0.0f));
+		uint32_t y0 = static_cast<uint32_t>(std::max(std::floor(minY), 0.0f));
+		uint32_t x1 = std::min(static_cast<uint32_t>(maxX), k_width - 1);
+		uint32_t y1 = std::min(static_cast<uint32_t>(maxY), k_height - 1);
+
+		uint32_t level = 0;
+		while (level + 1 < m_levels.size() && ((x1 >> level) - (x0 >> level) > 3 || (y1 >> level) - (y0 >> level) > 3))
+			++level;
+
+		for (uint32_t y = y0 >> level; y <= y1 >> level; ++y)
+			for (uint32_t x = x0 >> level; x <= x1 >> level; ++x)
+				if (!isRectOccluded(level, x, y, x0, y0, x1, y1, nearestDepth))
+					return false;
+
+		return true;
+	}
+
+	bool OcclusionBuffer::isRectOccluded(uint32_t level, uint32_t x, uint32_t y, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, float depth) const
+	{
+		const DepthLevel & depthLevel = m_levels[level];
+		const size_t idx = static_cast<size_t>(y) * getLevelWidth(level) + x;
+
+		if (depthLevel.farthestDepths[idx] < depth)
+			return true;
+
+		// Every pixel of the texel is at or behind depth, so none of the rectangle's pixels in it can hide the box
+		if (level == 0 || depthLevel.nearestDepths[idx] >= depth)
+			return false;
+
+		const uint32_t childLevel = level - 1;
+		const uint32_t firstChildX = std::max(x * 2, x0 >> childLevel);
+		const uint32_t firstChildY = std::max(y * 2, y0 >> childLevel);
+		const uint32_t lastChildX = std::min({ x * 2 + 1, x1 >> childLevel, getLevelWidth(childLevel) - 1 });
+		const uint32_t lastChildY = std::min({ y * 2 + 1, y1 >> childLevel, getLevelHeight(childLevel) - 1 });
+
+		for (uint32_t childY = firstChildY; childY <= lastChildY; ++childY)
+			for (uint32_t childX = firstChildX; childX <= lastChildX; ++childX)
+				if (!isRectOccluded(childLevel, childX, childY, x0, y0, x1, y1, depth))
+					return false;
+
+		return true;
+	}
+
+	void OcclusionBuffer::transformOccluder(const Occluder & occluder, std::vector<ScreenTriangle> & triangles) const
+	{
+		triangles.clear();
+
+		const std::vector<MeshVertex> & vertices = occluder.mesh->getVertices();
+		const std::vector<uint32_t> & indices = occluder.mesh->getIndices();
+		const size_t numTriangles = (indices.empty() ? vertices.size() : indices.size()) / 3;
+
+		const Matrix4 meshToClip = m_projectionView * occluder.transform;
+
+		for (size_t triangleIdx = 0; triangleIdx < numTriangles; ++triangleIdx)
+		{
+			const size_t firstVertex = triangleIdx * 3;
+			const Vector4 clip0 = meshToClip * Vector4(vertices[indices.empty() ? firstVertex + 0 : indices[firstVertex + 0]].position, 1.0f);
+			const Vector4 clip1 = meshToClip * Vector4(vertices[indices.empty() ? firstVertex + 1 : indices[firstVertex + 1]].position, 1.0f);
+			const Vector4 clip2 = meshToClip * Vector4(vertices[indices.empty() ? firstVertex + 2 : indices[firstVertex + 2]].position, 1.0f);
+
+			if (!isProjectable(clip0) || !isProjectable(clip1) || !isProjectable(clip2))
+				continue;
+
+			const ScreenTriangle triangle{ toScreen(clip0), toScreen(clip1), toScreen(clip2) };
+
+			// Counter-clockwise on screen is front facing, the same winding MeshBase::rayCast treats as front facing
+			const float area = (triangle.p1.x - triangle.p0.x) * (triangle.p2.y - triangle.p0.y) - (triangle.p1.y - triangle.p0.y) * (triangle.p2.x - triangle.p0.x);
+			if (!(area > 0))
+				continue;
+
+			if (std::max({ triangle.p0.x, triangle.p1.x, triangle.p2.x }) < 0 || std::min({ triangle.p0.x, triangle.p1.x, triangle.p2.x }) >= k_width ||
+				std::max({ triangle.p0.y, triangle.p1.y, triangle.p2.y }) < 0 || std::min({ triangle.p0.y, triangle.p1.y, triangle.p2.y }) >= k_height)
+				continue;
+
+			triangles.push_back(triangle);
+		}
+	}
+
+	void OcclusionBuffer::rasterize(const ScreenTriangle & triangle, uint32_t firstRow, uint32_t lastRow)
+	{
+		const Vector3 & p0 = triangle.p0;
+		const Vector3 & p1 = triangle.p1;
+		const Vector3 & p2 = triangle.p2;
+
+		const float minY = std::max(std::floor(std::min({ p0.y, p1.y, p2.y })), static_cast<float>(firstRow));
+		const float maxY = std::min(std::max({ p0.y, p1.y, p2.y }), static_cast<float>(lastRow) - 1);
+		if (minY > maxY)
+			return;
+
+		const float minX = std::max(std::floor(std::min({ p0.x, p1.x, p2.x })), 0.0f);
+		const float maxX = std::min(std::max({ p0.x, p1.x, p2.x }), static_cast<float>(k_width) - 1);
+		if (minX > maxX)
+			return;
+
+		// Edge functions a * x + b * y + c, positive inside a counter-clockwise triangle. Edge i is opposite vertex i,
+		// so edge i divided by the area is the barycentric weight of vertex i.
+		const float a0 = p1.y - p2.y, b0 = p2.x - p1.x, c0 = p1.x * p2.y - p1.y * p2.x;
+		const float a1 = p2.y - p0.y, b1 = p0.x - p2.x, c1 = p2.x * p0.y - p2.y * p0.x;
+		const float a2 = p0.y - p1.y, b2 = p1.x - p0.x, c2 = p0.x * p1.y - p0.y * p1.x;
+
+		// Depth is linear in screen space after the perspective divide
+		const float invArea = 1.0f / (c0 + c1 + c2);
+		const float depthA = (a0 * p0.z + a1 * p1.z + a2 * p2.z) * invArea;
+		const float depthB = (b0 * p0.z + b1 * p1.z + b2 * p2.z) * invArea;
+		const float depthC = (c0 * p0.z + c1 * p1.z + c2 * p2.z) * invArea;
+
+		// Pixel centres of a group of 4
+		const uint32_t firstX = static_cast<uint32_t>(minX) & ~3u;
+		const uint32_t lastX = static_cast<uint32_t>(maxX);
+		const simd::float4 groupX = simd::set(firstX + 0.5f, firstX + 1.5f, firstX + 2.5f, firstX + 3.5f);
+		const simd::float4 zero = simd::splat(0.0f);
+
+		float * depths = m_levels[0].farthestDepths.data();
+
+		for (uint32_t y = static_cast<uint32_t>(minY); y <= static_cast<uint32_t>(maxY); ++y)
+		{
+			const float centreY = y + 0.5f;
+			simd::float4 edge0 = simd::multiplyAdd(simd::splat(a0), groupX, simd::splat(b0 * centreY + c0));
+			simd::float4 edge1 = simd::multiplyAdd(simd::splat(a1), groupX, simd::splat(b1 * centreY + c1));
+			simd::float4 edge2 = simd::multiplyAdd(simd::splat(a2), groupX, simd::splat(b2 * centreY + c2));
+			simd::float4 depth = simd::multiplyAdd(simd::splat(depthA), groupX, simd::splat(depthB * centreY + depthC));
+
+			const simd::float4 edge0Step = simd::splat(a0 * 4);
+			const simd::float4 edge1Step = simd::splat(a1 * 4);
+			const simd::float4 edge2Step = simd::splat(a2 * 4);
+			const simd::float4 depthStep = simd::splat(depthA * 4);
+
+			float * row = depths + static_cast<size_t>(y) * k_width;
+
+			for (uint32_t x = firstX; x <= lastX; x += 4)
+			{
+				const simd::float4 inside = simd::bitAnd(simd::greaterEqual(edge0, zero), simd::bitAnd(simd::greaterEqual(edge1, zero), simd::greaterEqual(edge2, zero)));
+				if (simd::moveMask(inside) != 0)
+				{
+					const simd::float4 current = simd::loadUnaligned(row + x);
+					simd::storeUnaligned(row + x, simd::select(inside, simd::min(current, depth), current));
+				}
+
+				edge0 = simd::add(edge0, edge0Step);
+				edge1 = simd::add(edge1, edge1Step);
+				edge2 = simd::add(edge2, edge2Step);
+				depth = simd::add(depth, depthStep);
+			}
+		}
+	}
+
+	void OcclusionBuffer::buildHierarchy()
+	{
+		for (uint32_t level = 1; level < m_levels.size(); ++level)
+		{
+			// Level 0 holds a single depth per pixel, which is both its nearest and farthest
+			const DepthLevel & source = m_levels[level - 1];
+			const std::vector<float> & sourceNearest = level > 1 ? source.nearestDepths : source.farthestDepths;
+			const std::vector<float> & sourceFarthest = source.farthestDepths;
+			const uint32_t sourceWidth = getLevelWidth(level - 1);
+			const uint32_t sourceHeight = getLevelHeight(level - 1);
+
+			DepthLevel & destination = m_levels[level];
+			const uint32_t width = getLevelWidth(level);
+			const uint32_t height = getLevelHeight(level);
+
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				const size_t sourceRow0 = static_cast<size_t>(y * 2) * sourceWidth;
+				const size_t sourceRow1 = static_cast<size_t>(std::min(y * 2 + 1, sourceHeight - 1)) * sourceWidth;
+
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					const uint32_t sourceX0 = x * 2;
+					const uint32_t sourceX1 = std::min(sourceX0 + 1, sourceWidth - 1);
+
+					destination.nearestDepths[y * width + x] = std::min({
+						sourceNearest[sourceRow0 + sourceX0], sourceNearest[sourceRow0 + sourceX1],
+						sourceNearest[sourceRow1 + sourceX0], sourceNearest[sourceRow1 + sourceX1] });
+					destination.farthestDepths[y * width + x] = std::max({
+						sourceFarthest[sourceRow0 + sourceX0], sourceFarthest[sourceRow0 + sourceX1],
+						sourceFarthest[sourceRow1 + sourceX0], sourceFarthest[sourceRow1 + sourceX1] });
+				}
+			}
+		}
+	}
+
+	uint32_t OcclusionBuffer::getLevelWidth(uint32_t level) const
+	{
+		return std::max(k_width >> level, 1u);
+	}
+
+	uint32_t OcclusionBuffer::getLevelHeight(uint32_t level) const
+	{
+		return std::max(k_height >> level, 1u);
+	}
+}
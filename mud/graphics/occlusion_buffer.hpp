@@ -0,0 +1,81 @@
+#ifndef OCCLUSION_BUFFER_HPP
+#define OCCLUSION_BUFFER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "graphics/interface/mesh_base.hpp"
+#include "math/aabb.hpp"
+#include "math/matrix/matrix_4.hpp"
+#include "math/vector/vector_3.hpp"
+
+namespace mud
+{
+	// Low resolution depth buffer rasterised on the CPU for occlusion culling. Occluder meshes are drawn into it and a
+	// hierarchy of nearest and farthest depths is built over it. Bounds are tested starting from the coarsest level at
+	// which they cover no more than 4x4 texels, descending only into texels that neither prove nor rule out occlusion.
+	// Depths are normalised device z, so smaller is nearer.
+	class OcclusionBuffer
+	{
+	public:
+
+		struct Occluder
+		{
+			const MeshBase * mesh;
+			Matrix4 transform;
+		};
+
+		// The width is a multiple of 4 so rows can be rasterised 4 pixels at a time
+		static constexpr uint32_t k_width = 256;
+		static constexpr uint32_t k_height = 128;
+
+		OcclusionBuffer();
+
+		// Clears the buffer, draws the front faces of the occluders across worker threads and builds the hierarchy.
+		// Triangles crossing the near plane are skipped, which only lets more through the test.
+		void render(const Matrix4 & projectionView, const std::vector<Occluder> & occluders);
+
+		// True if the world-space box is certainly hidden behind the occluders of the last render call. Safe to call
+		// from several threads at once.
+		bool isOccluded(const AABB & aabb) const;
+
+	private:
+
+		// x and y in pixels, z in normalised device coordinates
+		struct ScreenTriangle
+		{
+			Vector3 p0;
+			Vector3 p1;
+			Vector3 p2;
+		};
+
+		void transformOccluder(const Occluder & occluder, std::vector<ScreenTriangle> & triangles) const;
+
+		void rasterize(const ScreenTriangle & triangle, uint32_t firstRow, uint32_t lastRow);
+
+		void buildHierarchy();
+
+		// Tests the pixels of the rectangle [x0, x1] x [y0, y1] inside texel (x, y) of the level
+		bool isRectOccluded(uint32_t level, uint32_t x, uint32_t y, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, float depth) const;
+
+		uint32_t getLevelWidth(uint32_t level) const;
+
+		uint32_t getLevelHeight(uint32_t level) const;
+
+		Matrix4 m_projectionView;
+
+		// Nearest and farthest depth of each texel. Level 0 is the full resolution depth buffer and only uses
+		// farthestDepths, each following level covers 2x2 texels of the one before.
+		struct DepthLevel
+		{
+			std::vector<float> nearestDepths;
+			std::vector<float> farthestDepths;
+		};
+
+		std::vector<DepthLevel> m_levels;
+
+		std::vector<std::vector<ScreenTriangle>> m_occluderTriangles;
+	};
+}
+
+#endif
\ No newline at end of file
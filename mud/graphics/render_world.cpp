@@ -0,0 +1,179 @@
+#include "render_world.hpp"
+
+#include <cassert>
+
+#include "utils/logger.hpp"
+
+namespace mud
+{
+	RenderWorld::RenderWorld()
+	{
+		for (uint32_t layer = 0; layer < k_numLayers; ++layer)
+			setLayerIndex(layer, RenderLayerIndex::LooseOctree);
+	}
+
+	int32_t RenderWorld::createProxy(const RenderProxy & proxy)
+	{
+		int32_t proxyId;
+		if (!m_freeProxyIds.empty())
+		{
+			proxyId = m_freeProxyIds.back();
+			m_freeProxyIds.pop_back();
+		}
+		else
+		{
+			proxyId = static_cast<int32_t>(m_proxySlots.size());
+			m_proxySlots.emplace_back();
+		}
+
+		addToLayer(proxyId, proxy);
+		++m_numProxies;
+
+		return proxyId;
+	}
+
+	void RenderWorld::updateProxy(int32_t proxyId, const RenderProxy & proxy)
+	{
+		const ProxySlot slot = m_proxySlots[proxyId];
+		if (slot.layer != proxy.layer)
+		{
+			removeFromLayer(proxyId);
+			addToLayer(proxyId, proxy);
+			return;
+		}
+
+		Layer & layer = m_layers[slot.layer];
+		layer.numFullDetailProxies += (proxy.lodLevel == 0) - (layer.proxies[slot.idx].lodLevel == 0);
+		layer.proxies[slot.idx] = proxy;
+
+		if (layer.octree != nullptr)
+			layer.octree->moveProxy(layer.octreeProxyIds[slot.idx], proxy.worldBounds);
+	}
+
+	void RenderWorld::destroyProxy(int32_t proxyId)
+	{
+		removeFromLayer(proxyId);
+		m_freeProxyIds.push_back(proxyId);
+		--m_numProxies;
+	}
+
+	void RenderWorld::clear()
+	{
+		for (Layer & layer : m_layers)
+		{
+			for (int32_t octreeProxyId : layer.octreeProxyIds)
+				layer.octree->destroyProxy(octreeProxyId);
+
+			layer.proxies.clear();
+			layer.proxyIds.clear();
+			layer.octreeProxyIds.clear();
+			layer.numFullDetailProxies = 0;
+		}
+
+		m_proxySlots.clear();
+		m_freeProxyIds.clear();
+		m_numProxies = 0;
+	}
+
+	const RenderProxy & RenderWorld::getProxy(int32_t proxyId) const
+	{
+		const ProxySlot & slot = m_proxySlots[proxyId];
+		return m_layers[slot.layer].proxies[slot.idx];
+	}
+
+	size_t RenderWorld::getNumProxies() const
+	{
+		return m_numProxies;
+	}
+
+	const std::vector<RenderProxy> & RenderWorld::getProxies(uint32_t layer) const
+	{
+		assert(layer < k_numLayers);
+		return m_layers[layer].proxies;
+	}
+
+	size_t RenderWorld::getNumFullDetailProxies(uint32_t layer) const
+	{
+		assert(layer < k_numLayers);
+		return m_layers[layer].numFullDetailProxies;
+	}
+
+	void RenderWorld::setLayerIndex(uint32_t layerIdx, RenderLayerIndex index, const AABB & octreeBounds, uint32_t octreeMaxDepth)
+	{
+		if (layerIdx >= k_numLayers)
+		{
+			log(LogLevel::Error, fmt::format("Failed to set the index of render layer {0}: There are only {1} layers\n", layerIdx, k_numLayers), "RenderWorld");
+			return;
+		}
+
+		Layer & layer = m_layers[layerIdx];
+		layer.index = index;
+		layer.octreeProxyIds.clear();
+		layer.octree.reset();
+
+		if (index != RenderLayerIndex::LooseOctree)
+			return;
+
+		layer.octree = std::make_unique<LooseOctree>(octreeBounds, octreeMaxDepth);
+		for (size_t idx = 0; idx < layer.proxies.size(); ++idx)
+			layer.octreeProxyIds.push_back(layer.octree->createProxy(layer.proxies[idx].worldBounds, static_cast<uint64_t>(layer.proxyIds[idx])));
+	}
+
+	RenderLayerIndex RenderWorld::getLayerIndex(uint32_t layer) const
+	{
+		assert(layer < k_numLayers);
+		return m_layers[layer].index;
+	}
+
+	const LooseOctree * RenderWorld::getLayerOctree(uint32_t layer) const
+	{
+		assert(layer < k_numLayers);
+		return m_layers[layer].octree.get();
+	}
+
+	void RenderWorld::addToLayer(int32_t proxyId, const RenderProxy & proxy)
+	{
+		// makeRenderProxy clamps the layer, proxies built by hand must keep it in range too
+		assert(proxy.layer < k_numLayers);
+
+		Layer & layer = m_layers[proxy.layer];
+		m_proxySlots[proxyId] = ProxySlot{ proxy.layer, static_cast<uint32_t>(layer.proxies.size()) };
+
+		layer.proxies.push_back(proxy);
+		layer.proxyIds.push_back(proxyId);
+		if (proxy.lodLevel == 0)
+			++layer.numFullDetailProxies;
+
+		if (layer.octree != nullptr)
+			layer.octreeProxyIds.push_back(layer.octree->createProxy(proxy.worldBounds, static_cast<uint64_t>(proxyId)));
+	}
+
+	void RenderWorld::removeFromLayer(int32_t proxyId)
+	{
+		const ProxySlot slot = m_proxySlots[proxyId];
+		Layer & layer = m_layers[slot.layer];
+		const uint32_t lastIdx = static_cast<uint32_t>(layer.proxies.size() - 1);
+
+		if (layer.octree != nullptr)
+			layer.octree->destroyProxy(layer.octreeProxyIds[slot.idx]);
+
+		if (layer.proxies[slot.idx].lodLevel == 0)
+			--layer.numFullDetailProxies;
+
+		// Swap-and-pop keeps the layer packed, only the moved proxy's slot needs patching
+		if (slot.idx != lastIdx)
+		{
+			layer.proxies[slot.idx] = layer.proxies[lastIdx];
+			layer.proxyIds[slot.idx] = layer.proxyIds[lastIdx];
+			if (layer.octree != nullptr)
+				layer.octreeProxyIds[slot.idx] = layer.octreeProxyIds[lastIdx];
+
+			m_proxySlots[layer.proxyIds[slot.idx]].idx = slot.idx;
+		}
+
+		layer.proxies.pop_back();
+		layer.proxyIds.pop_back();
+		if (layer.octree != nullptr)
+			layer.octreeProxyIds.pop_back();
+	}
+}
\ No newline at end of file
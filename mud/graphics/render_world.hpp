@@ -0,0 +1,146 @@
+#ifndef RENDER_WORLD_HPP
+#define RENDER_WORLD_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "graphics/material.hpp"
+#include "graphics/mesh.hpp"
+#include "math/aabb.hpp"
+#include "math/loose_octree.hpp"
+#include "math/matrix.hpp"
+
+namespace mud
+{
+	// Everything a renderer needs to know about one drawable, as plain data. The mesh and material are the loaded
+	// objects, never their assets, so nothing reached from a proxy belongs to the scene graph.
+	struct RenderProxy
+	{
+		const Mesh * mesh;
+		const Material * material;
+		Matrix4 worldTransform;
+		AABB worldBounds;
+
+		// Runtime ids of the mesh and material, for sorting and batching without following the pointers
+		uint32_t meshId;
+		uint32_t materialId;
+
+		uint32_t layer;
+
+		// Bounding sphere of all the meshes of the proxy's node. Its size on screen picks the node's level of detail and
+		// culls nodes too small to see, the same way for every proxy of the node.
+		Vector3 lodCenter;
+		float lodRadius;
+
+		// The proxy is only drawn while its node's chosen level of detail is lodLevel, out of the node's numLodLevels
+		uint16_t lodLevel;
+		uint16_t numLodLevels;
+
+		// Per-node overrides: the level of detail always drawn, or -1 to choose by size, and the on-screen size in
+		// pixels below which the node is culled, or below 0 to use the scene's
+		int32_t forcedLodLevel;
+		float minPixelSize;
+	};
+
+	// How the proxies of a render layer are found when culling
+	enum class RenderLayerIndex
+	{
+		// Every proxy is tested, which suits layers where most proxies are visible
+		Linear,
+
+		// Proxies are kept in a loose octree, so culling skips whole regions while updates stay cheap for layers with
+		// many moving proxies. The default for every layer.
+		LooseOctree
+	};
+
+	// The render side of a scene: flat arrays of render proxies that the scene creates, updates and destroys as its
+	// drawables change, rather than being rebuilt every frame. Culling and submission only read the proxies, so they
+	// never touch the scene graph, which can be edited for the next frame once a frame's proxies are extracted.
+	class RenderWorld
+	{
+	public:
+
+		static constexpr int32_t k_nullProxy = -1;
+
+		static constexpr uint32_t k_numLayers = 8;
+
+		// Every layer starts indexed by a loose octree with the default bounds and depth of setLayerIndex
+		RenderWorld();
+
+		int32_t createProxy(const RenderProxy & proxy);
+
+		// Moves the proxy to its new layer if that changed
+		void updateProxy(int32_t proxyId, const RenderProxy & proxy);
+
+		void destroyProxy(int32_t proxyId);
+
+		// Destroys every proxy, layers keep their index
+		void clear();
+
+		const RenderProxy & getProxy(int32_t proxyId) const;
+
+		size_t getNumProxies() const;
+
+		// Every proxy of the layer, packed. Destroying a proxy moves the last one into its place, so the order is not
+		// stable.
+		const std::vector<RenderProxy> & getProxies(uint32_t layer) const;
+
+		// Proxies of the layer at a node's full level of detail, which is one per mesh of every node however many lower
+		// levels it has
+		size_t getNumFullDetailProxies(uint32_t layer) const;
+
+		// The octree's root cube encloses octreeBounds, proxies outside it are still found but not sorted into nodes.
+		// Layers past the last are rejected with an error, every other layer argument must be below k_numLayers.
+		void setLayerIndex(uint32_t layer, RenderLayerIndex index, const AABB & octreeBounds = AABB(Vector3(-1024.0f), Vector3(1024.0f)), uint32_t octreeMaxDepth = 8);
+
+		RenderLayerIndex getLayerIndex(uint32_t layer) const;
+
+		// The octree of a LooseOctree layer, for frustum, ray and radius queries, or nullptr. Its user data are proxy
+		// ids.
+		const LooseOctree * getLayerOctree(uint32_t layer) const;
+
+	private:
+
+		struct Layer
+		{
+			RenderLayerIndex index = RenderLayerIndex::Linear;
+			std::vector<RenderProxy> proxies;
+
+			// Proxy id, and octree proxy of LooseOctree layers, of the packed proxy at the same index
+			std::vector<int32_t> proxyIds;
+			std::vector<int32_t> octreeProxyIds;
+
+			std::unique_ptr<LooseOctree> octree;
+
+			size_t numFullDetailProxies = 0;
+		};
+
+		// Where a proxy id's proxy is packed
+		struct ProxySlot
+		{
+			uint32_t layer;
+			uint32_t idx;
+		};
+
+		void addToLayer(int32_t proxyId, const RenderProxy & proxy);
+
+		void removeFromLayer(int32_t proxyId);
+
+		std::array<Layer, k_numLayers> m_layers;
+		std::vector<ProxySlot> m_proxySlots;
+		std::vector<int32_t> m_freeProxyIds;
+		size_t m_numProxies = 0;
+	};
+
+	// Layers past the last are put in the last. The proxy is a node's only level of detail, sized by its own bounds.
+	inline RenderProxy makeRenderProxy(const Mesh * mesh, const Material * material, const Matrix4 & worldTransform, const AABB & worldBounds, uint32_t layer = 0)
+	{
+		return RenderProxy{ mesh, material, worldTransform, worldBounds, mesh->getRuntimeId(), material->getRuntimeId(), std::min(layer, RenderWorld::k_numLayers - 1),
+			worldBounds.getCenter(), worldBounds.getExtents().magnitude(), 0, 1, -1, -1.0f };
+	}
+}
+
+#endif
\ No newline at end of file
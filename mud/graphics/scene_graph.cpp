@@ -1,13 +1,22 @@
 #include "scene_graph.hpp"
 
+#include <algorithm>
+#include <unordered_map>
+
+#include "math/batch_transform.hpp"
 #include "utils/asset_manager.hpp"
 #include "utils/logger.hpp"
 
 namespace mud
 {
-	bool deserializeNode(std::ifstream & file, SceneGraph & graph, SceneGraph::Node * node)
+	// Appends the node and its descendants to nodes in the order they are read, which is the order they were written in
+	bool deserializeNode(std::ifstream & file, SceneGraph & graph, SceneGraph::Handle node, std::vector<SceneGraph::Handle> & nodes)
 	{
-		serialization_helpers::deserialize(file, node->data.transform);
+		nodes.push_back(node);
+
+		Matrix4 transform;
+		serialization_helpers::deserialize(file, transform);
+		graph.setNodeTransform(node, transform);
 
 		size_t numPairs = 0;
 		serialization_helpers::deserialize(file, numPairs);
@@ -28,10 +37,10 @@ namespace mud
 				return false;
 			}
 
-			node->data.materialMeshPairs.emplace_back(materialAsset, meshAsset);
+			graph.getData(node).materialMeshPairs.emplace_back(materialAsset, meshAsset);
 		}
 		
-		serialization_helpers::deserializeVector(file, node->data.pointLights);
+		serialization_helpers::deserializeVector(file, graph.getData(node).pointLights);
 
 		size_t numChildren = 0;
 		serialization_helpers::deserialize(file, numChildren);
@@ -40,76 +49,512 @@ namespace mud
 
 		for (size_t idx = 0; idx < numChildren; ++idx)
 		{
-			SceneGraph::Node * newChildNode = graph.newNode();
-			if (!deserializeNode(file, graph, newChildNode))
-				return false;
+			const SceneGraph::Handle newChildNode = graph.newNode();
 			graph.setNodeParent(newChildNode, node);
+			if (!deserializeNode(file, graph, newChildNode, nodes))
+				return false;
 		}
 
 		return true;
 	}
 	
 	SceneGraphNodeData::SceneGraphNodeData()
-		: isHidden(false)
+		: isHidden(false), isStatic(false), layer(0), forcedLodLevel(-1), minPixelSize(-1.0f), m_transform(Matrix4::identity), m_worldTransform(Matrix4::identity), m_isWorldTransformDirty(true),
+		m_worldBounds(AABB::empty), m_isStaticBatched(false), m_bvhProxy(DynamicAABBTree::k_nullProxy)
 	{}
 
+	const Matrix4 & SceneGraphNodeData::getTransform() const
+	{
+		return m_transform;
+	}
+
+	const Matrix4 & SceneGraphNodeData::getWorldTransform() const
+	{
+		return m_worldTransform;
+	}
+
+	const AABB & SceneGraphNodeData::getMeshWorldBounds(size_t idx) const
+	{
+		return m_meshWorldBounds[idx];
+	}
+
+	const AABB & SceneGraphNodeData::getWorldBounds() const
+	{
+		return m_worldBounds;
+	}
+
+	bool SceneGraphNodeData::isStaticBatched() const
+	{
+		return m_isStaticBatched;
+	}
+
 	bool SceneGraph::deserialize(std::ifstream & file)
 	{
 		size_t numRootNodes = 0;
 		serialization_helpers::deserialize(file, numRootNodes);
 
+		std::vector<Handle> nodes;
 		for (size_t idx = 0; idx < numRootNodes; ++idx)
 		{
-			Node * newRootNode = newNode();
-			if (!deserializeNode(file, *this, newRootNode))
+			const Handle newRootNode = newNode();
+			if (!deserializeNode(file, *this, newRootNode, nodes))
+				return false;
+		}
+
+		sortDepthFirst();
+
+		// Static nodes and batches are an optional trailing section, graphs saved without one have neither
+		if (file.peek() == std::ifstream::traits_type::eof())
+			return true;
+
+		std::vector<uint32_t> staticNodeIdxs;
+		std::vector<uint32_t> staticBatchedNodeIdxs;
+		if (!serialization_helpers::deserializeVector(file, staticNodeIdxs) || !serialization_helpers::deserializeVector(file, staticBatchedNodeIdxs))
+		{
+			log(LogLevel::Error, fmt::format("Failed to deserialize scene graph: failed to deserialize static nodes\n"));
+			return false;
+		}
+
+		for (const std::vector<uint32_t> * nodeIdxs : { &staticNodeIdxs, &staticBatchedNodeIdxs })
+			for (uint32_t nodeIdx : *nodeIdxs)
+				if (nodeIdx >= nodes.size())
+				{
+					log(LogLevel::Error, fmt::format("Failed to deserialize scene graph: static node {0} out of range\n", nodeIdx));
+					return false;
+				}
+
+		for (uint32_t nodeIdx : staticNodeIdxs)
+			getData(nodes[nodeIdx]).isStatic = true;
+
+		for (uint32_t nodeIdx : staticBatchedNodeIdxs)
+			getData(nodes[nodeIdx]).m_isStaticBatched = true;
+
+		size_t numStaticBatches = 0;
+		serialization_helpers::deserialize(file, numStaticBatches);
+
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		for (size_t idx = 0; idx < numStaticBatches; ++idx)
+		{
+			StaticBatch batch;
+
+			batch.material = AssetManager::getInstance().deserializeAssetReference<Material>(file);
+			if (batch.material == nullptr || !batch.material->load())
+			{
+				log(LogLevel::Error, fmt::format("Failed to deserialize scene graph: failed to deserialize static batch material\n"));
+				return false;
+			}
+
+			if (!serialization_helpers::deserializeVector(file, vertices) || !serialization_helpers::deserializeVector(file, indices) ||
+				!serialization_helpers::deserializeVector(file, batch.pieces))
+			{
+				log(LogLevel::Error, fmt::format("Failed to deserialize scene graph: failed to deserialize static batch mesh\n"));
 				return false;
+			}
+
+			batch.mesh = std::make_unique<Mesh>();
+			batch.mesh->setData(vertices, indices);
+			m_staticBatches.push_back(std::move(batch));
+		}
+
+		// The pieces of each batched node, in the same order as the nodes. A node referring to a piece that doesn't exist
+		// would leave geometry behind when it is unbatched, so batches that don't match their nodes are dropped and the
+		// nodes draw their own meshes instead.
+		for (uint32_t nodeIdx : staticBatchedNodeIdxs)
+		{
+			std::vector<std::pair<uint32_t, uint32_t>> & pieces = getData(nodes[nodeIdx]).m_staticBatchPieces;
+
+			bool arePiecesValid = serialization_helpers::deserializeVector(file, pieces);
+			for (const auto & [batchIdx, pieceIdx] : pieces)
+				arePiecesValid &= batchIdx < m_staticBatches.size() && pieceIdx < m_staticBatches[batchIdx].pieces.size() && m_staticBatches[batchIdx].pieces[pieceIdx].numIndices != 0;
+
+			if (!arePiecesValid)
+			{
+				log(LogLevel::Error, fmt::format("Failed to deserialize scene graph: static batches don't match the batched nodes, dropping them\n"));
+				clearStaticBatches();
+				break;
+			}
 		}
 
 		return true;
 	}
 
-	void serializeNode(std::ofstream & file, const SceneGraph::Node * node)
+	// Appends the node and its descendants to nodes in the order serializeNode writes them
+	void gatherNodesInSerializationOrder(const SceneGraph & graph, SceneGraph::Handle node, std::vector<SceneGraph::Handle> & nodes)
 	{
-		serialization_helpers::serialize(file, node->data.transform);
-		serialization_helpers::serialize(file, node->data.materialMeshPairs.size());
+		nodes.push_back(node);
 
-		for (const auto & pair : node->data.materialMeshPairs)
+		for (SceneGraph::Handle child = graph.getFirstChild(node); child.isValid(); child = graph.getNextSibling(child))
+			gatherNodesInSerializationOrder(graph, child, nodes);
+	}
+
+	void serializeNode(std::ofstream & file, const SceneGraph & graph, SceneGraph::Handle node)
+	{
+		const SceneGraphNodeData & data = graph.getData(node);
+
+		serialization_helpers::serialize(file, data.getTransform());
+		serialization_helpers::serialize(file, data.materialMeshPairs.size());
+
+		for (const auto & pair : data.materialMeshPairs)
 		{
 			pair.first->serializeReference(file);
 			pair.second->serializeReference(file);
 		}
 
-		serialization_helpers::serializeVector(file, node->data.pointLights);
+		serialization_helpers::serializeVector(file, data.pointLights);
 
-		serialization_helpers::serialize(file, node->children.size());
+		serialization_helpers::serialize(file, graph.getNumChildren(node));
 
-		for (size_t idx = 0; idx < node->children.size(); ++idx)
-			serializeNode(file, node->children[idx]);
+		for (SceneGraph::Handle child = graph.getFirstChild(node); child.isValid(); child = graph.getNextSibling(child))
+			serializeNode(file, graph, child);
 	}
 
 	bool SceneGraph::serialize(std::ofstream & file) const
 	{
-		const std::vector<Node *> & rootNodes = getRootNodes();
+		const std::vector<Handle> rootNodes = getRootNodes();
 
 		serialization_helpers::serialize(file, rootNodes.size());
 
-		for (const auto & rootNode : rootNodes)
-			serializeNode(file, rootNode);
+		for (Handle rootNode : rootNodes)
+			serializeNode(file, *this, rootNode);
 
-		return true;
+		// Static nodes are referred to by their position in the order the nodes were written in
+		std::vector<Handle> nodes;
+		for (Handle rootNode : rootNodes)
+			gatherNodesInSerializationOrder(*this, rootNode, nodes);
+
+		std::vector<uint32_t> staticNodeIdxs;
+		std::vector<uint32_t> staticBatchedNodeIdxs;
+		for (uint32_t nodeIdx = 0; nodeIdx < nodes.size(); ++nodeIdx)
+		{
+			if (getData(nodes[nodeIdx]).isStatic)
+				staticNodeIdxs.push_back(nodeIdx);
+			if (getData(nodes[nodeIdx]).m_isStaticBatched)
+				staticBatchedNodeIdxs.push_back(nodeIdx);
+		}
+
+		serialization_helpers::serializeVector(file, staticNodeIdxs);
+		serialization_helpers::serializeVector(file, staticBatchedNodeIdxs);
+
+		serialization_helpers::serialize(file, m_staticBatches.size());
+		for (const StaticBatch & batch : m_staticBatches)
+		{
+			batch.material->serializeReference(file);
+			serialization_helpers::serializeVector(file, batch.mesh->getVertices());
+			serialization_helpers::serializeVector(file, batch.mesh->getIndices());
+			serialization_helpers::serializeVector(file, batch.pieces);
+		}
+
+		for (uint32_t nodeIdx : staticBatchedNodeIdxs)
+			serialization_helpers::serializeVector(file, getData(nodes[nodeIdx]).m_staticBatchPieces);
+
+		return file.good();
+	}
+
+	void SceneGraph::setNodeTransform(Handle node, const Matrix4 & transform)
+	{
+		SceneGraphNodeData & data = getData(node);
+		if (transform != data.m_transform)
+			onSubtreeMoved(node);
+
+		data.m_transform = transform;
+		if (!data.m_isWorldTransformDirty)
+			markWorldTransformDirty(node);
+	}
+
+	void SceneGraph::invalidateNode(Handle node)
+	{
+		if (!getData(node).m_isWorldTransformDirty)
+			markWorldTransformDirty(node);
+	}
+
+	const Matrix4 & SceneGraph::getNodeWorldTransform(Handle node)
+	{
+		updateWorldTransforms();
+		return getData(node).m_worldTransform;
+	}
+
+	void SceneGraph::updateWorldTransforms()
+	{
+		sortDepthFirst();
+
+		// Visiting the dirty nodes in storage order, which is now depth-first, reaches every dirty ancestor of a node
+		// before the node. A node still dirty when reached therefore has an up to date parent, and no subtree is
+		// recomputed twice, without walking up the ancestors of each dirty node.
+		m_dirtyNodes.erase(std::remove_if(m_dirtyNodes.begin(), m_dirtyNodes.end(), [this](Handle node) { return !isValid(node); }), m_dirtyNodes.end());
+		std::sort(m_dirtyNodes.begin(), m_dirtyNodes.end(), [this](Handle lhs, Handle rhs) { return &getNode(lhs) < &getNode(rhs); });
+
+		for (Handle node : m_dirtyNodes)
+		{
+			// Already updated as part of a dirty ancestor's subtree
+			if (!getData(node).m_isWorldTransformDirty)
+				continue;
+
+			const Handle parent = getParent(node);
+			updateNodeWorldTransform(node, parent.isValid() ? getData(parent).m_worldTransform : Matrix4::identity);
+		}
+
+		m_dirtyNodes.clear();
+	}
+
+	const DynamicAABBTree & SceneGraph::getBVH() const
+	{
+		return m_bvh;
+	}
+
+	SceneGraph::Handle SceneGraph::getBVHProxyNode(int32_t proxyId) const
+	{
+		const uint64_t userData = m_bvh.getUserData(proxyId);
+		return Handle{ static_cast<uint32_t>(userData >> 32), static_cast<uint32_t>(userData) };
 	}
 
-	Matrix4 SceneGraph::getNodeWorldTransform(const SceneGraph::Node & node)
+	// Appends the visible nodes with meshes of the static subtrees under node, in depth-first order
+	void gatherStaticBatchNodes(const SceneGraph & graph, SceneGraph::Handle node, bool isInStaticSubtree, std::vector<SceneGraph::Handle> & nodes)
 	{
-		Matrix4 worldTransform = node.data.transform;
-		const SceneGraph::Node * parent = node.parent;
+		const SceneGraphNodeData & data = graph.getData(node);
+		isInStaticSubtree |= data.isStatic;
 
-		while (parent != nullptr)
+		if (isInStaticSubtree && !data.isHidden && !data.materialMeshPairs.empty())
+			nodes.push_back(node);
+
+		for (SceneGraph::Handle child = graph.getFirstChild(node); child.isValid(); child = graph.getNextSibling(child))
+			gatherStaticBatchNodes(graph, child, isInStaticSubtree, nodes);
+	}
+
+	void SceneGraph::buildStaticBatches()
+	{
+		clearStaticBatches();
+		updateWorldTransforms();
+
+		std::vector<Handle> nodes;
+		for (Handle rootNode = getFirstRootNode(); rootNode.isValid(); rootNode = getNextSibling(rootNode))
+			gatherStaticBatchNodes(*this, rootNode, false, nodes);
+
+		// The merged vertices and indices of each batch, and each material's batch
+		std::vector<std::pair<std::vector<MeshVertex>, std::vector<uint32_t>>> batchData;
+		std::unordered_map<const Asset<Material> *, size_t> materialBatchIdxs;
+
+		size_t numMeshes = 0;
+
+		for (Handle node : nodes)
+		{
+			SceneGraphNodeData & data = getData(node);
+			data.m_isStaticBatched = true;
+			invalidateNode(node);
+
+			const Matrix4 & worldTransform = data.m_worldTransform;
+			const Matrix4 normalTransform = worldTransform.inverse().transpose();
+
+			// Mirroring transforms turn triangles inside out, their winding is reversed to keep them facing outwards
+			const bool isMirrored = worldTransform.determinant() < 0.0f;
+
+			for (const auto & pair : data.materialMeshPairs)
+			{
+				const Mesh * mesh = pair.second->get();
+				if (mesh == nullptr || mesh->getVertices().empty())
+					continue;
+
+				const auto [batchIdxIt, isNewBatch] = materialBatchIdxs.try_emplace(pair.first, m_staticBatches.size());
+				if (isNewBatch)
+				{
+					m_staticBatches.push_back(StaticBatch{ pair.first, nullptr, {} });
+					batchData.emplace_back();
+				}
+
+				StaticBatch & batch = m_staticBatches[batchIdxIt->second];
+				std::vector<MeshVertex> & vertices = batchData[batchIdxIt->second].first;
+				std::vector<uint32_t> & indices = batchData[batchIdxIt->second].second;
+
+				const uint32_t firstVertex = static_cast<uint32_t>(vertices.size());
+				const uint32_t firstIndex = static_cast<uint32_t>(indices.size());
+
+				AABB worldBounds = AABB::empty;
+				for (const MeshVertex & vertex : mesh->getVertices())
+				{
+					const Vector3 position = worldTransform * Vector4(vertex.position, 1.0f);
+					const Vector3 normal = normalTransform * Vector4(vertex.normal, 0.0f);
+					vertices.push_back(MeshVertex{ position, normal.magnitude() > 0.0f ? normal.normal() : normal, vertex.colour, vertex.textureCoordinates });
+					worldBounds.merge(AABB(position, position));
+				}
+
+				// Meshes without indices draw their vertices in order. Only complete triangles are flipped, indices left over
+				// past the last one are copied as they are.
+				const size_t numIndices = mesh->getIndices().empty() ? mesh->getVertices().size() : mesh->getIndices().size();
+				const size_t numTriangleIndices = numIndices - numIndices % 3;
+				for (size_t idx = 0; idx < numIndices; ++idx)
+				{
+					const size_t sourceIdx = isMirrored && idx < numTriangleIndices ? idx - idx % 3 + 2 - idx % 3 : idx;
+					indices.push_back(firstVertex + (mesh->getIndices().empty() ? static_cast<uint32_t>(sourceIdx) : mesh->getIndices()[sourceIdx]));
+				}
+
+				data.m_staticBatchPieces.emplace_back(static_cast<uint32_t>(batchIdxIt->second), static_cast<uint32_t>(batch.pieces.size()));
+				batch.pieces.push_back(StaticBatch::Piece{ firstIndex, static_cast<uint32_t>(numIndices), worldBounds });
+				++numMeshes;
+			}
+		}
+
+		for (size_t idx = 0; idx < m_staticBatches.size(); ++idx)
 		{
-			worldTransform = parent->data.transform * worldTransform;
-			parent = parent->parent;
+			m_staticBatches[idx].mesh = std::make_unique<Mesh>();
+			m_staticBatches[idx].mesh->setData(batchData[idx].first, batchData[idx].second);
 		}
 
-		return worldTransform;
+		// Reports the batched nodes as changed, so that copies of their meshes kept elsewhere are dropped
+		updateWorldTransforms();
+
+		log(LogLevel::Trace, fmt::format("Built {0} static batches from {1} meshes of {2} nodes\n", m_staticBatches.size(), numMeshes, nodes.size()));
+	}
+
+	void SceneGraph::clearStaticBatches()
+	{
+		for (const Node & node : getNodes())
+			if (node.data.m_isStaticBatched)
+			{
+				getData(getHandle(node)).m_isStaticBatched = false;
+				getData(getHandle(node)).m_staticBatchPieces.clear();
+				invalidateNode(getHandle(node));
+			}
+
+		m_staticBatches.clear();
+	}
+
+	const std::vector<StaticBatch> & SceneGraph::getStaticBatches() const
+	{
+		return m_staticBatches;
+	}
+
+	void SceneGraph::setChangeTrackingEnabled(bool isEnabled)
+	{
+		m_isChangeTrackingEnabled = isEnabled;
+		m_updatedNodes.clear();
+		m_deletedNodes.clear();
+	}
+
+	void SceneGraph::takeChanges(std::vector<Handle> & updatedNodes, std::vector<Handle> & deletedNodes)
+	{
+		updatedNodes.insert(updatedNodes.end(), m_updatedNodes.begin(), m_updatedNodes.end());
+		deletedNodes.insert(deletedNodes.end(), m_deletedNodes.begin(), m_deletedNodes.end());
+		m_updatedNodes.clear();
+		m_deletedNodes.clear();
+	}
+
+	void SceneGraph::onNodeCreated(Handle node)
+	{
+		// Copied node data still refers to the source node's proxy, and was not batched itself
+		SceneGraphNodeData & data = getData(node);
+		data.m_bvhProxy = DynamicAABBTree::k_nullProxy;
+		data.m_isStaticBatched = false;
+		data.m_staticBatchPieces.clear();
+		markWorldTransformDirty(node);
+	}
+
+	void SceneGraph::onNodeParentChanged(Handle node)
+	{
+		onSubtreeMoved(node);
+		markWorldTransformDirty(node);
+	}
+
+	void SceneGraph::onNodeDeleted(Handle node)
+	{
+		SceneGraphNodeData & data = getData(node);
+		if (data.m_bvhProxy != DynamicAABBTree::k_nullProxy)
+			m_bvh.destroyProxy(data.m_bvhProxy);
+
+		if (data.m_isStaticBatched)
+			unbatchNode(node);
+
+		if (m_isChangeTrackingEnabled)
+			m_deletedNodes.push_back(node);
+	}
+
+	void SceneGraph::unbatchNode(Handle node)
+	{
+		SceneGraphNodeData & data = getData(node);
+
+		for (const auto & [batchIdx, pieceIdx] : data.m_staticBatchPieces)
+			m_staticBatches[batchIdx].pieces[pieceIdx].numIndices = 0;
+
+		data.m_staticBatchPieces.clear();
+		data.m_isStaticBatched = false;
+	}
+
+	size_t SceneGraph::unbatchSubtree(Handle node)
+	{
+		size_t numUnbatched = 0;
+		if (getData(node).m_isStaticBatched)
+		{
+			unbatchNode(node);
+			++numUnbatched;
+		}
+
+		for (Handle child = getFirstChild(node); child.isValid(); child = getNextSibling(child))
+			numUnbatched += unbatchSubtree(child);
+
+		return numUnbatched;
+	}
+
+	void SceneGraph::onSubtreeMoved(Handle node)
+	{
+		// The batches hold the meshes where they were, moved nodes are drawn from their own meshes again. Their world
+		// transforms are recomputed since the node is marked dirty, which reports them as changed.
+		if (m_staticBatches.empty())
+			return;
+
+		const size_t numUnbatched = unbatchSubtree(node);
+		if (numUnbatched > 0)
+			log(LogLevel::Warning, fmt::format("Took {0} moved nodes out of the static batches, build the batches again to merge them\n", numUnbatched));
+	}
+
+	void SceneGraph::updateNodeWorldTransform(Handle node, const Matrix4 & parentWorldTransform)
+	{
+		SceneGraphNodeData & data = getData(node);
+		data.m_worldTransform = parentWorldTransform * data.m_transform;
+		data.m_isWorldTransformDirty = false;
+
+		// Gather the local mesh bounds and transform them in one batch
+		data.m_meshWorldBounds.resize(data.materialMeshPairs.size());
+		for (size_t idx = 0; idx < data.materialMeshPairs.size(); ++idx)
+		{
+			const Mesh * mesh = data.materialMeshPairs[idx].second->get();
+			data.m_meshWorldBounds[idx] = mesh != nullptr ? mesh->getBoundingBox() : AABB::empty;
+		}
+
+		transformAABBs(data.m_worldTransform, data.m_meshWorldBounds.data(), data.m_meshWorldBounds.data(), data.m_meshWorldBounds.size());
+
+		data.m_worldBounds = AABB::empty;
+		for (const AABB & meshWorldBounds : data.m_meshWorldBounds)
+			data.m_worldBounds.merge(meshWorldBounds);
+
+		updateNodeBVHProxy(node);
+
+		if (m_isChangeTrackingEnabled)
+			m_updatedNodes.push_back(node);
+
+		for (Handle child = getFirstChild(node); child.isValid(); child = getNextSibling(child))
+			updateNodeWorldTransform(child, data.m_worldTransform);
+	}
+
+	void SceneGraph::updateNodeBVHProxy(Handle node)
+	{
+		SceneGraphNodeData & data = getData(node);
+
+		if (data.m_worldBounds.isEmpty())
+		{
+			if (data.m_bvhProxy != DynamicAABBTree::k_nullProxy)
+			{
+				m_bvh.destroyProxy(data.m_bvhProxy);
+				data.m_bvhProxy = DynamicAABBTree::k_nullProxy;
+			}
+		}
+		else if (data.m_bvhProxy == DynamicAABBTree::k_nullProxy)
+			data.m_bvhProxy = m_bvh.createProxy(data.m_worldBounds, (static_cast<uint64_t>(node.index) << 32) | node.generation);
+		else
+			m_bvh.moveProxy(data.m_bvhProxy, data.m_worldBounds);
+	}
+
+	void SceneGraph::markWorldTransformDirty(Handle node)
+	{
+		getData(node).m_isWorldTransformDirty = true;
+		m_dirtyNodes.push_back(node);
 	}
 }
\ No newline at end of file
@@ -1,8 +1,12 @@
 #ifndef SCENE_GRAPH_HPP
 #define SCENE_GRAPH_HPP
 
+#include <memory>
+
 #include "lights.hpp"
 #include "material.hpp"
+#include "math/aabb.hpp"
+#include "math/dynamic_aabb_tree.hpp"
 #include "math/matrix.hpp"
 #include "mesh.hpp"
 #include "utils/asset_object.hpp"
@@ -14,10 +18,81 @@ namespace mud
 	{
 		SceneGraphNodeData();
 
+		// Local transform, relative to the parent node. Set with SceneGraph::setNodeTransform
+		const Matrix4 & getTransform() const;
+
+		// Cached parent world transform * local transform, valid after SceneGraph::updateWorldTransforms
+		const Matrix4 & getWorldTransform() const;
+
+		// World-space bounds of the mesh at the same index in materialMeshPairs
+		const AABB & getMeshWorldBounds(size_t idx) const;
+
+		// World-space bounds of all of this node's meshes
+		const AABB & getWorldBounds() const;
+
+		// True when this node's meshes were merged into the graph's static batches, which then draw them instead. Moving
+		// the node, or one of its ancestors, takes it back out of the batches.
+		bool isStaticBatched() const;
+
+		// Call SceneGraph::invalidateNode after changing it
 		bool isHidden;
-		Matrix4 transform;
+
+		// Marks this node and its descendants as never moving, see SceneGraph::buildStaticBatches
+		bool isStatic;
+
+		// Render layer of this node's meshes, which decides how they are culled, see RenderWorld::setLayerIndex. Not
+		// saved with the graph. Call SceneGraph::invalidateNode after changing it.
+		uint32_t layer;
+
 		std::vector<std::pair<Asset<Material> *, Asset<Mesh> *>> materialMeshPairs;
+
+		// Lower levels of detail, each a complete replacement for materialMeshPairs, from finest to coarsest. The last
+		// can be an impostor, such as a camera-facing quad. Scene picks a level by how large the node appears on
+		// screen. Not saved with the graph, and static batches always draw the full detail.
+		std::vector<std::vector<std::pair<Asset<Material> *, Asset<Mesh> *>>> lodMaterialMeshPairs;
+
+		// Overrides of the scene's level of detail settings: the level always drawn, 0 being materialMeshPairs, or -1
+		// to choose by size, and the on-screen size in pixels below which the node is culled, or below 0 to use the
+		// scene's. Not saved with the graph.
+		int32_t forcedLodLevel;
+		float minPixelSize;
+
 		std::vector<PointLight> pointLights;
+
+	private:
+
+		friend class SceneGraph;
+
+		Matrix4 m_transform;
+		Matrix4 m_worldTransform;
+		bool m_isWorldTransformDirty;
+		std::vector<AABB> m_meshWorldBounds;
+		AABB m_worldBounds;
+		bool m_isStaticBatched;
+
+		// Batch and piece index of each of this node's meshes in the graph's static batches
+		std::vector<std::pair<uint32_t, uint32_t>> m_staticBatchPieces;
+
+		int32_t m_bvhProxy;
+	};
+
+	// The meshes of static nodes sharing a material, transformed to world space and merged into a single mesh
+	struct StaticBatch
+	{
+		// The range of the merged indices coming from one source mesh, so that pieces can still be culled separately.
+		// Pieces of nodes taken out of the batch since are left in place with no indices.
+		struct Piece
+		{
+			uint32_t firstIndex;
+			uint32_t numIndices;
+			AABB worldBounds;
+		};
+
+		Asset<Material> * material;
+		std::unique_ptr<Mesh> mesh;
+
+		// In depth-first node order, so neighbouring pieces tend to be close in space as well as in the index buffer
+		std::vector<Piece> pieces;
 	};
 
 	class SceneGraph : public AssetObject<SceneGraph>, public NodeTree<SceneGraphNodeData>
@@ -28,7 +103,73 @@ namespace mud
 
 		virtual bool serialize(std::ofstream & file) const override;
 
-		static Matrix4 getNodeWorldTransform(const Node & node);
+		void setNodeTransform(Handle node, const Matrix4 & transform);
+
+		// Marks the node's cached world transform and bounds as stale, call after changing its meshes or lights
+		void invalidateNode(Handle node);
+
+		// Brings any stale cached world transforms up to date and returns the node's world transform
+		const Matrix4 & getNodeWorldTransform(Handle node);
+
+		// Restores depth-first node order if the graph was restructured, then recomputes world transforms and bounds of
+		// the subtrees whose local transform or parent changed since the last update
+		void updateWorldTransforms();
+
+		// Hierarchy over the world bounds of every node with meshes, up to date after updateWorldTransforms
+		const DynamicAABBTree & getBVH() const;
+
+		Handle getBVHProxyNode(int32_t proxyId) const;
+
+		// Merges the meshes of every visible node in a static subtree into one StaticBatch per material, with the
+		// vertices pre-transformed to world space. Batched nodes are left to the batches when rendering, so build again
+		// after changing the meshes of static nodes, or copying in static nodes from another graph, whose batches are
+		// not copied. Batched nodes that move or are deleted are taken out of the batches, and draw their own meshes
+		// until the batches are built again. The batches are saved along with the graph.
+		void buildStaticBatches();
+
+		void clearStaticBatches();
+
+		const std::vector<StaticBatch> & getStaticBatches() const;
+
+		// While enabled, the graph records the nodes whose world transform, meshes or lights were brought up to date by
+		// updateWorldTransforms, and the nodes deleted, so that copies of node data kept elsewhere can be updated
+		// incrementally. Off by default.
+		void setChangeTrackingEnabled(bool isEnabled);
+
+		// Moves the nodes recorded since the last call into the vectors. A node can be listed more than once, and
+		// updated nodes may have been deleted since.
+		void takeChanges(std::vector<Handle> & updatedNodes, std::vector<Handle> & deletedNodes);
+
+	protected:
+
+		virtual void onNodeCreated(Handle node) override;
+
+		virtual void onNodeParentChanged(Handle node) override;
+
+		virtual void onNodeDeleted(Handle node) override;
+
+	private:
+
+		void updateNodeWorldTransform(Handle node, const Matrix4 & parentWorldTransform);
+
+		void updateNodeBVHProxy(Handle node);
+
+		void markWorldTransformDirty(Handle node);
+
+		// Empties the node's pieces of the static batches, so that it draws its own meshes again
+		void unbatchNode(Handle node);
+
+		// Unbatches the batched nodes of a subtree that moves with node. Returns how many there were.
+		size_t unbatchSubtree(Handle node);
+
+		void onSubtreeMoved(Handle node);
+
+		std::vector<Handle> m_dirtyNodes;
+		DynamicAABBTree m_bvh;
+		std::vector<StaticBatch> m_staticBatches;
+		bool m_isChangeTrackingEnabled = false;
+		std::vector<Handle> m_updatedNodes;
+		std::vector<Handle> m_deletedNodes;
 	};
 
 	template<>
@@ -6,10 +6,17 @@ layout(push_constant) uniform VertexShaderPushConstants
     mat4 viewMatrix;
 } pushConstants;
 
-layout(set = 0, binding = 0) uniform UniformBufferObject {
+struct Object
+{
     mat4 model;
     mat4 data;
-} ubo;
+};
+
+// Instanced draws start at their first object, so gl_InstanceIndex indexes the whole frame's objects
+layout(std430, set = 0, binding = 0) readonly buffer ObjectsArray
+{
+    Object objects[];
+} objects;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
@@ -21,14 +28,18 @@ layout(location = 1) out vec2 outTextureCoordinates;
 layout(location = 2) out vec3 outWorldPosition;
 layout(location = 3) out vec3 outNormal;
 layout(location = 4) out vec3 outViewPosition;
+layout(location = 5) out float outViewDepth;
 
 void main()
 {
-    outColor = inColor * ubo.data[0];
+    Object object = objects.objects[gl_InstanceIndex];
+
+    outColor = inColor * object.data[0];
     outTextureCoordinates = inTextureCooridnates;
-    outWorldPosition = vec3(ubo.model * vec4(inPosition, 1.0));
-    outNormal = mat3(transpose(inverse(ubo.model))) * inNormal;
+    outWorldPosition = vec3(object.model * vec4(inPosition, 1.0));
+    outNormal = mat3(transpose(inverse(object.model))) * inNormal;
     outViewPosition = -pushConstants.viewMatrix[3].xyz;
+    outViewDepth = -(pushConstants.viewMatrix * vec4(outWorldPosition, 1.0)).z;
 
     gl_Position = pushConstants.projectionMatrix * pushConstants.viewMatrix * vec4(outWorldPosition, 1.0);
 }
\ No newline at end of file
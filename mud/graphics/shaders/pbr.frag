@@ -10,9 +10,8 @@ struct Light_Point
 {
     vec4 position;
     vec4 color;
-    vec4 attenuation;
+    vec4 attenuation; // constant, linear and quadratic factors, and the radius the light is cut off at
 };
-const int MAX_LIGHTS_POINT = 256;
 
 // lights
 
@@ -21,12 +20,24 @@ layout(push_constant) uniform FragmentShaderPushConstants
     layout(offset = 128) Light_Directional directionalLight;
 } pushConstants;
 
-layout(set = 1, binding = 0) uniform LightsArray_Point
+layout(std430, set = 1, binding = 0) readonly buffer LightsArray_Point
 {
-    Light_Point lights[MAX_LIGHTS_POINT];
-    uint num;
+    Light_Point lights[];
 } lights_Point;
 
+// The view frustum is split into clusters, each listing the point lights that reach into it
+layout(std430, set = 1, binding = 1) readonly buffer LightClusters
+{
+    uvec4 size; // clusters along x, y and z
+    vec4 params; // depth slice scale and bias, inverse framebuffer width and height
+    uvec2 clusters[]; // first index into lightIndices and number of lights
+} lightClusters;
+
+layout(std430, set = 1, binding = 2) readonly buffer LightIndices
+{
+    uint indices[];
+} lightIndices;
+
 // material maps
 
 layout(set = 2, binding = 0) uniform sampler2D samplerBaseColor;
@@ -39,6 +50,7 @@ layout(location = 1) in vec2 inTextureCoordinates;
 layout(location = 2) in vec3 inWorldPosition;
 layout(location = 3) in vec3 inNormal;
 layout(location = 4) in vec3 inViewPosition;
+layout(location = 5) in float inViewDepth;
 
 layout(location = 0) out vec4 outColor;
 
@@ -105,6 +117,17 @@ vec3 fresnelSchlick(float cosTheta, vec3 F0)
     return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }
 // ----------------------------------------------------------------------------
+// Clusters are numbered from the top left of the screen, with depth slices exponentially spaced from the near plane
+uvec2 getLightCluster()
+{
+    uvec3 cluster;
+    cluster.xy = uvec2(gl_FragCoord.xy * lightClusters.params.zw * vec2(lightClusters.size.xy));
+    cluster.z = uint(max(log(inViewDepth) * lightClusters.params.x + lightClusters.params.y, 0.0));
+    cluster = min(cluster, lightClusters.size.xyz - 1);
+
+    return lightClusters.clusters[(cluster.z * lightClusters.size.y + cluster.y) * lightClusters.size.x + cluster.x];
+}
+// ----------------------------------------------------------------------------
 void main()
 {		
     vec3 albedo = pow(texture(samplerBaseColor, inTextureCoordinates).rgb, vec3(2.2)); // sRGB to linear space
@@ -123,14 +146,22 @@ void main()
 
     // reflectance equation
     vec3 Lo = vec3(0.0);
-    for(int i = 0; i < lights_Point.num; ++i) 
+    uvec2 cluster = getLightCluster();
+    for(uint i = 0; i < cluster.y; ++i) 
     {
+        Light_Point light = lights_Point.lights[lightIndices.indices[cluster.x + i]];
+
         // calculate per-light radiance
-        vec3 L = normalize(lights_Point.lights[i].position.xyz - inWorldPosition);
+        vec3 L = normalize(light.position.xyz - inWorldPosition);
         vec3 H = normalize(V + L);
-        float distance = length(lights_Point.lights[i].position.xyz - inWorldPosition);
-        float attenuation = 1.0 / (lights_Point.lights[i].attenuation.x + lights_Point.lights[i].attenuation.y * distance + lights_Point.lights[i].attenuation.z * (distance * distance));
-        vec3 radiance = lights_Point.lights[i].color.rgb * attenuation;
+        float distance = length(light.position.xyz - inWorldPosition);
+        float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));
+
+        // fade out towards the cut off radius, so the cluster bounds leave no visible edge
+        float falloff = clamp(1.0 - pow(distance / light.attenuation.w, 4.0), 0.0, 1.0);
+        attenuation *= falloff * falloff;
+
+        vec3 radiance = light.color.rgb * attenuation;
 
         // Cook-Torrance BRDF
         float NDF = DistributionGGX(N, H, roughness);   
@@ -1,8 +1,59 @@
 #include "aabb.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "matrix/matrix_4.hpp"
+
 namespace mud
 {
+    const AABB AABB::empty(Vector3(std::numeric_limits<float>::max()), Vector3(std::numeric_limits<float>::lowest()));
+
     AABB::AABB(const Vector3 & min, const Vector3 & max)
         : min(min), max(max)
     { }
-}
\ No newline at end of file
+
+    bool AABB::isEmpty() const
+    {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
+
+    Vector3 AABB::getCenter() const
+    {
+        return (min + max) * 0.5f;
+    }
+
+    Vector3 AABB::getExtents() const
+    {
+        return (max - min) * 0.5f;
+    }
+
+    void AABB::merge(const AABB & other)
+    {
+        min = Vector3(std::min(min.x, other.min.x), std::min(min.y, other.min.y), std::min(min.z, other.min.z));
+        max = Vector3(std::max(max.x, other.max.x), std::max(max.y, other.max.y), std::max(max.z, other.max.z));
+    }
+
+    AABB AABB::transform(const Matrix4 & matrix) const
+    {
+        if (isEmpty())
+            return empty;
+
+        // Transform the center, then project the extents onto each world axis with the absolute matrix (Arvo)
+        const Vector3 center = getCenter();
+        const Vector3 extents = getExtents();
+
+        Vector3 newCenter(matrix[3].x, matrix[3].y, matrix[3].z);
+        Vector3 newExtents;
+
+        for (unsigned int row = 0; row < 3; ++row)
+            for (unsigned int column = 0; column < 3; ++column)
+            {
+                newCenter[row] += matrix[column][row] * center[column];
+                newExtents[row] += std::fabs(matrix[column][row]) * extents[column];
+            }
+
+        return AABB(newCenter - newExtents, newCenter + newExtents);
+    }
+}
@@ -5,15 +5,31 @@
 
 namespace mud
 {
+    struct Matrix4;
+
     struct AABB
     {
+        // An inverted box that any merge replaces
+        static const AABB empty;
+
         Vector3 min;
         Vector3 max;
 
         AABB() = default;
 
         AABB(const Vector3 & min, const Vector3 & max);
+
+        bool isEmpty() const;
+
+        Vector3 getCenter() const;
+
+        Vector3 getExtents() const;
+
+        void merge(const AABB & other);
+
+        // Returns the AABB enclosing this box after transformation by the matrix
+        AABB transform(const Matrix4 & matrix) const;
     };  
 }
 
-#endif
\ No newline at end of file
+#endif
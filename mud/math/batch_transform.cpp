@@ -0,0 +1,215 @@
+#include "batch_transform.hpp"
+
+#include "simd.hpp"
+
+namespace mud
+{
+    static_assert(sizeof(Vector3) == 3 * sizeof(float) && sizeof(AABB) == 6 * sizeof(float), "Batch kernels expect packed points and boxes");
+
+    namespace
+    {
+        void transformPointsDefault(const Matrix4 & matrix, const Vector3 * in, Vector3 * out, size_t count)
+        {
+            const simd::float4 col0 = simd::load(&matrix.columns[0].x);
+            const simd::float4 col1 = simd::load(&matrix.columns[1].x);
+            const simd::float4 col2 = simd::load(&matrix.columns[2].x);
+            const simd::float4 col3 = simd::load(&matrix.columns[3].x);
+
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                simd::float4 result = simd::multiplyAdd(col0, simd::splat(in[idx].x), col3);
+                result = simd::multiplyAdd(col1, simd::splat(in[idx].y), result);
+                result = simd::multiplyAdd(col2, simd::splat(in[idx].z), result);
+
+                // A 4-wide store would clobber the next input when transforming in place
+                alignas(16) float components[4];
+                simd::store(components, result);
+                out[idx] = Vector3(components[0], components[1], components[2]);
+            }
+        }
+
+        void transformAABBsDefault(const Matrix4 & matrix, const AABB * in, AABB * out, size_t count)
+        {
+            for (size_t idx = 0; idx < count; ++idx)
+                out[idx] = in[idx].transform(matrix);
+        }
+
+        void multiplyMatricesDefault(const Matrix4 * lhs, const Matrix4 * rhs, Matrix4 * out, size_t count)
+        {
+            for (size_t idx = 0; idx < count; ++idx)
+                out[idx] = lhs[idx] * rhs[idx];
+        }
+
+#ifdef MUD_SIMD_AVX2_DISPATCH
+        MUD_SIMD_TARGET_AVX2 void transformPointsAVX2(const Matrix4 & matrix, const Vector3 * in, Vector3 * out, size_t count)
+        {
+            __m256 m[4][3];
+            for (unsigned int col = 0; col < 4; ++col)
+                for (unsigned int row = 0; row < 3; ++row)
+                    m[col][row] = _mm256_set1_ps(matrix[col][row]);
+
+            size_t idx = 0;
+            for (; idx + 8 <= count; idx += 8)
+            {
+                const float * src = &in[idx].x;
+
+                // Deinterleave 8 xyz points into x, y and z registers. Lanes hold the points out of order, but the
+                // same order in all three, and interleaving reverses it
+                const __m256 m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + 0)), _mm_loadu_ps(src + 12), 1);
+                const __m256 m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + 4)), _mm_loadu_ps(src + 16), 1);
+                const __m256 m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + 8)), _mm_loadu_ps(src + 20), 1);
+
+                const __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+                const __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+                const __m256 x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+                const __m256 y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+                const __m256 z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+
+                const __m256 resultX = _mm256_fmadd_ps(m[0][0], x, _mm256_fmadd_ps(m[1][0], y, _mm256_fmadd_ps(m[2][0], z, m[3][0])));
+                const __m256 resultY = _mm256_fmadd_ps(m[0][1], x, _mm256_fmadd_ps(m[1][1], y, _mm256_fmadd_ps(m[2][1], z, m[3][1])));
+                const __m256 resultZ = _mm256_fmadd_ps(m[0][2], x, _mm256_fmadd_ps(m[1][2], y, _mm256_fmadd_ps(m[2][2], z, m[3][2])));
+
+                const __m256 rxy = _mm256_shuffle_ps(resultX, resultY, _MM_SHUFFLE(2, 0, 2, 0));
+                const __m256 ryz = _mm256_shuffle_ps(resultY, resultZ, _MM_SHUFFLE(3, 1, 3, 1));
+                const __m256 rzx = _mm256_shuffle_ps(resultZ, resultX, _MM_SHUFFLE(3, 1, 2, 0));
+                const __m256 r03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+                const __m256 r14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+                const __m256 r25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+
+                float * dst = &out[idx].x;
+                _mm_storeu_ps(dst + 0, _mm256_castps256_ps128(r03));
+                _mm_storeu_ps(dst + 4, _mm256_castps256_ps128(r14));
+                _mm_storeu_ps(dst + 8, _mm256_castps256_ps128(r25));
+                _mm_storeu_ps(dst + 12, _mm256_extractf128_ps(r03, 1));
+                _mm_storeu_ps(dst + 16, _mm256_extractf128_ps(r14, 1));
+                _mm_storeu_ps(dst + 20, _mm256_extractf128_ps(r25, 1));
+            }
+
+            transformPointsDefault(matrix, in + idx, out + idx, count - idx);
+        }
+
+        MUD_SIMD_TARGET_AVX2 void transformAABBsAVX2(const Matrix4 & matrix, const AABB * in, AABB * out, size_t count)
+        {
+            // Two boxes per iteration, one in each 128-bit half
+            const __m256 col0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&matrix.columns[0].x));
+            const __m256 col1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&matrix.columns[1].x));
+            const __m256 col2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&matrix.columns[2].x));
+            const __m256 col3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&matrix.columns[3].x));
+
+            const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+            const __m256 absCol0 = _mm256_and_ps(col0, absMask);
+            const __m256 absCol1 = _mm256_and_ps(col1, absMask);
+            const __m256 absCol2 = _mm256_and_ps(col2, absMask);
+            const __m256 half = _mm256_set1_ps(0.5f);
+
+            size_t idx = 0;
+            for (; idx + 2 <= count; idx += 2)
+            {
+                const float * src = &in[idx].min.x;
+
+                // A box is 6 floats: loading at +0 gives min (and max.x), loading at +2 gives max (after min.z). Neither
+                // load reads past the box
+                const __m256 lower = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + 0)), _mm_loadu_ps(src + 6), 1);
+                const __m256 upper = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + 2)), _mm_loadu_ps(src + 8), 1);
+
+                const __m256 min = lower;
+                const __m256 max = _mm256_permute_ps(upper, _MM_SHUFFLE(3, 3, 2, 1));
+
+                // Empty boxes stay empty, leave them to the scalar path
+                if ((_mm256_movemask_ps(_mm256_cmp_ps(min, max, _CMP_GT_OQ)) & 0x77) != 0)
+                {
+                    transformAABBsDefault(matrix, in + idx, out + idx, 2);
+                    continue;
+                }
+
+                const __m256 center = _mm256_mul_ps(_mm256_add_ps(min, max), half);
+                const __m256 extents = _mm256_mul_ps(_mm256_sub_ps(max, min), half);
+
+                const __m256 newCenter = _mm256_fmadd_ps(col0, _mm256_permute_ps(center, 0x00),
+                    _mm256_fmadd_ps(col1, _mm256_permute_ps(center, 0x55), _mm256_fmadd_ps(col2, _mm256_permute_ps(center, 0xAA), col3)));
+                const __m256 newExtents = _mm256_fmadd_ps(absCol0, _mm256_permute_ps(extents, 0x00),
+                    _mm256_fmadd_ps(absCol1, _mm256_permute_ps(extents, 0x55), _mm256_mul_ps(absCol2, _mm256_permute_ps(extents, 0xAA))));
+
+                const __m256 newMin = _mm256_sub_ps(newCenter, newExtents);
+                const __m256 newMax = _mm256_add_ps(newCenter, newExtents);
+
+                // { min.z, max.x, max.y, max.z } to store at +2, after the min store at +0 has written min.xyz
+                const __m256 minZMaxX = _mm256_shuffle_ps(newMin, newMax, _MM_SHUFFLE(0, 0, 2, 2));
+                const __m256 newUpper = _mm256_shuffle_ps(minZMaxX, newMax, _MM_SHUFFLE(2, 1, 2, 0));
+
+                float * dst = &out[idx].min.x;
+                _mm_storeu_ps(dst + 0, _mm256_castps256_ps128(newMin));
+                _mm_storeu_ps(dst + 2, _mm256_castps256_ps128(newUpper));
+                _mm_storeu_ps(dst + 6, _mm256_extractf128_ps(newMin, 1));
+                _mm_storeu_ps(dst + 8, _mm256_extractf128_ps(newUpper, 1));
+            }
+
+            transformAABBsDefault(matrix, in + idx, out + idx, count - idx);
+        }
+
+        MUD_SIMD_TARGET_AVX2 void multiplyMatricesAVX2(const Matrix4 * lhs, const Matrix4 * rhs, Matrix4 * out, size_t count)
+        {
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                const __m256 lhs0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&lhs[idx].columns[0].x));
+                const __m256 lhs1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&lhs[idx].columns[1].x));
+                const __m256 lhs2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&lhs[idx].columns[2].x));
+                const __m256 lhs3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&lhs[idx].columns[3].x));
+
+                // Two result columns at a time, each weighted by the elements of the matching rhs column in its half
+                const __m256 rhs01 = _mm256_loadu_ps(&rhs[idx].columns[0].x);
+                const __m256 rhs23 = _mm256_loadu_ps(&rhs[idx].columns[2].x);
+
+                const __m256 result01 = _mm256_fmadd_ps(lhs0, _mm256_permute_ps(rhs01, 0x00), _mm256_fmadd_ps(lhs1, _mm256_permute_ps(rhs01, 0x55),
+                    _mm256_fmadd_ps(lhs2, _mm256_permute_ps(rhs01, 0xAA), _mm256_mul_ps(lhs3, _mm256_permute_ps(rhs01, 0xFF)))));
+                const __m256 result23 = _mm256_fmadd_ps(lhs0, _mm256_permute_ps(rhs23, 0x00), _mm256_fmadd_ps(lhs1, _mm256_permute_ps(rhs23, 0x55),
+                    _mm256_fmadd_ps(lhs2, _mm256_permute_ps(rhs23, 0xAA), _mm256_mul_ps(lhs3, _mm256_permute_ps(rhs23, 0xFF)))));
+
+                _mm256_storeu_ps(&out[idx].columns[0].x, result01);
+                _mm256_storeu_ps(&out[idx].columns[2].x, result23);
+            }
+        }
+#endif
+
+        struct Kernels
+        {
+            void (*transformPoints)(const Matrix4 &, const Vector3 *, Vector3 *, size_t);
+            void (*transformAABBs)(const Matrix4 &, const AABB *, AABB *, size_t);
+            void (*multiplyMatrices)(const Matrix4 *, const Matrix4 *, Matrix4 *, size_t);
+            bool isAVX2;
+        };
+
+        const Kernels & getKernels()
+        {
+            static const Kernels kernels = []() {
+#ifdef MUD_SIMD_AVX2_DISPATCH
+                if (simd::isAVX2Supported())
+                    return Kernels{ transformPointsAVX2, transformAABBsAVX2, multiplyMatricesAVX2, true };
+#endif
+                return Kernels{ transformPointsDefault, transformAABBsDefault, multiplyMatricesDefault, false };
+            }();
+
+            return kernels;
+        }
+    }
+
+    void transformPoints(const Matrix4 & matrix, const Vector3 * in, Vector3 * out, size_t count)
+    {
+        getKernels().transformPoints(matrix, in, out, count);
+    }
+
+    void transformAABBs(const Matrix4 & matrix, const AABB * in, AABB * out, size_t count)
+    {
+        getKernels().transformAABBs(matrix, in, out, count);
+    }
+
+    void multiplyMatrices(const Matrix4 * lhs, const Matrix4 * rhs, Matrix4 * out, size_t count)
+    {
+        getKernels().multiplyMatrices(lhs, rhs, out, count);
+    }
+
+    bool isBatchTransformAVX2Enabled()
+    {
+        return getKernels().isAVX2;
+    }
+}
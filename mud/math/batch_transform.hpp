@@ -0,0 +1,28 @@
+#ifndef MUD_BATCH_TRANSFORM_HPP
+#define MUD_BATCH_TRANSFORM_HPP
+
+#include <cstddef>
+
+#include "aabb.hpp"
+#include "matrix/matrix_4.hpp"
+#include "vector/vector_3.hpp"
+
+// Transform kernels over arrays. They run 8 (points) or 2 (boxes, matrices) elements at a time with AVX2 and FMA when
+// the CPU supports them, chosen once at runtime, and fall back to the 4-wide math otherwise. Input and output arrays
+// may be the same array, but must not otherwise overlap.
+namespace mud
+{
+    // out[i] = matrix * (in[i], 1). The result is not divided by w, so the matrix should be affine.
+    void transformPoints(const Matrix4 & matrix, const Vector3 * in, Vector3 * out, size_t count);
+
+    // out[i] = in[i].transform(matrix)
+    void transformAABBs(const Matrix4 & matrix, const AABB * in, AABB * out, size_t count);
+
+    // out[i] = lhs[i] * rhs[i]
+    void multiplyMatrices(const Matrix4 * lhs, const Matrix4 * rhs, Matrix4 * out, size_t count);
+
+    // True if the AVX2 kernels were selected
+    bool isBatchTransformAVX2Enabled();
+}
+
+#endif
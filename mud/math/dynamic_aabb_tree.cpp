@@ -0,0 +1,331 @@
+#include "dynamic_aabb_tree.hpp"
+
+#include <cmath>
+
+namespace mud
+{
+    namespace
+    {
+        // Fat AABBs are grown by a fraction of their size plus a constant so static and slowly moving proxies rarely
+        // need re-inserting
+        constexpr float k_fatAABBRelativeMargin = 0.1f;
+        constexpr float k_fatAABBAbsoluteMargin = 0.05f;
+    }
+
+    DynamicAABBTree::DynamicAABBTree()
+        : m_root(k_nullProxy), m_freeList(k_nullProxy), m_numProxies(0)
+    { }
+
+    int32_t DynamicAABBTree::createProxy(const AABB & aabb, uint64_t userData)
+    {
+        const int32_t proxyId = allocateNode();
+
+        const Vector3 margin = (aabb.max - aabb.min) * k_fatAABBRelativeMargin + Vector3(k_fatAABBAbsoluteMargin);
+        m_nodes[proxyId].aabb = AABB(aabb.min - margin, aabb.max + margin);
+        m_nodes[proxyId].userData = userData;
+        m_nodes[proxyId].height = 0;
+
+        insertLeaf(proxyId);
+        ++m_numProxies;
+
+        return proxyId;
+    }
+
+    void DynamicAABBTree::destroyProxy(int32_t proxyId)
+    {
+        removeLeaf(proxyId);
+        freeNode(proxyId);
+        --m_numProxies;
+    }
+
+    bool DynamicAABBTree::moveProxy(int32_t proxyId, const AABB & aabb)
+    {
+        const AABB & fatAABB = m_nodes[proxyId].aabb;
+        if (fatAABB.min.x <= aabb.min.x && fatAABB.min.y <= aabb.min.y && fatAABB.min.z <= aabb.min.z &&
+            aabb.max.x <= fatAABB.max.x && aabb.max.y <= fatAABB.max.y && aabb.max.z <= fatAABB.max.z)
+            return false;
+
+        removeLeaf(proxyId);
+
+        const Vector3 margin = (aabb.max - aabb.min) * k_fatAABBRelativeMargin + Vector3(k_fatAABBAbsoluteMargin);
+        m_nodes[proxyId].aabb = AABB(aabb.min - margin, aabb.max + margin);
+
+        insertLeaf(proxyId);
+        return true;
+    }
+
+    uint64_t DynamicAABBTree::getUserData(int32_t proxyId) const
+    {
+        return m_nodes[proxyId].userData;
+    }
+
+    const AABB & DynamicAABBTree::getFatAABB(int32_t proxyId) const
+    {
+        return m_nodes[proxyId].aabb;
+    }
+
+    size_t DynamicAABBTree::getNumProxies() const
+    {
+        return m_numProxies;
+    }
+
+    int32_t DynamicAABBTree::getHeight() const
+    {
+        return m_root == k_nullProxy ? 0 : m_nodes[m_root].height;
+    }
+
+    bool DynamicAABBTree::overlaps(const AABB & a, const AABB & b)
+    {
+        return a.min.x <= b.max.x && b.min.x <= a.max.x &&
+            a.min.y <= b.max.y && b.min.y <= a.max.y &&
+            a.min.z <= b.max.z && b.min.z <= a.max.z;
+    }
+
+    bool DynamicAABBTree::overlapsSphere(const AABB & aabb, const Vector3 & center, float radius)
+    {
+        const Vector3 closestPoint(
+            std::clamp(center.x, aabb.min.x, aabb.max.x),
+            std::clamp(center.y, aabb.min.y, aabb.max.y),
+            std::clamp(center.z, aabb.min.z, aabb.max.z));
+
+        const Vector3 delta = closestPoint - center;
+        return delta.dot(delta) <= radius * radius;
+    }
+
+    bool DynamicAABBTree::rayCastAABB(const AABB & aabb, const Vector3 & origin, const Vector3 & inverseDirection, float maxDistance, float & entryDistance)
+    {
+        float tMin = 0;
+        float tMax = maxDistance;
+
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            float t1 = (aabb.min[axis] - origin[axis]) * inverseDirection[axis];
+            float t2 = (aabb.max[axis] - origin[axis]) * inverseDirection[axis];
+
+            if (t1 > t2)
+                std::swap(t1, t2);
+
+            // NaN (origin on a slab of a direction-parallel axis) fails both comparisons and keeps the ray alive
+            if (t1 > tMin)
+                tMin = t1;
+            if (t2 < tMax)
+                tMax = t2;
+
+            if (tMin > tMax)
+                return false;
+        }
+
+        entryDistance = tMin;
+        return true;
+    }
+
+    float DynamicAABBTree::getSurfaceArea(const AABB & aabb)
+    {
+        const Vector3 size = aabb.max - aabb.min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    AABB DynamicAABBTree::merged(const AABB & a, const AABB & b)
+    {
+        AABB result = a;
+        result.merge(b);
+        return result;
+    }
+
+    int32_t DynamicAABBTree::allocateNode()
+    {
+        int32_t nodeId;
+        if (m_freeList != k_nullProxy)
+        {
+            nodeId = m_freeList;
+            m_freeList = m_nodes[nodeId].parentOrNext;
+        }
+        else
+        {
+            nodeId = static_cast<int32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+
+        Node & node = m_nodes[nodeId];
+        node.userData = 0;
+        node.parentOrNext = k_nullProxy;
+        node.child1 = k_nullProxy;
+        node.child2 = k_nullProxy;
+        node.height = 0;
+
+        return nodeId;
+    }
+
+    void DynamicAABBTree::freeNode(int32_t nodeId)
+    {
+        m_nodes[nodeId].parentOrNext = m_freeList;
+        m_nodes[nodeId].height = -1;
+        m_freeList = nodeId;
+    }
+
+    void DynamicAABBTree::insertLeaf(int32_t leaf)
+    {
+        if (m_root == k_nullProxy)
+        {
+            m_root = leaf;
+            m_nodes[leaf].parentOrNext = k_nullProxy;
+            return;
+        }
+
+        // Descend towards the sibling with the lowest surface area cost
+        const AABB leafAABB = m_nodes[leaf].aabb;
+        int32_t sibling = m_root;
+
+        while (!m_nodes[sibling].isLeaf())
+        {
+            const Node & node = m_nodes[sibling];
+
+            const float area = getSurfaceArea(node.aabb);
+            const float combinedArea = getSurfaceArea(merged(node.aabb, leafAABB));
+
+            // Cost of making a new parent for this node and the leaf, and the minimum cost of pushing the leaf further down
+            const float cost = 2.0f * combinedArea;
+            const float inheritanceCost = 2.0f * (combinedArea - area);
+
+            auto getDescentCost = [&](int32_t child)
+            {
+                const AABB & childAABB = m_nodes[child].aabb;
+                const float newArea = getSurfaceArea(merged(childAABB, leafAABB));
+                return m_nodes[child].isLeaf() ? newArea + inheritanceCost : newArea - getSurfaceArea(childAABB) + inheritanceCost;
+            };
+
+            const float cost1 = getDescentCost(node.child1);
+            const float cost2 = getDescentCost(node.child2);
+
+            if (cost < cost1 && cost < cost2)
+                break;
+
+            sibling = cost1 < cost2 ? node.child1 : node.child2;
+        }
+
+        const int32_t oldParent = m_nodes[sibling].parentOrNext;
+        const int32_t newParent = allocateNode();
+
+        m_nodes[newParent].parentOrNext = oldParent;
+        m_nodes[newParent].aabb = merged(leafAABB, m_nodes[sibling].aabb);
+        m_nodes[newParent].height = m_nodes[sibling].height + 1;
+        m_nodes[newParent].child1 = sibling;
+        m_nodes[newParent].child2 = leaf;
+        m_nodes[sibling].parentOrNext = newParent;
+        m_nodes[leaf].parentOrNext = newParent;
+
+        if (oldParent != k_nullProxy)
+        {
+            if (m_nodes[oldParent].child1 == sibling)
+                m_nodes[oldParent].child1 = newParent;
+            else
+                m_nodes[oldParent].child2 = newParent;
+        }
+        else
+            m_root = newParent;
+
+        // Refit and rebalance ancestors
+        for (int32_t nodeId = m_nodes[leaf].parentOrNext; nodeId != k_nullProxy; nodeId = m_nodes[nodeId].parentOrNext)
+        {
+            nodeId = balance(nodeId);
+
+            Node & node = m_nodes[nodeId];
+            node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+            node.aabb = merged(m_nodes[node.child1].aabb, m_nodes[node.child2].aabb);
+        }
+    }
+
+    void DynamicAABBTree::removeLeaf(int32_t leaf)
+    {
+        if (leaf == m_root)
+        {
+            m_root = k_nullProxy;
+            return;
+        }
+
+        const int32_t parent = m_nodes[leaf].parentOrNext;
+        const int32_t grandParent = m_nodes[parent].parentOrNext;
+        const int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+        // The sibling replaces the parent
+        if (grandParent != k_nullProxy)
+        {
+            if (m_nodes[grandParent].child1 == parent)
+                m_nodes[grandParent].child1 = sibling;
+            else
+                m_nodes[grandParent].child2 = sibling;
+            m_nodes[sibling].parentOrNext = grandParent;
+            freeNode(parent);
+
+            for (int32_t nodeId = grandParent; nodeId != k_nullProxy; nodeId = m_nodes[nodeId].parentOrNext)
+            {
+                nodeId = balance(nodeId);
+
+                Node & node = m_nodes[nodeId];
+                node.aabb = merged(m_nodes[node.child1].aabb, m_nodes[node.child2].aabb);
+                node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+            }
+        }
+        else
+        {
+            m_root = sibling;
+            m_nodes[sibling].parentOrNext = k_nullProxy;
+            freeNode(parent);
+        }
+    }
+
+    int32_t DynamicAABBTree::balance(int32_t a)
+    {
+        // Rotates the taller grandchild up if A's children differ in height by more than one, returns the new subtree root
+        Node & nodeA = m_nodes[a];
+        if (nodeA.isLeaf() || nodeA.height < 2)
+            return a;
+
+        const int32_t b = nodeA.child1;
+        const int32_t c = nodeA.child2;
+        const int32_t heightDifference = m_nodes[c].height - m_nodes[b].height;
+
+        if (heightDifference > 1 || heightDifference < -1)
+        {
+            // Rotate the taller child (up) into A's place, its taller child (upUp) stays, its shorter one (upDown) moves to A
+            const int32_t up = heightDifference > 1 ? c : b;
+            const int32_t down = heightDifference > 1 ? b : c;
+
+            Node & nodeUp = m_nodes[up];
+            const int32_t upChild1 = nodeUp.child1;
+            const int32_t upChild2 = nodeUp.child2;
+
+            nodeUp.child1 = a;
+            nodeUp.parentOrNext = nodeA.parentOrNext;
+            nodeA.parentOrNext = up;
+
+            if (nodeUp.parentOrNext != k_nullProxy)
+            {
+                if (m_nodes[nodeUp.parentOrNext].child1 == a)
+                    m_nodes[nodeUp.parentOrNext].child1 = up;
+                else
+                    m_nodes[nodeUp.parentOrNext].child2 = up;
+            }
+            else
+                m_root = up;
+
+            const bool isChild1Taller = m_nodes[upChild1].height > m_nodes[upChild2].height;
+            const int32_t upUp = isChild1Taller ? upChild1 : upChild2;
+            const int32_t upDown = isChild1Taller ? upChild2 : upChild1;
+
+            nodeUp.child2 = upUp;
+            nodeA.child1 = down;
+            nodeA.child2 = upDown;
+            m_nodes[upDown].parentOrNext = a;
+
+            nodeA.aabb = merged(m_nodes[down].aabb, m_nodes[upDown].aabb);
+            nodeA.height = 1 + std::max(m_nodes[down].height, m_nodes[upDown].height);
+            nodeUp.aabb = merged(nodeA.aabb, m_nodes[upUp].aabb);
+            nodeUp.height = 1 + std::max(nodeA.height, m_nodes[upUp].height);
+
+            return up;
+        }
+
+        return a;
+    }
+}
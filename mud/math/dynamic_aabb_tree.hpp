@@ -0,0 +1,203 @@
+#ifndef MUD_DYNAMIC_AABB_TREE_HPP
+#define MUD_DYNAMIC_AABB_TREE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "aabb.hpp"
+
+namespace mud
+{
+    // Bounding volume hierarchy over dynamic AABBs. Leaves store enlarged ("fat") boxes so small movements do not
+    // touch the tree; a leaf is only removed and re-inserted once its box leaves the fat box. Insertion picks the
+    // sibling by surface area cost and rebalances with tree rotations on the way back up.
+    class DynamicAABBTree
+    {
+    public:
+
+        static constexpr int32_t k_nullProxy = -1;
+
+        DynamicAABBTree();
+
+        int32_t createProxy(const AABB & aabb, uint64_t userData);
+
+        void destroyProxy(int32_t proxyId);
+
+        // Returns true if the proxy had to be re-inserted
+        bool moveProxy(int32_t proxyId, const AABB & aabb);
+
+        uint64_t getUserData(int32_t proxyId) const;
+
+        const AABB & getFatAABB(int32_t proxyId) const;
+
+        size_t getNumProxies() const;
+
+        int32_t getHeight() const;
+
+        // Calls callback(proxyId) for every proxy whose fat AABB overlaps the box. Return false to stop the query.
+        template<typename Callback>
+        void queryAABB(const AABB & aabb, Callback callback) const
+        {
+            query([&](const AABB & nodeAABB) { return overlaps(nodeAABB, aabb); }, callback);
+        }
+
+        // Calls callback(proxyId) for every proxy whose fat AABB overlaps the sphere. Return false to stop the query.
+        template<typename Callback>
+        void querySphere(const Vector3 & center, float radius, Callback callback) const
+        {
+            query([&](const AABB & nodeAABB) { return overlapsSphere(nodeAABB, center, radius); }, callback);
+        }
+
+        // Visits proxies hit by the ray in front-to-back order of their fat AABBs. callback(proxyId, maxDistance)
+        // returns the new maximum distance: return the hit distance to clip the ray, maxDistance to carry on, or 0
+        // to stop. Distances are in units of the (not necessarily normalised) ray direction.
+        template<typename Callback>
+        void rayCast(const Vector3 & origin, const Vector3 & direction, float maxDistance, Callback callback) const
+        {
+            if (m_root == k_nullProxy)
+                return;
+
+            const Vector3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+            struct StackEntry
+            {
+                int32_t node;
+                float entryDistance;
+            };
+
+            std::vector<StackEntry> stack;
+            stack.reserve(64);
+
+            float entryDistance = 0;
+            if (rayCastAABB(m_nodes[m_root].aabb, origin, inverseDirection, maxDistance, entryDistance))
+                stack.push_back({ m_root, entryDistance });
+
+            while (!stack.empty())
+            {
+                const StackEntry entry = stack.back();
+                stack.pop_back();
+
+                // The ray was clipped by a nearer hit since this node was pushed
+                if (entry.entryDistance > maxDistance)
+                    continue;
+
+                const Node & node = m_nodes[entry.node];
+
+                if (node.isLeaf())
+                {
+                    maxDistance = std::min(maxDistance, callback(entry.node, maxDistance));
+                    if (maxDistance <= 0)
+                        return;
+                    continue;
+                }
+
+                float entryDistance1 = 0;
+                float entryDistance2 = 0;
+                const bool isHit1 = rayCastAABB(m_nodes[node.child1].aabb, origin, inverseDirection, maxDistance, entryDistance1);
+                const bool isHit2 = rayCastAABB(m_nodes[node.child2].aabb, origin, inverseDirection, maxDistance, entryDistance2);
+
+                // Push the farther child first so the nearer one is visited first
+                if (isHit1 && isHit2)
+                {
+                    if (entryDistance1 < entryDistance2)
+                    {
+                        stack.push_back({ node.child2, entryDistance2 });
+                        stack.push_back({ node.child1, entryDistance1 });
+                    }
+                    else
+                    {
+                        stack.push_back({ node.child1, entryDistance1 });
+                        stack.push_back({ node.child2, entryDistance2 });
+                    }
+                }
+                else if (isHit1)
+                    stack.push_back({ node.child1, entryDistance1 });
+                else if (isHit2)
+                    stack.push_back({ node.child2, entryDistance2 });
+            }
+        }
+
+    private:
+
+        struct Node
+        {
+            AABB aabb;
+            uint64_t userData;
+
+            // Parent node, or the next free node while the node is in the free list
+            int32_t parentOrNext;
+
+            int32_t child1;
+            int32_t child2;
+
+            // Leaves have height 0, free nodes -1
+            int32_t height;
+
+            bool isLeaf() const
+            {
+                return child1 == k_nullProxy;
+            }
+        };
+
+        static bool overlaps(const AABB & a, const AABB & b);
+
+        static bool overlapsSphere(const AABB & aabb, const Vector3 & center, float radius);
+
+        static bool rayCastAABB(const AABB & aabb, const Vector3 & origin, const Vector3 & inverseDirection, float maxDistance, float & entryDistance);
+
+        static float getSurfaceArea(const AABB & aabb);
+
+        static AABB merged(const AABB & a, const AABB & b);
+
+        template<typename Predicate, typename Callback>
+        void query(Predicate predicate, Callback callback) const
+        {
+            if (m_root == k_nullProxy)
+                return;
+
+            std::vector<int32_t> stack;
+            stack.reserve(64);
+            stack.push_back(m_root);
+
+            while (!stack.empty())
+            {
+                const Node & node = m_nodes[stack.back()];
+                const int32_t nodeId = stack.back();
+                stack.pop_back();
+
+                if (!predicate(node.aabb))
+                    continue;
+
+                if (node.isLeaf())
+                {
+                    if (!callback(nodeId))
+                        return;
+                }
+                else
+                {
+                    stack.push_back(node.child1);
+                    stack.push_back(node.child2);
+                }
+            }
+        }
+
+        int32_t allocateNode();
+
+        void freeNode(int32_t nodeId);
+
+        void insertLeaf(int32_t leaf);
+
+        void removeLeaf(int32_t leaf);
+
+        int32_t balance(int32_t nodeId);
+
+        std::vector<Node> m_nodes;
+        int32_t m_root;
+        int32_t m_freeList;
+        size_t m_numProxies;
+    };
+}
+
+#endif
@@ -0,0 +1,47 @@
+#include "frustum.hpp"
+
+#include <cmath>
+
+namespace mud
+{
+    Frustum::Frustum(const Matrix4 & projectionView)
+    {
+        const Vector4 row0 = projectionView.getRow(0);
+        const Vector4 row1 = projectionView.getRow(1);
+        const Vector4 row2 = projectionView.getRow(2);
+        const Vector4 row3 = projectionView.getRow(3);
+
+        const Vector4 planes[k_numPlanes] = {
+            row3 + row0,
+            row3 - row0,
+            row3 + row1,
+            row3 - row1,
+            row3 + row2,
+            row3 - row2
+        };
+
+        for (unsigned int idx = 0; idx < 8; ++idx)
+        {
+            if (idx < k_numPlanes)
+            {
+                const Vector4 & plane = planes[idx];
+                const float inverseLength = 1.0f / std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+
+                normalX[idx] = plane.x * inverseLength;
+                normalY[idx] = plane.y * inverseLength;
+                normalZ[idx] = plane.z * inverseLength;
+                distance[idx] = plane.w * inverseLength;
+            }
+            else
+            {
+                normalX[idx] = normalY[idx] = normalZ[idx] = 0.0f;
+                distance[idx] = 1.0f;
+            }
+        }
+    }
+
+    Vector4 Frustum::getPlane(unsigned int idx) const
+    {
+        return Vector4(normalX[idx], normalY[idx], normalZ[idx], distance[idx]);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef MUD_FRUSTUM_HPP
+#define MUD_FRUSTUM_HPP
+
+#include "matrix/matrix_4.hpp"
+#include "vector/vector_4.hpp"
+
+namespace mud
+{
+    struct Frustum
+    {
+        static constexpr unsigned int k_numPlanes = 6;
+
+        // Planes are stored as structure-of-arrays, padded to two groups of four so they can be tested four at a
+        // time. Plane normals point into the frustum; padding planes accept everything.
+        alignas(16) float normalX[8];
+        alignas(16) float normalY[8];
+        alignas(16) float normalZ[8];
+        alignas(16) float distance[8];
+
+        Frustum() = default;
+
+        // Extracts the left, right, bottom, top, near and far planes of a projection-view matrix (Gribb/Hartmann)
+        Frustum(const Matrix4 & projectionView);
+
+        Vector4 getPlane(unsigned int idx) const;
+    };
+}
+
+#endif
@@ -2,10 +2,193 @@
 
 #include <cmath>
 
+#include "simd.hpp"
 #include "utils/logger.hpp"
 
 namespace mud::intersection_test
 {
+    namespace
+    {
+        constexpr float k_rayCastTriangleEpsilon = 0.000001f;
+
+        // Tests the 4 rays starting at lane offset of the packet
+        template<size_t N>
+        uint32_t rayCastTriangleLanes(const RayPacket<N> & rays, size_t offset, const Vector3 & p0, const Vector3 & p1, const Vector3 & p2, float * hitDistances, bool cullBackFaces)
+        {
+            const Vector3 p0p1 = p1 - p0;
+            const Vector3 p0p2 = p2 - p0;
+
+            const simd::float4 directionX = simd::load(rays.directionX + offset);
+            const simd::float4 directionY = simd::load(rays.directionY + offset);
+            const simd::float4 directionZ = simd::load(rays.directionZ + offset);
+
+            // pvec = direction x p0p2
+            const simd::float4 pvecX = simd::sub(simd::mul(directionY, simd::splat(p0p2.z)), simd::mul(directionZ, simd::splat(p0p2.y)));
+            const simd::float4 pvecY = simd::sub(simd::mul(directionZ, simd::splat(p0p2.x)), simd::mul(directionX, simd::splat(p0p2.z)));
+            const simd::float4 pvecZ = simd::sub(simd::mul(directionX, simd::splat(p0p2.y)), simd::mul(directionY, simd::splat(p0p2.x)));
+
+            const simd::float4 det = simd::multiplyAdd(simd::splat(p0p1.z), pvecZ, simd::multiplyAdd(simd::splat(p0p1.y), pvecY, simd::mul(simd::splat(p0p1.x), pvecX)));
+            const simd::float4 epsilon = simd::splat(k_rayCastTriangleEpsilon);
+            simd::float4 valid = simd::greaterEqual(cullBackFaces ? det : simd::abs(det), epsilon);
+
+            const simd::float4 invDet = simd::div(simd::splat(1.0f), det);
+
+            const simd::float4 tvecX = simd::sub(simd::load(rays.originX + offset), simd::splat(p0.x));
+            const simd::float4 tvecY = simd::sub(simd::load(rays.originY + offset), simd::splat(p0.y));
+            const simd::float4 tvecZ = simd::sub(simd::load(rays.originZ + offset), simd::splat(p0.z));
+
+            const simd::float4 zero = simd::splat(0.0f);
+            const simd::float4 one = simd::splat(1.0f);
+
+            const simd::float4 u = simd::mul(simd::multiplyAdd(tvecZ, pvecZ, simd::multiplyAdd(tvecY, pvecY, simd::mul(tvecX, pvecX))), invDet);
+            valid = simd::bitAnd(valid, simd::bitAnd(simd::greaterEqual(u, zero), simd::lessEqual(u, one)));
+
+            // qvec = tvec x p0p1
+            const simd::float4 qvecX = simd::sub(simd::mul(tvecY, simd::splat(p0p1.z)), simd::mul(tvecZ, simd::splat(p0p1.y)));
+            const simd::float4 qvecY = simd::sub(simd::mul(tvecZ, simd::splat(p0p1.x)), simd::mul(tvecX, simd::splat(p0p1.z)));
+            const simd::float4 qvecZ = simd::sub(simd::mul(tvecX, simd::splat(p0p1.y)), simd::mul(tvecY, simd::splat(p0p1.x)));
+
+            const simd::float4 v = simd::mul(simd::multiplyAdd(directionZ, qvecZ, simd::multiplyAdd(directionY, qvecY, simd::mul(directionX, qvecX))), invDet);
+            valid = simd::bitAnd(valid, simd::bitAnd(simd::greaterEqual(v, zero), simd::lessEqual(simd::add(u, v), one)));
+
+            const simd::float4 t = simd::mul(simd::multiplyAdd(simd::splat(p0p2.z), qvecZ, simd::multiplyAdd(simd::splat(p0p2.y), qvecY, simd::mul(simd::splat(p0p2.x), qvecX))), invDet);
+            const simd::float4 nearest = simd::loadUnaligned(hitDistances);
+            valid = simd::bitAnd(valid, simd::bitAnd(simd::greaterEqual(t, zero), simd::lessThan(t, nearest)));
+
+            simd::storeUnaligned(hitDistances, simd::select(valid, t, nearest));
+            return static_cast<uint32_t>(simd::moveMask(valid));
+        }
+
+        // Tests the 4 rays starting at lane offset of the packet. min/max keep their second operand when the first is
+        // NaN, which happens for rays parallel to a slab that start on one of its planes.
+        template<size_t N>
+        uint32_t rayCastAABBLanes(const RayPacket<N> & rays, size_t offset, const AABB & aabb, const float * maxDistances)
+        {
+            simd::float4 tNear = simd::splat(0.0f);
+            simd::float4 tFar = simd::loadUnaligned(maxDistances);
+
+            const float * origins[3] = { rays.originX + offset, rays.originY + offset, rays.originZ + offset };
+            const float * inverseDirections[3] = { rays.inverseDirectionX + offset, rays.inverseDirectionY + offset, rays.inverseDirectionZ + offset };
+
+            for (unsigned int axis = 0; axis < 3; ++axis)
+            {
+                const simd::float4 origin = simd::load(origins[axis]);
+                const simd::float4 inverseDirection = simd::load(inverseDirections[axis]);
+                const simd::float4 t1 = simd::mul(simd::sub(simd::splat(aabb.min[axis]), origin), inverseDirection);
+                const simd::float4 t2 = simd::mul(simd::sub(simd::splat(aabb.max[axis]), origin), inverseDirection);
+
+                tNear = simd::max(simd::min(t1, t2), tNear);
+                tFar = simd::min(simd::max(t1, t2), tFar);
+            }
+
+            return static_cast<uint32_t>(simd::moveMask(simd::lessEqual(tNear, tFar)));
+        }
+
+#ifdef MUD_SIMD_AVX2_DISPATCH
+        MUD_SIMD_TARGET_AVX2 uint32_t rayCastTriangleAVX2(const RayPacket<8> & rays, const Vector3 & p0, const Vector3 & p1, const Vector3 & p2, float * hitDistances, bool cullBackFaces)
+        {
+            const Vector3 p0p1 = p1 - p0;
+            const Vector3 p0p2 = p2 - p0;
+
+            const __m256 p0p1X = _mm256_set1_ps(p0p1.x);
+            const __m256 p0p1Y = _mm256_set1_ps(p0p1.y);
+            const __m256 p0p1Z = _mm256_set1_ps(p0p1.z);
+            const __m256 p0p2X = _mm256_set1_ps(p0p2.x);
+            const __m256 p0p2Y = _mm256_set1_ps(p0p2.y);
+            const __m256 p0p2Z = _mm256_set1_ps(p0p2.z);
+
+            const __m256 directionX = _mm256_load_ps(rays.directionX);
+            const __m256 directionY = _mm256_load_ps(rays.directionY);
+            const __m256 directionZ = _mm256_load_ps(rays.directionZ);
+
+            const __m256 pvecX = _mm256_fmsub_ps(directionY, p0p2Z, _mm256_mul_ps(directionZ, p0p2Y));
+            const __m256 pvecY = _mm256_fmsub_ps(directionZ, p0p2X, _mm256_mul_ps(directionX, p0p2Z));
+            const __m256 pvecZ = _mm256_fmsub_ps(directionX, p0p2Y, _mm256_mul_ps(directionY, p0p2X));
+
+            const __m256 det = _mm256_fmadd_ps(p0p1Z, pvecZ, _mm256_fmadd_ps(p0p1Y, pvecY, _mm256_mul_ps(p0p1X, pvecX)));
+            const __m256 absDet = _mm256_and_ps(det, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)));
+            __m256 valid = _mm256_cmp_ps(cullBackFaces ? det : absDet, _mm256_set1_ps(k_rayCastTriangleEpsilon), _CMP_GE_OQ);
+
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 invDet = _mm256_div_ps(one, det);
+
+            const __m256 tvecX = _mm256_sub_ps(_mm256_load_ps(rays.originX), _mm256_set1_ps(p0.x));
+            const __m256 tvecY = _mm256_sub_ps(_mm256_load_ps(rays.originY), _mm256_set1_ps(p0.y));
+            const __m256 tvecZ = _mm256_sub_ps(_mm256_load_ps(rays.originZ), _mm256_set1_ps(p0.z));
+
+            const __m256 u = _mm256_mul_ps(_mm256_fmadd_ps(tvecZ, pvecZ, _mm256_fmadd_ps(tvecY, pvecY, _mm256_mul_ps(tvecX, pvecX))), invDet);
+            valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+
+            const __m256 qvecX = _mm256_fmsub_ps(tvecY, p0p1Z, _mm256_mul_ps(tvecZ, p0p1Y));
+            const __m256 qvecY = _mm256_fmsub_ps(tvecZ, p0p1X, _mm256_mul_ps(tvecX, p0p1Z));
+            const __m256 qvecZ = _mm256_fmsub_ps(tvecX, p0p1Y, _mm256_mul_ps(tvecY, p0p1X));
+
+            const __m256 v = _mm256_mul_ps(_mm256_fmadd_ps(directionZ, qvecZ, _mm256_fmadd_ps(directionY, qvecY, _mm256_mul_ps(directionX, qvecX))), invDet);
+            valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ)));
+
+            const __m256 t = _mm256_mul_ps(_mm256_fmadd_ps(p0p2Z, qvecZ, _mm256_fmadd_ps(p0p2Y, qvecY, _mm256_mul_ps(p0p2X, qvecX))), invDet);
+            const __m256 nearest = _mm256_loadu_ps(hitDistances);
+            valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, nearest, _CMP_LT_OQ)));
+
+            _mm256_storeu_ps(hitDistances, _mm256_blendv_ps(nearest, t, valid));
+            return static_cast<uint32_t>(_mm256_movemask_ps(valid));
+        }
+
+        MUD_SIMD_TARGET_AVX2 uint32_t rayCastAABBAVX2(const RayPacket<8> & rays, const AABB & aabb, const float * maxDistances)
+        {
+            __m256 tNear = _mm256_setzero_ps();
+            __m256 tFar = _mm256_loadu_ps(maxDistances);
+
+            const float * origins[3] = { rays.originX, rays.originY, rays.originZ };
+            const float * inverseDirections[3] = { rays.inverseDirectionX, rays.inverseDirectionY, rays.inverseDirectionZ };
+
+            for (unsigned int axis = 0; axis < 3; ++axis)
+            {
+                const __m256 origin = _mm256_load_ps(origins[axis]);
+                const __m256 inverseDirection = _mm256_load_ps(inverseDirections[axis]);
+                const __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(aabb.min[axis]), origin), inverseDirection);
+                const __m256 t2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(aabb.max[axis]), origin), inverseDirection);
+
+                tNear = _mm256_max_ps(_mm256_min_ps(t1, t2), tNear);
+                tFar = _mm256_min_ps(_mm256_max_ps(t1, t2), tFar);
+            }
+
+            return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)));
+        }
+#endif
+
+        struct PacketKernels
+        {
+            uint32_t (*rayCastTriangle)(const RayPacket<8> &, const Vector3 &, const Vector3 &, const Vector3 &, float *, bool);
+            uint32_t (*rayCastAABB)(const RayPacket<8> &, const AABB &, const float *);
+        };
+
+        uint32_t rayCastTriangleDefault(const RayPacket<8> & rays, const Vector3 & p0, const Vector3 & p1, const Vector3 & p2, float * hitDistances, bool cullBackFaces)
+        {
+            return rayCastTriangleLanes(rays, 0, p0, p1, p2, hitDistances, cullBackFaces)
+                | (rayCastTriangleLanes(rays, 4, p0, p1, p2, hitDistances + 4, cullBackFaces) << 4);
+        }
+
+        uint32_t rayCastAABBDefault(const RayPacket<8> & rays, const AABB & aabb, const float * maxDistances)
+        {
+            return rayCastAABBLanes(rays, 0, aabb, maxDistances) | (rayCastAABBLanes(rays, 4, aabb, maxDistances + 4) << 4);
+        }
+
+        const PacketKernels & getPacketKernels()
+        {
+            static const PacketKernels kernels = []() {
+#ifdef MUD_SIMD_AVX2_DISPATCH
+                if (simd::isAVX2Supported())
+                    return PacketKernels{ rayCastTriangleAVX2, rayCastAABBAVX2 };
+#endif
+                return PacketKernels{ rayCastTriangleDefault, rayCastAABBDefault };
+            }();
+
+            return kernels;
+        }
+    }
+
     RayCastResult rayCastPlane(const Vector3 & rayOrigin, const Vector3 & rayDirection, const Vector3 & planeCenter, const Vector3 & planeNormal)
     {
         RayCastResult result;
@@ -170,4 +353,102 @@ namespace mud::intersection_test
         result.distance = tMin;
         return result;
     }
+
+    uint32_t rayCastTriangle(const RayPacket<4> & rays, const Vector3 & p0, const Vector3 & p1, const Vector3 & p2, float * hitDistances, bool cullBackFaces)
+    {
+        return rayCastTriangleLanes(rays, 0, p0, p1, p2, hitDistances, cullBackFaces);
+    }
+
+    uint32_t rayCastTriangle(const RayPacket<8> & rays, const Vector3 & p0, const Vector3 & p1, const Vector3 & p2, float * hitDistances, bool cullBackFaces)
+    {
+        return getPacketKernels().rayCastTriangle(rays, p0, p1, p2, hitDistances, cullBackFaces);
+    }
+
+    uint32_t rayCastAABB(const RayPacket<4> & rays, const AABB & aabb, const float * maxDistances)
+    {
+        if (aabb.isEmpty())
+            return 0;
+
+        return rayCastAABBLanes(rays, 0, aabb, maxDistances);
+    }
+
+    uint32_t rayCastAABB(const RayPacket<8> & rays, const AABB & aabb, const float * maxDistances)
+    {
+        if (aabb.isEmpty())
+            return 0;
+
+        return getPacketKernels().rayCastAABB(rays, aabb, maxDistances);
+    }
+
+    uint32_t rayCastOBB(const RayPacket<4> & rays, const AABB & aabb, const Matrix4 & aabbMatrix, const float * maxDistances)
+    {
+        return rayCastAABB(rays.transform(inverseAffine(aabbMatrix)), aabb, maxDistances);
+    }
+
+    uint32_t rayCastOBB(const RayPacket<8> & rays, const AABB & aabb, const Matrix4 & aabbMatrix, const float * maxDistances)
+    {
+        return rayCastAABB(rays.transform(inverseAffine(aabbMatrix)), aabb, maxDistances);
+    }
+
+    FrustumTestResult frustumAABB(const Frustum & frustum, const AABB & aabb)
+    {
+        if (aabb.isEmpty())
+            return FrustumTestResult::Outside;
+
+        const Vector3 center = aabb.getCenter();
+        const Vector3 extents = aabb.getExtents();
+
+        // For each plane, the box is outside if its center lies further behind the plane than the box's projected
+        // radius, and straddles the plane if the center is within that radius
+
+#ifdef MUD_SIMD_SSE
+        const __m128 centerX = _mm_set1_ps(center.x);
+        const __m128 centerY = _mm_set1_ps(center.y);
+        const __m128 centerZ = _mm_set1_ps(center.z);
+        const __m128 extentsX = _mm_set1_ps(extents.x);
+        const __m128 extentsY = _mm_set1_ps(extents.y);
+        const __m128 extentsZ = _mm_set1_ps(extents.z);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+        int intersectingMask = 0;
+
+        for (unsigned int idx = 0; idx < 8; idx += 4)
+        {
+            const __m128 normalX = _mm_load_ps(frustum.normalX + idx);
+            const __m128 normalY = _mm_load_ps(frustum.normalY + idx);
+            const __m128 normalZ = _mm_load_ps(frustum.normalZ + idx);
+
+            const __m128 signedDistance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(normalX, centerX), _mm_mul_ps(normalY, centerY)),
+                _mm_add_ps(_mm_mul_ps(normalZ, centerZ), _mm_load_ps(frustum.distance + idx)));
+
+            const __m128 radius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_and_ps(normalX, absMask), extentsX), _mm_mul_ps(_mm_and_ps(normalY, absMask), extentsY)),
+                _mm_mul_ps(_mm_and_ps(normalZ, absMask), extentsZ));
+
+            if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(signedDistance, radius), _mm_setzero_ps())) != 0)
+                return FrustumTestResult::Outside;
+
+            intersectingMask |= _mm_movemask_ps(_mm_cmplt_ps(signedDistance, radius));
+        }
+
+        return intersectingMask != 0 ? FrustumTestResult::Intersecting : FrustumTestResult::Inside;
+#else
+        bool isIntersecting = false;
+
+        for (unsigned int idx = 0; idx < Frustum::k_numPlanes; ++idx)
+        {
+            const float signedDistance = frustum.normalX[idx] * center.x + frustum.normalY[idx] * center.y + frustum.normalZ[idx] * center.z + frustum.distance[idx];
+            const float radius = std::fabs(frustum.normalX[idx]) * extents.x + std::fabs(frustum.normalY[idx]) * extents.y + std::fabs(frustum.normalZ[idx]) * extents.z;
+
+            if (signedDistance + radius < 0)
+                return FrustumTestResult::Outside;
+
+            if (signedDistance < radius)
+                isIntersecting = true;
+        }
+
+        return isIntersecting ? FrustumTestResult::Intersecting : FrustumTestResult::Inside;
+#endif
+    }
 }
\ No newline at end of file
@@ -1,7 +1,11 @@
 #ifndef INTERSECTION_TEXT_HPP
 #define INTERSECTION_TEXT_HPP
 
+#include <cstddef>
+#include <cstdint>
+
 #include "aabb.hpp"
+#include "frustum.hpp"
 #include "matrix.hpp"
 #include "vector.hpp"
 
@@ -29,6 +33,71 @@ namespace mud
         float distance;
     };
 
+    // Rays in structure-of-arrays layout, for testing 4 or 8 rays per call. Lanes that are not in use should be given a
+    // max distance below zero so they never report a hit.
+    template<size_t N>
+    struct RayPacket
+    {
+        static_assert(N == 4 || N == 8, "Ray packets hold 4 or 8 rays");
+
+        static constexpr size_t k_size = N;
+
+        alignas(32) float originX[N];
+        alignas(32) float originY[N];
+        alignas(32) float originZ[N];
+        alignas(32) float directionX[N];
+        alignas(32) float directionY[N];
+        alignas(32) float directionZ[N];
+
+        // 1 / direction, for the slab tests. Zero components become infinities, which the slab tests handle.
+        alignas(32) float inverseDirectionX[N];
+        alignas(32) float inverseDirectionY[N];
+        alignas(32) float inverseDirectionZ[N];
+
+        void setRay(size_t lane, const Vector3 & origin, const Vector3 & direction)
+        {
+            originX[lane] = origin.x;
+            originY[lane] = origin.y;
+            originZ[lane] = origin.z;
+            directionX[lane] = direction.x;
+            directionY[lane] = direction.y;
+            directionZ[lane] = direction.z;
+            inverseDirectionX[lane] = 1.0f / direction.x;
+            inverseDirectionY[lane] = 1.0f / direction.y;
+            inverseDirectionZ[lane] = 1.0f / direction.z;
+        }
+
+        // Transforms the origins as points and the directions as vectors. Directions are not renormalised, so hit
+        // distances in the new space are still measured in units of the original directions.
+        RayPacket transform(const Matrix4 & matrix) const
+        {
+            RayPacket result;
+
+            for (size_t lane = 0; lane < N; ++lane)
+            {
+                const Vector3 origin(
+                    matrix[0].x * originX[lane] + matrix[1].x * originY[lane] + matrix[2].x * originZ[lane] + matrix[3].x,
+                    matrix[0].y * originX[lane] + matrix[1].y * originY[lane] + matrix[2].y * originZ[lane] + matrix[3].y,
+                    matrix[0].z * originX[lane] + matrix[1].z * originY[lane] + matrix[2].z * originZ[lane] + matrix[3].z);
+                const Vector3 direction(
+                    matrix[0].x * directionX[lane] + matrix[1].x * directionY[lane] + matrix[2].x * directionZ[lane],
+                    matrix[0].y * directionX[lane] + matrix[1].y * directionY[lane] + matrix[2].y * directionZ[lane],
+                    matrix[0].z * directionX[lane] + matrix[1].z * directionY[lane] + matrix[2].z * directionZ[lane]);
+
+                result.setRay(lane, origin, direction);
+            }
+
+            return result;
+        }
+    };
+
+    enum class FrustumTestResult
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
     namespace intersection_test
     {
         IntersectionResult pointLine();
@@ -54,6 +123,29 @@ namespace mud
         RayCastResult rayCastTriangle(const Vector3 & rayOrigin, const Vector3 & rayDirection, const Vector3 & p0, const Vector3 & p1, const Vector3 & p2);
 
         RayCastResult rayCastOBB(const Vector3 & rayOrigin, const Vector3 & rayDirection, const AABB & aabb, const Matrix4 & aabbMatrix);
+
+        // Packet versions of the ray tests. The 8-ray versions use AVX2 when the CPU supports it and otherwise run as
+        // two 4-ray halves. Bit i of the returned mask is set if ray i hits.
+
+        // Moller-Trumbore over a packet. hitDistances holds each ray's nearest hit so far; rays that hit the triangle
+        // nearer than that have it lowered. With cullBackFaces set, only triangles whose (p1 - p0) x (p2 - p0) normal
+        // faces the ray are hit.
+        uint32_t rayCastTriangle(const RayPacket<4> & rays, const Vector3 & p0, const Vector3 & p1, const Vector3 & p2, float * hitDistances, bool cullBackFaces = false);
+
+        uint32_t rayCastTriangle(const RayPacket<8> & rays, const Vector3 & p0, const Vector3 & p1, const Vector3 & p2, float * hitDistances, bool cullBackFaces = false);
+
+        // Slab test over a packet. A ray hits if it enters the box between distance 0 and maxDistances[i].
+        uint32_t rayCastAABB(const RayPacket<4> & rays, const AABB & aabb, const float * maxDistances);
+
+        uint32_t rayCastAABB(const RayPacket<8> & rays, const AABB & aabb, const float * maxDistances);
+
+        // Moves the packet into the box's space and slab tests it against aabb. aabbMatrix must be affine.
+        uint32_t rayCastOBB(const RayPacket<4> & rays, const AABB & aabb, const Matrix4 & aabbMatrix, const float * maxDistances);
+
+        uint32_t rayCastOBB(const RayPacket<8> & rays, const AABB & aabb, const Matrix4 & aabbMatrix, const float * maxDistances);
+
+        // Tests a world-space AABB against all frustum planes, four planes at a time when SSE is available
+        FrustumTestResult frustumAABB(const Frustum & frustum, const AABB & aabb);
     }
 }
 
@@ -0,0 +1,197 @@
+#include "loose_octree.hpp"
+
+#include <cmath>
+
+namespace mud
+{
+    LooseOctree::LooseOctree(const AABB & bounds, uint32_t maxDepth)
+        : m_freeList(k_nullProxy), m_numProxies(0), m_maxDepth(maxDepth)
+    {
+        const Vector3 extents = bounds.getExtents();
+
+        Node root;
+        root.center = bounds.getCenter();
+        root.halfSize = std::max({ extents.x, extents.y, extents.z });
+        root.parent = k_nullProxy;
+        std::fill(std::begin(root.children), std::end(root.children), k_nullProxy);
+        root.depth = 0;
+        root.subtreeNumProxies = 0;
+
+        m_nodes.push_back(std::move(root));
+    }
+
+    int32_t LooseOctree::createProxy(const AABB & aabb, uint64_t userData)
+    {
+        int32_t proxyId;
+        if (m_freeList != k_nullProxy)
+        {
+            proxyId = m_freeList;
+            m_freeList = m_proxies[proxyId].node;
+        }
+        else
+        {
+            proxyId = static_cast<int32_t>(m_proxies.size());
+            m_proxies.emplace_back();
+        }
+
+        m_proxies[proxyId].aabb = aabb;
+        m_proxies[proxyId].userData = userData;
+        addToNode(proxyId, findNode(aabb));
+
+        ++m_numProxies;
+        return proxyId;
+    }
+
+    void LooseOctree::destroyProxy(int32_t proxyId)
+    {
+        removeFromNode(proxyId);
+
+        m_proxies[proxyId].node = m_freeList;
+        m_freeList = proxyId;
+
+        --m_numProxies;
+    }
+
+    bool LooseOctree::moveProxy(int32_t proxyId, const AABB & aabb)
+    {
+        m_proxies[proxyId].aabb = aabb;
+
+        const int32_t nodeId = findNode(aabb);
+        if (nodeId == m_proxies[proxyId].node)
+            return false;
+
+        removeFromNode(proxyId);
+        addToNode(proxyId, nodeId);
+        return true;
+    }
+
+    uint64_t LooseOctree::getUserData(int32_t proxyId) const
+    {
+        return m_proxies[proxyId].userData;
+    }
+
+    const AABB & LooseOctree::getAABB(int32_t proxyId) const
+    {
+        return m_proxies[proxyId].aabb;
+    }
+
+    size_t LooseOctree::getNumProxies() const
+    {
+        return m_numProxies;
+    }
+
+    bool LooseOctree::overlaps(const AABB & a, const AABB & b)
+    {
+        return a.min.x <= b.max.x && b.min.x <= a.max.x &&
+            a.min.y <= b.max.y && b.min.y <= a.max.y &&
+            a.min.z <= b.max.z && b.min.z <= a.max.z;
+    }
+
+    bool LooseOctree::overlapsSphere(const AABB & aabb, const Vector3 & center, float radius)
+    {
+        const Vector3 closestPoint(
+            std::clamp(center.x, aabb.min.x, aabb.max.x),
+            std::clamp(center.y, aabb.min.y, aabb.max.y),
+            std::clamp(center.z, aabb.min.z, aabb.max.z));
+
+        const Vector3 delta = closestPoint - center;
+        return delta.dot(delta) <= radius * radius;
+    }
+
+    bool LooseOctree::rayCastAABB(const AABB & aabb, const Vector3 & origin, const Vector3 & inverseDirection, float maxDistance, float & entryDistance)
+    {
+        float tMin = 0;
+        float tMax = maxDistance;
+
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            float t1 = (aabb.min[axis] - origin[axis]) * inverseDirection[axis];
+            float t2 = (aabb.max[axis] - origin[axis]) * inverseDirection[axis];
+
+            if (t1 > t2)
+                std::swap(t1, t2);
+
+            // NaN (origin on a slab of a direction-parallel axis) fails both comparisons and keeps the ray alive
+            if (t1 > tMin)
+                tMin = t1;
+            if (t2 < tMax)
+                tMax = t2;
+
+            if (tMin > tMax)
+                return false;
+        }
+
+        entryDistance = tMin;
+        return true;
+    }
+
+    int32_t LooseOctree::findNode(const AABB & aabb)
+    {
+        const Vector3 center = aabb.getCenter();
+        const Vector3 extents = aabb.getExtents();
+        const float size = std::max({ extents.x, extents.y, extents.z });
+
+        const Vector3 rootOffset = center - m_nodes[0].center;
+        const float rootHalfSize = m_nodes[0].halfSize;
+        if (size > rootHalfSize || std::abs(rootOffset.x) > rootHalfSize || std::abs(rootOffset.y) > rootHalfSize || std::abs(rootOffset.z) > rootHalfSize)
+            return 0;
+
+        // Descend while the object still fits the loose bounds of the next level's nodes
+        int32_t nodeId = 0;
+        while (m_nodes[nodeId].depth < m_maxDepth && size <= m_nodes[nodeId].halfSize * 0.5f)
+        {
+            const Node & node = m_nodes[nodeId];
+            const uint32_t childIdx = (center.x >= node.center.x ? 1 : 0) | (center.y >= node.center.y ? 2 : 0) | (center.z >= node.center.z ? 4 : 0);
+
+            if (node.children[childIdx] == k_nullProxy)
+            {
+                const float childHalfSize = node.halfSize * 0.5f;
+
+                Node child;
+                child.center = node.center + Vector3(
+                    (childIdx & 1) ? childHalfSize : -childHalfSize,
+                    (childIdx & 2) ? childHalfSize : -childHalfSize,
+                    (childIdx & 4) ? childHalfSize : -childHalfSize);
+                child.halfSize = childHalfSize;
+                child.parent = nodeId;
+                std::fill(std::begin(child.children), std::end(child.children), k_nullProxy);
+                child.depth = node.depth + 1;
+                child.subtreeNumProxies = 0;
+
+                // Growing the nodes invalidates the reference to the parent
+                const int32_t childId = static_cast<int32_t>(m_nodes.size());
+                m_nodes.push_back(std::move(child));
+                m_nodes[nodeId].children[childIdx] = childId;
+            }
+
+            nodeId = m_nodes[nodeId].children[childIdx];
+        }
+
+        return nodeId;
+    }
+
+    void LooseOctree::addToNode(int32_t proxyId, int32_t nodeId)
+    {
+        Proxy & proxy = m_proxies[proxyId];
+        proxy.node = nodeId;
+        proxy.nodeIdx = static_cast<uint32_t>(m_nodes[nodeId].proxies.size());
+        m_nodes[nodeId].proxies.push_back(proxyId);
+
+        for (int32_t ancestor = nodeId; ancestor != k_nullProxy; ancestor = m_nodes[ancestor].parent)
+            ++m_nodes[ancestor].subtreeNumProxies;
+    }
+
+    void LooseOctree::removeFromNode(int32_t proxyId)
+    {
+        const Proxy & proxy = m_proxies[proxyId];
+        std::vector<int32_t> & proxies = m_nodes[proxy.node].proxies;
+
+        // Swap-and-pop, only the moved proxy's index needs patching
+        proxies[proxy.nodeIdx] = proxies.back();
+        m_proxies[proxies[proxy.nodeIdx]].nodeIdx = proxy.nodeIdx;
+        proxies.pop_back();
+
+        for (int32_t ancestor = proxy.node; ancestor != k_nullProxy; ancestor = m_nodes[ancestor].parent)
+            --m_nodes[ancestor].subtreeNumProxies;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,226 @@
+#ifndef MUD_LOOSE_OCTREE_HPP
+#define MUD_LOOSE_OCTREE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "aabb.hpp"
+#include "frustum.hpp"
+#include "intersection_test.hpp"
+
+namespace mud
+{
+    // Loose octree over dynamic AABBs, for objects that move every frame. An object lives in the deepest node whose
+    // cube is at least as large as the object and holds the object's center. Nodes are tested with their cube doubled
+    // in size (their loose bounds), which always contains their objects. Finding a node only depends on the object's
+    // size and center, so moving costs the same however many objects there are, and a move within the same node only
+    // updates the stored box. Objects centred outside the root cube or larger than it are kept in the root.
+    class LooseOctree
+    {
+    public:
+
+        static constexpr int32_t k_nullProxy = -1;
+
+        // The root cube encloses bounds. Nodes are split at most maxDepth times, which also sets the smallest cells.
+        LooseOctree(const AABB & bounds, uint32_t maxDepth);
+
+        int32_t createProxy(const AABB & aabb, uint64_t userData);
+
+        void destroyProxy(int32_t proxyId);
+
+        // Returns true if the proxy had to change node
+        bool moveProxy(int32_t proxyId, const AABB & aabb);
+
+        uint64_t getUserData(int32_t proxyId) const;
+
+        const AABB & getAABB(int32_t proxyId) const;
+
+        size_t getNumProxies() const;
+
+        // Calls callback(proxyId) for every proxy whose AABB overlaps the box. Return false to stop the query.
+        template<typename Callback>
+        void queryAABB(const AABB & aabb, Callback callback) const
+        {
+            const auto test = [&](const AABB & bounds) {
+                return overlaps(bounds, aabb) ? FrustumTestResult::Intersecting : FrustumTestResult::Outside;
+            };
+
+            query(test, test, callback);
+        }
+
+        // Calls callback(proxyId) for every proxy whose AABB overlaps the sphere. Return false to stop the query.
+        template<typename Callback>
+        void querySphere(const Vector3 & center, float radius, Callback callback) const
+        {
+            const auto test = [&](const AABB & bounds) {
+                return overlapsSphere(bounds, center, radius) ? FrustumTestResult::Intersecting : FrustumTestResult::Outside;
+            };
+
+            query(test, test, callback);
+        }
+
+        // Calls callback(proxyId) for every proxy whose AABB is not outside the frustum. Proxies of nodes entirely
+        // inside are not tested themselves. Return false to stop the query.
+        template<typename Callback>
+        void queryFrustum(const Frustum & frustum, Callback callback) const
+        {
+            const auto test = [&](const AABB & bounds) {
+                return intersection_test::frustumAABB(frustum, bounds);
+            };
+
+            query(test, test, callback);
+        }
+
+        // Visits the proxies whose AABB the ray hits, nodes nearest first. callback(proxyId, maxDistance) returns the
+        // new maximum distance: return the hit distance to clip the ray, maxDistance to carry on, or 0 to stop.
+        // Distances are in units of the (not necessarily normalised) ray direction.
+        template<typename Callback>
+        void rayCast(const Vector3 & origin, const Vector3 & direction, float maxDistance, Callback callback) const
+        {
+            const Vector3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+            struct StackEntry
+            {
+                int32_t node;
+                float entryDistance;
+            };
+
+            std::vector<StackEntry> stack;
+            stack.reserve(64);
+            stack.push_back({ 0, 0.0f });
+
+            while (!stack.empty())
+            {
+                const StackEntry entry = stack.back();
+                stack.pop_back();
+
+                // The ray was clipped by a nearer hit since this node was pushed
+                if (entry.entryDistance > maxDistance)
+                    continue;
+
+                const Node & node = m_nodes[entry.node];
+
+                for (int32_t proxyId : node.proxies)
+                {
+                    float entryDistance = 0;
+                    if (!rayCastAABB(m_proxies[proxyId].aabb, origin, inverseDirection, maxDistance, entryDistance))
+                        continue;
+
+                    maxDistance = std::min(maxDistance, callback(proxyId, maxDistance));
+                    if (maxDistance <= 0)
+                        return;
+                }
+
+                // Push the farthest children first so the nearest are visited first
+                StackEntry children[8];
+                size_t numChildren = 0;
+
+                for (int32_t child : node.children)
+                {
+                    float entryDistance = 0;
+                    if (child != k_nullProxy && m_nodes[child].subtreeNumProxies > 0 && rayCastAABB(m_nodes[child].getLooseBounds(), origin, inverseDirection, maxDistance, entryDistance))
+                        children[numChildren++] = { child, entryDistance };
+                }
+
+                std::sort(children, children + numChildren, [](const StackEntry & lhs, const StackEntry & rhs) {
+                    return lhs.entryDistance > rhs.entryDistance;
+                });
+
+                stack.insert(stack.end(), children, children + numChildren);
+            }
+        }
+
+    private:
+
+        struct Node
+        {
+            Vector3 center;
+            float halfSize;
+            int32_t parent;
+            int32_t children[8];
+            uint32_t depth;
+
+            // Proxies of this node and all its descendants, so that empty branches are skipped
+            uint32_t subtreeNumProxies;
+
+            std::vector<int32_t> proxies;
+
+            AABB getLooseBounds() const
+            {
+                return AABB(center - Vector3(2.0f * halfSize), center + Vector3(2.0f * halfSize));
+            }
+        };
+
+        struct Proxy
+        {
+            AABB aabb;
+            uint64_t userData;
+
+            // The node holding the proxy and its index in the node's proxies, or the next free proxy while the proxy
+            // is in the free list
+            int32_t node;
+            uint32_t nodeIdx;
+        };
+
+        static bool overlaps(const AABB & a, const AABB & b);
+
+        static bool overlapsSphere(const AABB & aabb, const Vector3 & center, float radius);
+
+        static bool rayCastAABB(const AABB & aabb, const Vector3 & origin, const Vector3 & inverseDirection, float maxDistance, float & entryDistance);
+
+        // Walks the nodes that nodeTest does not reject and calls callback for the proxies that proxyTest does not
+        // reject. Both tests return a FrustumTestResult, Inside skipping all tests below the node. The root is never
+        // tested, it may hold proxies outside its bounds.
+        template<typename NodeTest, typename ProxyTest, typename Callback>
+        void query(NodeTest nodeTest, ProxyTest proxyTest, Callback callback) const
+        {
+            std::vector<std::pair<int32_t, bool>> stack;
+            stack.reserve(64);
+            stack.push_back({ 0, false });
+
+            while (!stack.empty())
+            {
+                const auto [nodeId, isParentInside] = stack.back();
+                stack.pop_back();
+
+                const Node & node = m_nodes[nodeId];
+
+                bool isInside = isParentInside;
+                if (nodeId != 0 && !isInside)
+                {
+                    const FrustumTestResult result = nodeTest(node.getLooseBounds());
+                    if (result == FrustumTestResult::Outside)
+                        continue;
+
+                    isInside = result == FrustumTestResult::Inside;
+                }
+
+                for (int32_t proxyId : node.proxies)
+                    if (isInside || proxyTest(m_proxies[proxyId].aabb) != FrustumTestResult::Outside)
+                        if (!callback(proxyId))
+                            return;
+
+                for (int32_t child : node.children)
+                    if (child != k_nullProxy && m_nodes[child].subtreeNumProxies > 0)
+                        stack.push_back({ child, isInside });
+            }
+        }
+
+        // The node the box belongs in, creating it and its ancestors when they do not exist yet
+        int32_t findNode(const AABB & aabb);
+
+        void addToNode(int32_t proxyId, int32_t nodeId);
+
+        void removeFromNode(int32_t proxyId);
+
+        std::vector<Node> m_nodes;
+        std::vector<Proxy> m_proxies;
+        int32_t m_freeList;
+        size_t m_numProxies;
+        uint32_t m_maxDepth;
+    };
+}
+
+#endif
\ No newline at end of file
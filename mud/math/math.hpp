@@ -1,3 +1,4 @@
+#include "batch_transform.hpp"
 #include "constants.hpp"
 #include "intersection_test.hpp"
 #include "matrix.hpp"
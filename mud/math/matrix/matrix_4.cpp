@@ -1,7 +1,5 @@
 #include "matrix_4.hpp"
 
-#include <cmath>
-
 #include "../quaternion.hpp"
 #include "../vector/vector_3.hpp"
 #include "matrix_2.hpp"
@@ -9,6 +7,74 @@
 
 namespace mud
 {
+	namespace
+	{
+		// 2 x 2 matrices are packed into one register as { m00, m01, m10, m11 }
+
+		// A * B
+		simd::float4 mat2Multiply(simd::float4 a, simd::float4 b)
+		{
+			return simd::add(
+				simd::mul(a, simd::swizzle<0, 3, 0, 3>(b)),
+				simd::mul(simd::swizzle<1, 0, 3, 2>(a), simd::swizzle<2, 1, 2, 1>(b)));
+		}
+
+		// adjugate(A) * B
+		simd::float4 mat2AdjugateMultiply(simd::float4 a, simd::float4 b)
+		{
+			return simd::sub(
+				simd::mul(simd::swizzle<3, 3, 0, 0>(a), b),
+				simd::mul(simd::swizzle<1, 1, 2, 2>(a), simd::swizzle<2, 3, 0, 1>(b)));
+		}
+
+		// A * adjugate(B)
+		simd::float4 mat2MultiplyAdjugate(simd::float4 a, simd::float4 b)
+		{
+			return simd::sub(
+				simd::mul(a, simd::swizzle<3, 0, 3, 0>(b)),
+				simd::mul(simd::swizzle<1, 0, 3, 2>(a), simd::swizzle<2, 1, 2, 1>(b)));
+		}
+
+		// The matrix split into 2 x 2 sub-matrices | A  B |, their determinants (broadcast), and the products shared by
+		//                                          | C  D |
+		// the determinant and the inverse
+		struct Blocks
+		{
+			simd::float4 a, b, c, d;
+			simd::float4 detA, detB, detC, detD;
+			simd::float4 adjAB, adjDC;
+		};
+
+		Blocks getBlocks(simd::float4 row0, simd::float4 row1, simd::float4 row2, simd::float4 row3)
+		{
+			Blocks blocks;
+			blocks.a = simd::shuffle<0, 1, 0, 1>(row0, row1);
+			blocks.b = simd::shuffle<2, 3, 2, 3>(row0, row1);
+			blocks.c = simd::shuffle<0, 1, 0, 1>(row2, row3);
+			blocks.d = simd::shuffle<2, 3, 2, 3>(row2, row3);
+
+			const simd::float4 subDeterminants = simd::sub(
+				simd::mul(simd::shuffle<0, 2, 0, 2>(row0, row2), simd::shuffle<1, 3, 1, 3>(row1, row3)),
+				simd::mul(simd::shuffle<1, 3, 1, 3>(row0, row2), simd::shuffle<0, 2, 0, 2>(row1, row3)));
+
+			blocks.detA = simd::splatLane<0>(subDeterminants);
+			blocks.detB = simd::splatLane<1>(subDeterminants);
+			blocks.detC = simd::splatLane<2>(subDeterminants);
+			blocks.detD = simd::splatLane<3>(subDeterminants);
+
+			blocks.adjAB = mat2AdjugateMultiply(blocks.a, blocks.b);
+			blocks.adjDC = mat2AdjugateMultiply(blocks.d, blocks.c);
+			return blocks;
+		}
+
+		// |M| = |A||D| + |B||C| - trace(adjugate(A)B adjugate(D)C), broadcast
+		simd::float4 getDeterminant(const Blocks & blocks)
+		{
+			const simd::float4 trace = simd::horizontalSum(simd::mul(blocks.adjAB, simd::swizzle<0, 2, 1, 3>(blocks.adjDC)));
+			return simd::sub(simd::add(simd::mul(blocks.detA, blocks.detD), simd::mul(blocks.detB, blocks.detC)), trace);
+		}
+	}
+
 	const Matrix4 Matrix4::zero{
 		0.0f, 0.0f, 0.0f, 0.0f,
 		0.0f, 0.0f, 0.0f, 0.0f,
@@ -74,105 +140,64 @@ namespace mud
 
 	Matrix4 Matrix4::transpose() const
 	{
-		return { getRow(0), getRow(1), getRow(2), getRow(3) };
+		simd::float4 col0 = simd::load(&columns[0].x);
+		simd::float4 col1 = simd::load(&columns[1].x);
+		simd::float4 col2 = simd::load(&columns[2].x);
+		simd::float4 col3 = simd::load(&columns[3].x);
+
+		simd::transpose(col0, col1, col2, col3);
+
+		Matrix4 result;
+		simd::store(&result.columns[0].x, col0);
+		simd::store(&result.columns[1].x, col1);
+		simd::store(&result.columns[2].x, col2);
+		simd::store(&result.columns[3].x, col3);
+		return result;
 	}
 
 	Matrix4 Matrix4::inverse() const
 	{
-		return (1.0f / determinant()) * Matrix4 {
-			Matrix3 {
-				columns[1][1], columns[1][2], columns[1][3],
-				columns[2][1], columns[2][2], columns[2][3],
-				columns[3][1], columns[3][2], columns[3][3] }.determinant(),
-			-Matrix3{
-				columns[1][0], columns[1][2], columns[1][3],
-				columns[2][0], columns[2][2], columns[2][3],
-				columns[3][0], columns[3][2], columns[3][3] }.determinant(),
-			Matrix3{
-				columns[1][0], columns[1][1], columns[1][3],
-				columns[2][0], columns[2][1], columns[2][3],
-				columns[3][0], columns[3][1], columns[3][3] }.determinant(),
-			-Matrix3{
-				columns[1][0], columns[1][1], columns[1][2],
-				columns[2][0], columns[2][1], columns[2][2],
-				columns[3][0], columns[3][1], columns[3][2] }.determinant(),
-
-			-Matrix3 {
-				columns[0][1], columns[0][2], columns[0][3],
-				columns[2][1], columns[2][2], columns[2][3],
-				columns[3][1], columns[3][2], columns[3][3] }.determinant(),
-			Matrix3{
-				columns[0][0], columns[0][2], columns[0][3],
-				columns[2][0], columns[2][2], columns[2][3],
-				columns[3][0], columns[3][2], columns[3][3] }.determinant(),
-			-Matrix3{
-				columns[0][0], columns[0][1], columns[0][3],
-				columns[2][0], columns[2][1], columns[2][3],
-				columns[3][0], columns[3][1], columns[3][3] }.determinant(),
-			Matrix3{
-				columns[0][0], columns[0][1], columns[0][2],
-				columns[2][0], columns[2][1], columns[2][2],
-				columns[3][0], columns[3][1], columns[3][2] }.determinant(),
-
-			Matrix3 {
-				columns[0][1], columns[0][2], columns[0][3],
-				columns[1][1], columns[1][2], columns[1][3],
-				columns[3][1], columns[3][2], columns[3][3] }.determinant(),
-			-Matrix3{
-				columns[0][0], columns[0][2], columns[0][3],
-				columns[1][0], columns[1][2], columns[1][3],
-				columns[3][0], columns[3][2], columns[3][3] }.determinant(),
-			Matrix3{
-				columns[0][0], columns[0][1], columns[0][3],
-				columns[1][0], columns[1][1], columns[1][3],
-				columns[3][0], columns[3][1], columns[3][3] }.determinant(),
-			-Matrix3{
-				columns[0][0], columns[0][1], columns[0][2],
-				columns[1][0], columns[1][1], columns[1][2],
-				columns[3][0], columns[3][1], columns[3][2] }.determinant(),
-
-			-Matrix3 {
-				columns[0][1], columns[0][2], columns[0][3],
-				columns[1][1], columns[1][2], columns[1][3],
-				columns[2][1], columns[2][2], columns[2][3] }.determinant(),
-			Matrix3{
-				columns[0][0], columns[0][2], columns[0][3],
-				columns[1][0], columns[1][2], columns[1][3],
-				columns[2][0], columns[2][2], columns[2][3] }.determinant(),
-			-Matrix3{
-				columns[0][0], columns[0][1], columns[0][3],
-				columns[1][0], columns[1][1], columns[1][3],
-				columns[2][0], columns[2][1], columns[2][3] }.determinant(),
-			Matrix3{
-				columns[0][0], columns[0][1], columns[0][2],
-				columns[1][0], columns[1][1], columns[1][2],
-				columns[2][0], columns[2][1], columns[2][2] }.determinant()
-		}.transpose();
+		// Block-wise inversion of the 2 x 2 sub-matrices A, B, C, D. The columns are treated as rows, which inverts
+		// the transpose and so produces the columns of the inverse directly, since inverse(transpose(M)) = transpose(inverse(M))
+		const simd::float4 col0 = simd::load(&columns[0].x);
+		const simd::float4 col1 = simd::load(&columns[1].x);
+		const simd::float4 col2 = simd::load(&columns[2].x);
+		const simd::float4 col3 = simd::load(&columns[3].x);
+
+		const Blocks blocks = getBlocks(col0, col1, col2, col3);
+
+		// inverse(M) = 1 / |M| * | X  Y |
+		//                        | Z  W |
+		simd::float4 x = simd::sub(simd::mul(blocks.detD, blocks.a), mat2Multiply(blocks.b, blocks.adjDC));
+		simd::float4 w = simd::sub(simd::mul(blocks.detA, blocks.d), mat2Multiply(blocks.c, blocks.adjAB));
+		simd::float4 y = simd::sub(simd::mul(blocks.detB, blocks.c), mat2MultiplyAdjugate(blocks.d, blocks.adjAB));
+		simd::float4 z = simd::sub(simd::mul(blocks.detC, blocks.b), mat2MultiplyAdjugate(blocks.a, blocks.adjDC));
+
+		const simd::float4 reciprocalDet = simd::div(simd::set(1.0f, -1.0f, -1.0f, 1.0f), getDeterminant(blocks));
+
+		x = simd::mul(x, reciprocalDet);
+		y = simd::mul(y, reciprocalDet);
+		z = simd::mul(z, reciprocalDet);
+		w = simd::mul(w, reciprocalDet);
+
+		// X, Y, Z and W hold adjugates, the shuffles undo that and interleave the blocks back into columns
+		Matrix4 result;
+		simd::store(&result.columns[0].x, simd::shuffle<3, 1, 3, 1>(x, y));
+		simd::store(&result.columns[1].x, simd::shuffle<2, 0, 2, 0>(x, y));
+		simd::store(&result.columns[2].x, simd::shuffle<3, 1, 3, 1>(z, w));
+		simd::store(&result.columns[3].x, simd::shuffle<2, 0, 2, 0>(z, w));
+		return result;
 	}
 
 	float Matrix4::determinant() const
 	{
-		float d = 0.0f;
-		int c, subi, subj, i, j;
-		Matrix3 submat;
-		for (c = 0; c < 4; c++)
-		{
-			subi = 0;
-			for (i = 1; i < 4; i++)
-			{
-				subj = 0;
-				for (j = 0; j < 4; j++)
-				{
-					if (j == c)
-						continue;
-					submat[subi][subj] = columns[i][j];
-					subj++;
-				}
-				subi++;
-			}
-			d = d + (std::pow(-1, c) * columns[0][c] * submat.determinant());
-		}
-		return d;
+		const Blocks blocks = getBlocks(
+			simd::load(&columns[0].x),
+			simd::load(&columns[1].x),
+			simd::load(&columns[2].x),
+			simd::load(&columns[3].x));
+
+		return simd::getX(getDeterminant(blocks));
 	}
 
 	Vector4& Matrix4::operator[](unsigned int idx)
@@ -188,28 +213,30 @@ namespace mud
 	Matrix4& Matrix4::operator+=(const Matrix4& rhs)
 	{
 		for (int idx = 0; idx < 4; idx++)
-			columns[idx] += rhs.columns[idx];
+			simd::store(&columns[idx].x, simd::add(simd::load(&columns[idx].x), simd::load(&rhs.columns[idx].x)));
 		return *this;
 	}
 
 	Matrix4& Matrix4::operator-=(const Matrix4& rhs)
 	{
 		for (int idx = 0; idx < 4; idx++)
-			columns[idx] -= rhs.columns[idx];
+			simd::store(&columns[idx].x, simd::sub(simd::load(&columns[idx].x), simd::load(&rhs.columns[idx].x)));
 		return *this;
 	}
 
 	Matrix4& Matrix4::operator*=(float s)
 	{
+		const simd::float4 scale = simd::splat(s);
 		for (int idx = 0; idx < 4; idx++)
-			columns[idx] *= s;
+			simd::store(&columns[idx].x, simd::mul(simd::load(&columns[idx].x), scale));
 		return *this;
 	}
 
 	Matrix4& Matrix4::operator/=(float s)
 	{
+		const simd::float4 divisor = simd::splat(s);
 		for (int idx = 0; idx < 4; idx++)
-			columns[idx] /= s;
+			simd::store(&columns[idx].x, simd::div(simd::load(&columns[idx].x), divisor));
 		return *this;
 	}
 
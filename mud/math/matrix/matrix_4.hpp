@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "../simd.hpp"
 #include "../vector/vector_4.hpp"
 
 namespace mud
@@ -18,8 +19,9 @@ namespace mud
 	 * \brief A mathematical 4 x 4 matrix of floating-point values.
 	 * \details This struct is used to represent square matrices with 4 columns and 4 rows.
 	 * \note All GML matrix data is stored in column-major order, i.e.: the contiguous memory of a matrix is stored column after column. You may often need a pointer to this data, the best way to get this is to simply use <code>&someMatrix[0][0];</code>. This provides a pointer to the matrix's first element.
+	 * \note Matrix4 is 16-byte aligned so each column can be loaded into a SIMD register directly.
 	 */
-	struct Matrix4
+	struct alignas(16) Matrix4
 	{
 		static const Matrix4 zero; //!< A static Matrix4 with all elements set to 0.0f.
 		static const Matrix4 identity; //!< A static Matrix4 with all diagonal elements set to 1.0f, AKA the Identity matrix.
@@ -230,10 +232,22 @@ namespace mud
 	 */
 	inline Matrix4 operator*(const Matrix4& lhs, const Matrix4& rhs)
 	{
+		const simd::float4 lhs0 = simd::load(&lhs.columns[0].x);
+		const simd::float4 lhs1 = simd::load(&lhs.columns[1].x);
+		const simd::float4 lhs2 = simd::load(&lhs.columns[2].x);
+		const simd::float4 lhs3 = simd::load(&lhs.columns[3].x);
+
+		// Each result column is the lhs columns weighted by the matching rhs column's elements
 		Matrix4 result;
 		for (unsigned int col = 0; col < 4; col++)
-			for (unsigned int row = 0; row < 4; row++)
-				result[col][row] = lhs.getRow(row).dot(rhs.columns[col]);
+		{
+			const Vector4& rhsCol = rhs.columns[col];
+			simd::float4 resultCol = simd::mul(lhs0, simd::splat(rhsCol.x));
+			resultCol = simd::multiplyAdd(lhs1, simd::splat(rhsCol.y), resultCol);
+			resultCol = simd::multiplyAdd(lhs2, simd::splat(rhsCol.z), resultCol);
+			resultCol = simd::multiplyAdd(lhs3, simd::splat(rhsCol.w), resultCol);
+			simd::store(&result.columns[col].x, resultCol);
+		}
 		return result;
 	}
 
@@ -245,12 +259,14 @@ namespace mud
 	 */
 	inline Vector4 operator*(const Matrix4& lhs, const Vector4& rhs)
 	{
-		return {
-			rhs.dot(lhs.getRow(0)),
-			rhs.dot(lhs.getRow(1)),
-			rhs.dot(lhs.getRow(2)),
-			rhs.dot(lhs.getRow(3))
-		};
+		simd::float4 result = simd::mul(simd::load(&lhs.columns[0].x), simd::splat(rhs.x));
+		result = simd::multiplyAdd(simd::load(&lhs.columns[1].x), simd::splat(rhs.y), result);
+		result = simd::multiplyAdd(simd::load(&lhs.columns[2].x), simd::splat(rhs.z), result);
+		result = simd::multiplyAdd(simd::load(&lhs.columns[3].x), simd::splat(rhs.w), result);
+
+		Vector4 v;
+		simd::storeUnaligned(&v.x, result);
+		return v;
 	}
 
 	/**
@@ -5,10 +5,160 @@
 #include "../quaternion.hpp"
 #include "../vector/vector_3.hpp"
 #include "../vector/vector_4.hpp"
+#include "../simd.hpp"
 #include "matrix_4.hpp"
 
 namespace mud
 {
+	namespace
+	{
+		// Builds an inverse affine matrix from the columns of its inverted 3 x 3 part (with a w of 0) and the
+		// translation of the original matrix
+		Matrix4 getInverseWithTranslation(simd::float4 col0, simd::float4 col1, simd::float4 col2, const Vector4& translation)
+		{
+			simd::float4 col3 = simd::mul(col0, simd::splat(translation.x));
+			col3 = simd::multiplyAdd(col1, simd::splat(translation.y), col3);
+			col3 = simd::multiplyAdd(col2, simd::splat(translation.z), col3);
+			col3 = simd::sub(simd::set(0.0f, 0.0f, 0.0f, 1.0f), col3);
+
+			Matrix4 result;
+			simd::store(&result.columns[0].x, col0);
+			simd::store(&result.columns[1].x, col1);
+			simd::store(&result.columns[2].x, col2);
+			simd::store(&result.columns[3].x, col3);
+			return result;
+		}
+	}
+
+	const Transform Transform::identity;
+
+	Transform::Transform(const Vector3& translation, const Quaternion& rotation, const Vector3& scale)
+		: translation(translation), rotation(rotation), scale(scale)
+	{ }
+
+	Transform Transform::fromMatrix(const Matrix4& m)
+	{
+		Transform result;
+		result.translation = Vector3(m.columns[3]);
+
+		Vector3 axes[3] = { Vector3(m.columns[0]), Vector3(m.columns[1]), Vector3(m.columns[2]) };
+		result.scale = Vector3(axes[0].magnitude(), axes[1].magnitude(), axes[2].magnitude());
+
+		if (axes[0].cross(axes[1]).dot(axes[2]) < 0)
+			result.scale.x = -result.scale.x;
+
+		for (unsigned int idx = 0; idx < 3; idx++)
+			if (result.scale[idx] != 0)
+				axes[idx] /= result.scale[idx];
+
+		// Rotation matrix to quaternion, branching on the largest diagonal term for precision. The matrix element in
+		// row r and column c is axes[c][r]
+		const float trace = axes[0].x + axes[1].y + axes[2].z;
+		if (trace > 0)
+		{
+			const float s = 2.0f * std::sqrt(1.0f + trace);
+			result.rotation = { 0.25f * s, (axes[1].z - axes[2].y) / s, (axes[2].x - axes[0].z) / s, (axes[0].y - axes[1].x) / s };
+		}
+		else if (axes[0].x > axes[1].y && axes[0].x > axes[2].z)
+		{
+			const float s = 2.0f * std::sqrt(1.0f + axes[0].x - axes[1].y - axes[2].z);
+			result.rotation = { (axes[1].z - axes[2].y) / s, 0.25f * s, (axes[1].x + axes[0].y) / s, (axes[2].x + axes[0].z) / s };
+		}
+		else if (axes[1].y > axes[2].z)
+		{
+			const float s = 2.0f * std::sqrt(1.0f + axes[1].y - axes[0].x - axes[2].z);
+			result.rotation = { (axes[2].x - axes[0].z) / s, (axes[1].x + axes[0].y) / s, 0.25f * s, (axes[2].y + axes[1].z) / s };
+		}
+		else
+		{
+			const float s = 2.0f * std::sqrt(1.0f + axes[2].z - axes[0].x - axes[1].y);
+			result.rotation = { (axes[0].y - axes[1].x) / s, (axes[2].x + axes[0].z) / s, (axes[2].y + axes[1].z) / s, 0.25f * s };
+		}
+
+		return result;
+	}
+
+	Matrix4 Transform::toMatrix() const
+	{
+		const Quaternion& q = rotation;
+
+		const float xx = q.x * q.x;
+		const float xy = q.x * q.y;
+		const float xz = q.x * q.z;
+		const float xw = q.x * q.w;
+
+		const float yy = q.y * q.y;
+		const float yz = q.y * q.z;
+		const float yw = q.y * q.w;
+
+		const float zz = q.z * q.z;
+		const float zw = q.z * q.w;
+
+		// Matches Vector3 * Quaternion, unlike transform_r which rotates by the conjugate
+		return {
+			Vector4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + zw), 2.0f * (xz - yw), 0.0f) * scale.x,
+			Vector4(2.0f * (xy - zw), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + xw), 0.0f) * scale.y,
+			Vector4(2.0f * (xz + yw), 2.0f * (yz - xw), 1.0f - 2.0f * (xx + yy), 0.0f) * scale.z,
+			Vector4(translation, 1.0f)
+		};
+	}
+
+	Transform Transform::inverse() const
+	{
+		const Vector3 inverseScale(1.0f / scale.x, 1.0f / scale.y, 1.0f / scale.z);
+		const Quaternion inverseRotation = rotation.conjugate();
+		return Transform(-(inverseScale * (translation * inverseRotation)), inverseRotation, inverseScale);
+	}
+
+	Vector3 Transform::transformPoint(const Vector3& point) const
+	{
+		return (scale * point) * rotation + translation;
+	}
+
+	Vector3 Transform::transformDirection(const Vector3& direction) const
+	{
+		return (scale * direction) * rotation;
+	}
+
+	Transform operator*(const Transform& lhs, const Transform& rhs)
+	{
+		return Transform(lhs.transformPoint(rhs.translation), lhs.rotation * rhs.rotation, lhs.scale * rhs.scale);
+	}
+
+	Matrix4 inverseAffine(const Matrix4& m)
+	{
+		const simd::float4 col0 = simd::load(&m.columns[0].x);
+		const simd::float4 col1 = simd::load(&m.columns[1].x);
+		const simd::float4 col2 = simd::load(&m.columns[2].x);
+
+		// The rows of the inverse 3 x 3 are the cross products of pairs of columns over the determinant
+		simd::float4 row0 = simd::cross3(col1, col2);
+		simd::float4 row1 = simd::cross3(col2, col0);
+		simd::float4 row2 = simd::cross3(col0, col1);
+		simd::float4 row3 = simd::splat(0.0f);
+
+		const simd::float4 inverseDeterminant = simd::div(simd::splat(1.0f), simd::dot3(col0, row0));
+		row0 = simd::mul(row0, inverseDeterminant);
+		row1 = simd::mul(row1, inverseDeterminant);
+		row2 = simd::mul(row2, inverseDeterminant);
+
+		simd::transpose(row0, row1, row2, row3);
+
+		return getInverseWithTranslation(row0, row1, row2, m.columns[3]);
+	}
+
+	Matrix4 inverseRigid(const Matrix4& m)
+	{
+		simd::float4 col0 = simd::load(&m.columns[0].x);
+		simd::float4 col1 = simd::load(&m.columns[1].x);
+		simd::float4 col2 = simd::load(&m.columns[2].x);
+		simd::float4 col3 = simd::splat(0.0f);
+
+		simd::transpose(col0, col1, col2, col3);
+
+		return getInverseWithTranslation(col0, col1, col2, m.columns[3]);
+	}
+
 	Matrix4 transform_t(float tX, float tY, float tZ)
 	{
 		return {
@@ -5,12 +5,98 @@
 
 #pragma once
 
+#include "../quaternion.hpp"
+#include "../vector/vector_3.hpp"
 #include "matrix_4.hpp"
 
 namespace mud
 {
-	struct Quaternion;
-	struct Vector3;
+	/**
+	 * \brief A transform stored as separate translation, rotation, and scale (TRS) components.
+	 * \details Points are scaled, then rotated, then translated. Transforms compose and invert component-wise, which is far cheaper than the equivalent Matrix4 operations, and are only converted to a Matrix4 where one is needed, e.g. when handing a transform to a renderer.
+	 * \note Like any TRS representation, composing a non-uniformly scaled transform with a rotated child cannot represent the resulting skew, and the skew is dropped. Composition and inversion are exact for uniform scale.
+	 */
+	struct Transform
+	{
+		static const Transform identity; //!< A static Transform with no translation, no rotation, and a scale of 1.0f.
+
+		Vector3 translation; //!< The translation, applied last.
+		Quaternion rotation{ 1.0f, 0.0f, 0.0f, 0.0f }; //!< The rotation, applied after scaling.
+		Vector3 scale{ 1.0f }; //!< The per-axis scale, applied first.
+
+		/**
+		 * \brief Default constructor. Constructs an identity Transform.
+		 */
+		Transform() = default;
+
+		/**
+		 * \brief Constructs a Transform from its components.
+		 * \param translation The translation of the Transform.
+		 * \param rotation The rotation of the Transform.
+		 * \param scale The per-axis scale of the Transform.
+		 */
+		Transform(const Vector3& translation, const Quaternion& rotation, const Vector3& scale);
+
+		/**
+		 * \brief Decomposes an affine transform matrix into a Transform.
+		 * \details Any shear in the matrix is lost. A negative determinant is represented by a negative X scale.
+		 * \param m An affine Matrix4, i.e. one whose bottom row is (0, 0, 0, 1).
+		 * \returns The Transform equivalent to the matrix.
+		 */
+		static Transform fromMatrix(const Matrix4& m);
+
+		/**
+		 * \brief Constructs the Matrix4 equivalent to the Transform.
+		 * \returns A Matrix4 equal to transform_t(translation) * rotation * transform_s(scale).
+		 */
+		Matrix4 toMatrix() const;
+
+		/**
+		 * \brief Calculates and returns the inverse of the Transform.
+		 * \returns A Transform which undoes the original Transform.
+		 * \warning The result is only exact if the scale is uniform.
+		 */
+		Transform inverse() const;
+
+		/**
+		 * \brief Applies the scale, rotation, and translation of the Transform to a point.
+		 * \param point The point to transform.
+		 * \returns The transformed point.
+		 */
+		Vector3 transformPoint(const Vector3& point) const;
+
+		/**
+		 * \brief Applies the scale and rotation of the Transform to a direction.
+		 * \param direction The direction to transform.
+		 * \returns The transformed direction.
+		 */
+		Vector3 transformDirection(const Vector3& direction) const;
+	};
+
+	/**
+	 * \brief Combines two Transforms. The right Transform is applied first.
+	 * \param lhs The outer Transform, e.g. a parent's transform.
+	 * \param rhs The inner Transform, e.g. a child's local transform.
+	 * \returns A Transform equivalent to applying the right Transform then the left Transform.
+	 * \warning The result is only exact if the left Transform's scale is uniform.
+	 */
+	Transform operator*(const Transform& lhs, const Transform& rhs);
+
+	/**
+	 * \brief Calculates the inverse of an affine transform matrix.
+	 * \details Faster than Matrix4::inverse() for any combination of translation, rotation, scale, and shear.
+	 * \param m An affine Matrix4, i.e. one whose bottom row is (0, 0, 0, 1).
+	 * \returns The inverse of the matrix.
+	 */
+	Matrix4 inverseAffine(const Matrix4& m);
+
+	/**
+	 * \brief Calculates the inverse of a rigid transform matrix.
+	 * \details Cheaper still than inverseAffine(), the rotation is inverted by transposing it. View matrices built by lookAt() and view() are rigid.
+	 * \param m A Matrix4 made up of only rotation and translation.
+	 * \returns The inverse of the matrix.
+	 */
+	Matrix4 inverseRigid(const Matrix4& m);
 
 	/**
 	 * \brief Constructs a translation transform matrix with specified X, Y, and Z translation values.
@@ -5,14 +5,16 @@
 
 #pragma once
 
+#include "simd.hpp"
 #include "vector/vector_3.hpp"
 
 namespace mud
 {
 	/**
 	 * \brief A quaternion struct used to represent 3D rotations.
+	 * \note Quaternion is 16-byte aligned so its components can be loaded into a SIMD register directly.
 	 */
-	struct Quaternion
+	struct alignas(16) Quaternion
 	{
 		static Quaternion identity; //!< A static Quaternion with all components set to 0.0f, except from w, which is set to 1.0f.
 
@@ -136,12 +138,17 @@ namespace mud
 	 */
 	inline Quaternion operator*(const Quaternion& lhs, const Quaternion& rhs)
 	{
-		return Quaternion{
-			lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z,
-			lhs.w * rhs.x + lhs.x * rhs.w + lhs.y * rhs.z - lhs.z * rhs.y,
-			lhs.w * rhs.y - lhs.x * rhs.z + lhs.y * rhs.w + lhs.z * rhs.x,
-			lhs.w * rhs.z + lhs.x * rhs.y - lhs.y * rhs.x + lhs.z * rhs.w
-		};
+		// Components are stored in w, x, y, z order. Each lhs component scales a signed permutation of rhs
+		const simd::float4 r = simd::load(&rhs.w);
+
+		simd::float4 result = simd::mul(simd::splat(lhs.w), r);
+		result = simd::multiplyAdd(simd::splat(lhs.x), simd::mul(simd::swizzle<1, 0, 3, 2>(r), simd::set(-1.0f, 1.0f, -1.0f, 1.0f)), result);
+		result = simd::multiplyAdd(simd::splat(lhs.y), simd::mul(simd::swizzle<2, 3, 0, 1>(r), simd::set(-1.0f, 1.0f, 1.0f, -1.0f)), result);
+		result = simd::multiplyAdd(simd::splat(lhs.z), simd::mul(simd::swizzle<3, 2, 1, 0>(r), simd::set(-1.0f, -1.0f, 1.0f, 1.0f)), result);
+
+		Quaternion q;
+		simd::store(&q.w, result);
+		return q;
 	}
 
 	/**
@@ -152,10 +159,16 @@ namespace mud
 	 */
 	inline Vector3 operator*(const Vector3& lhs, const Quaternion& rhs)
 	{
-		return
-			2.0f * rhs.xyz().dot(lhs) * rhs.xyz()
-			+ (rhs.w * rhs.w - rhs.xyz().dot(rhs.xyz())) * lhs
-			+ 2.0f * rhs.w * rhs.xyz().cross(lhs);
+		// v' = v + w t + q.xyz x t, where t = 2 q.xyz x v. Lane 3 carries unused values throughout
+		const simd::float4 q = simd::swizzle<1, 2, 3, 0>(simd::load(&rhs.w));
+		const simd::float4 v = simd::set(lhs.x, lhs.y, lhs.z, 0.0f);
+
+		const simd::float4 t = simd::mul(simd::splat(2.0f), simd::cross3(q, v));
+		const simd::float4 result = simd::add(simd::multiplyAdd(simd::splatLane<3>(q), t, v), simd::cross3(q, t));
+
+		alignas(16) float components[4];
+		simd::store(components, result);
+		return Vector3(components[0], components[1], components[2]);
 	}
 
 	/**
@@ -0,0 +1,44 @@
+#include "simd.hpp"
+
+#if defined(MUD_SIMD_AVX2_DISPATCH) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace mud::simd
+{
+    namespace
+    {
+        bool checkAVX2Support()
+        {
+#if !defined(MUD_SIMD_AVX2_DISPATCH)
+            return false;
+#elif defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+
+            __cpuid(info, 1);
+            const bool hasFMA = (info[2] & (1 << 12)) != 0;
+            const bool hasOSXSAVE = (info[2] & (1 << 27)) != 0;
+            const bool hasAVX = (info[2] & (1 << 28)) != 0;
+
+            // The OS must also preserve the upper halves of the YMM registers across context switches
+            if (!hasFMA || !hasOSXSAVE || !hasAVX || (_xgetbv(0) & 0x6) != 0x6)
+                return false;
+
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+        }
+    }
+
+    bool isAVX2Supported()
+    {
+        static const bool supported = checkAVX2Support();
+        return supported;
+    }
+}
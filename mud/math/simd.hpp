@@ -0,0 +1,410 @@
+#ifndef MUD_MATH_SIMD_HPP
+#define MUD_MATH_SIMD_HPP
+
+// Thin 4-wide float vector abstraction over SSE and NEON, with a plain scalar backend. Math code is written once
+// against these functions. Define MUD_MATH_FORCE_SCALAR to build with the scalar backend, e.g. to compare results.
+
+#if !defined(MUD_MATH_FORCE_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MUD_SIMD_SSE
+#include <emmintrin.h>
+#elif !defined(MUD_MATH_FORCE_SCALAR) && (defined(__ARM_NEON) || defined(_M_ARM64)) && (defined(__aarch64__) || defined(_M_ARM64))
+#define MUD_SIMD_NEON
+#include <arm_neon.h>
+#else
+#define MUD_SIMD_SCALAR
+#endif
+
+// 8-wide AVX2 kernels are compiled per function with MUD_SIMD_TARGET_AVX2, so the rest of the build does not need AVX2,
+// and must only be called when isAVX2Supported() returns true
+#if defined(MUD_SIMD_SSE) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define MUD_SIMD_AVX2_DISPATCH
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define MUD_SIMD_TARGET_AVX2
+#else
+#define MUD_SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+#if defined(MUD_SIMD_SCALAR)
+#include <cstdint>
+#include <cstring>
+#endif
+
+namespace mud::simd
+{
+#if defined(MUD_SIMD_SSE)
+    using float4 = __m128;
+#elif defined(MUD_SIMD_NEON)
+    using float4 = float32x4_t;
+#else
+    struct float4
+    {
+        float v[4];
+    };
+#endif
+
+    // True if the CPU and OS support AVX2 and FMA, checked once
+    bool isAVX2Supported();
+
+#if defined(MUD_SIMD_SCALAR)
+    namespace scalar
+    {
+        inline uint32_t toBits(float f)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            return bits;
+        }
+
+        inline float fromBits(uint32_t bits)
+        {
+            float f;
+            std::memcpy(&f, &bits, sizeof(f));
+            return f;
+        }
+
+        inline float toMask(bool b)
+        {
+            return fromBits(b ? 0xffffffffu : 0u);
+        }
+    }
+#endif
+
+    // Loads from 16-byte aligned memory
+    inline float4 load(const float * p)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_load_ps(p);
+#elif defined(MUD_SIMD_NEON)
+        return vld1q_f32(p);
+#else
+        return { { p[0], p[1], p[2], p[3] } };
+#endif
+    }
+
+    inline float4 loadUnaligned(const float * p)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_loadu_ps(p);
+#elif defined(MUD_SIMD_NEON)
+        return vld1q_f32(p);
+#else
+        return { { p[0], p[1], p[2], p[3] } };
+#endif
+    }
+
+    // Stores to 16-byte aligned memory
+    inline void store(float * p, float4 a)
+    {
+#if defined(MUD_SIMD_SSE)
+        _mm_store_ps(p, a);
+#elif defined(MUD_SIMD_NEON)
+        vst1q_f32(p, a);
+#else
+        p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3];
+#endif
+    }
+
+    inline void storeUnaligned(float * p, float4 a)
+    {
+#if defined(MUD_SIMD_SSE)
+        _mm_storeu_ps(p, a);
+#elif defined(MUD_SIMD_NEON)
+        vst1q_f32(p, a);
+#else
+        p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3];
+#endif
+    }
+
+    inline float4 set(float x, float y, float z, float w)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_setr_ps(x, y, z, w);
+#elif defined(MUD_SIMD_NEON)
+        const float values[4] = { x, y, z, w };
+        return vld1q_f32(values);
+#else
+        return { { x, y, z, w } };
+#endif
+    }
+
+    inline float4 splat(float s)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_set1_ps(s);
+#elif defined(MUD_SIMD_NEON)
+        return vdupq_n_f32(s);
+#else
+        return { { s, s, s, s } };
+#endif
+    }
+
+    inline float getX(float4 a)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_cvtss_f32(a);
+#elif defined(MUD_SIMD_NEON)
+        return vgetq_lane_f32(a, 0);
+#else
+        return a.v[0];
+#endif
+    }
+
+    inline float4 add(float4 a, float4 b)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_add_ps(a, b);
+#elif defined(MUD_SIMD_NEON)
+        return vaddq_f32(a, b);
+#else
+        return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } };
+#endif
+    }
+
+    inline float4 sub(float4 a, float4 b)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_sub_ps(a, b);
+#elif defined(MUD_SIMD_NEON)
+        return vsubq_f32(a, b);
+#else
+        return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } };
+#endif
+    }
+
+    inline float4 mul(float4 a, float4 b)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_mul_ps(a, b);
+#elif defined(MUD_SIMD_NEON)
+        return vmulq_f32(a, b);
+#else
+        return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } };
+#endif
+    }
+
+    inline float4 div(float4 a, float4 b)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_div_ps(a, b);
+#elif defined(MUD_SIMD_NEON)
+        return vdivq_f32(a, b);
+#else
+        return { { a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3] } };
+#endif
+    }
+
+    inline float4 min(float4 a, float4 b)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_min_ps(a, b);
+#elif defined(MUD_SIMD_NEON)
+        return vminq_f32(a, b);
+#else
+        return { { a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1], a.v[2] < b.v[2] ? a.v[2] : b.v[2], a.v[3] < b.v[3] ? a.v[3] : b.v[3] } };
+#endif
+    }
+
+    inline float4 max(float4 a, float4 b)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_max_ps(a, b);
+#elif defined(MUD_SIMD_NEON)
+        return vmaxq_f32(a, b);
+#else
+        return { { a.v[0] > b.v[0] ? a.v[0] : b.v[0], a.v[1] > b.v[1] ? a.v[1] : b.v[1], a.v[2] > b.v[2] ? a.v[2] : b.v[2], a.v[3] > b.v[3] ? a.v[3] : b.v[3] } };
+#endif
+    }
+
+    // Comparisons return lanes with all bits set where true and clear where false
+
+    inline float4 lessThan(float4 a, float4 b)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_cmplt_ps(a, b);
+#elif defined(MUD_SIMD_NEON)
+        return vreinterpretq_f32_u32(vcltq_f32(a, b));
+#else
+        return { { scalar::toMask(a.v[0] < b.v[0]), scalar::toMask(a.v[1] < b.v[1]), scalar::toMask(a.v[2] < b.v[2]), scalar::toMask(a.v[3] < b.v[3]) } };
+#endif
+    }
+
+    inline float4 lessEqual(float4 a, float4 b)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_cmple_ps(a, b);
+#elif defined(MUD_SIMD_NEON)
+        return vreinterpretq_f32_u32(vcleq_f32(a, b));
+#else
+        return { { scalar::toMask(a.v[0] <= b.v[0]), scalar::toMask(a.v[1] <= b.v[1]), scalar::toMask(a.v[2] <= b.v[2]), scalar::toMask(a.v[3] <= b.v[3]) } };
+#endif
+    }
+
+    inline float4 greaterThan(float4 a, float4 b)
+    {
+        return lessThan(b, a);
+    }
+
+    inline float4 greaterEqual(float4 a, float4 b)
+    {
+        return lessEqual(b, a);
+    }
+
+    inline float4 bitAnd(float4 a, float4 b)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_and_ps(a, b);
+#elif defined(MUD_SIMD_NEON)
+        return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#else
+        float4 result;
+        for (unsigned int idx = 0; idx < 4; ++idx)
+            result.v[idx] = scalar::fromBits(scalar::toBits(a.v[idx]) & scalar::toBits(b.v[idx]));
+        return result;
+#endif
+    }
+
+    inline float4 bitOr(float4 a, float4 b)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_or_ps(a, b);
+#elif defined(MUD_SIMD_NEON)
+        return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#else
+        float4 result;
+        for (unsigned int idx = 0; idx < 4; ++idx)
+            result.v[idx] = scalar::fromBits(scalar::toBits(a.v[idx]) | scalar::toBits(b.v[idx]));
+        return result;
+#endif
+    }
+
+    // Returns mask ? a : b per lane, for masks from the comparisons
+    inline float4 select(float4 mask, float4 a, float4 b)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+#elif defined(MUD_SIMD_NEON)
+        return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+#else
+        float4 result;
+        for (unsigned int idx = 0; idx < 4; ++idx)
+            result.v[idx] = scalar::toBits(mask.v[idx]) != 0 ? a.v[idx] : b.v[idx];
+        return result;
+#endif
+    }
+
+    inline float4 abs(float4 a)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+#elif defined(MUD_SIMD_NEON)
+        return vabsq_f32(a);
+#else
+        return { { a.v[0] < 0 ? -a.v[0] : a.v[0], a.v[1] < 0 ? -a.v[1] : a.v[1], a.v[2] < 0 ? -a.v[2] : a.v[2], a.v[3] < 0 ? -a.v[3] : a.v[3] } };
+#endif
+    }
+
+    // Packs the top bit of each lane into the low 4 bits, lane 0 in bit 0
+    inline int moveMask(float4 a)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_movemask_ps(a);
+#elif defined(MUD_SIMD_NEON)
+        const uint32_t weightValues[4] = { 1, 2, 4, 8 };
+        const uint32x4_t topBits = vshrq_n_u32(vreinterpretq_u32_f32(a), 31);
+        return static_cast<int>(vaddvq_u32(vmulq_u32(topBits, vld1q_u32(weightValues))));
+#else
+        int mask = 0;
+        for (unsigned int idx = 0; idx < 4; ++idx)
+            mask |= static_cast<int>(scalar::toBits(a.v[idx]) >> 31) << idx;
+        return mask;
+#endif
+    }
+
+    // a * b + c
+    inline float4 multiplyAdd(float4 a, float4 b, float4 c)
+    {
+#if defined(MUD_SIMD_NEON)
+        return vmlaq_f32(c, a, b);
+#else
+        return add(mul(a, b), c);
+#endif
+    }
+
+    // Returns { a[X], a[Y], b[Z], b[W] }, the same selection as _mm_shuffle_ps
+    template<int X, int Y, int Z, int W>
+    inline float4 shuffle(float4 a, float4 b)
+    {
+        static_assert(X >= 0 && X < 4 && Y >= 0 && Y < 4 && Z >= 0 && Z < 4 && W >= 0 && W < 4, "Shuffle lanes must be in [0, 3]");
+#if defined(MUD_SIMD_SSE)
+        return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+#elif defined(MUD_SIMD_NEON)
+        float32x4_t result = vdupq_n_f32(vgetq_lane_f32(a, X));
+        result = vsetq_lane_f32(vgetq_lane_f32(a, Y), result, 1);
+        result = vsetq_lane_f32(vgetq_lane_f32(b, Z), result, 2);
+        return vsetq_lane_f32(vgetq_lane_f32(b, W), result, 3);
+#else
+        return { { a.v[X], a.v[Y], b.v[Z], b.v[W] } };
+#endif
+    }
+
+    // Returns { a[X], a[Y], a[Z], a[W] }
+    template<int X, int Y, int Z, int W>
+    inline float4 swizzle(float4 a)
+    {
+#if defined(MUD_SIMD_SSE)
+        return _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(a), _MM_SHUFFLE(W, Z, Y, X)));
+#else
+        return shuffle<X, Y, Z, W>(a, a);
+#endif
+    }
+
+    // Broadcasts lane I to every lane
+    template<int I>
+    inline float4 splatLane(float4 a)
+    {
+#if defined(MUD_SIMD_NEON)
+        return vdupq_laneq_f32(a, I);
+#else
+        return swizzle<I, I, I, I>(a);
+#endif
+    }
+
+    // Sum of all lanes, broadcast to every lane
+    inline float4 horizontalSum(float4 a)
+    {
+        const float4 pairSums = add(a, swizzle<1, 0, 3, 2>(a));
+        return add(pairSums, swizzle<2, 3, 0, 1>(pairSums));
+    }
+
+    // 3D cross product of the first three lanes, lane 3 is a.w * b.w - a.w * b.w
+    inline float4 cross3(float4 a, float4 b)
+    {
+        return sub(
+            mul(swizzle<1, 2, 0, 3>(a), swizzle<2, 0, 1, 3>(b)),
+            mul(swizzle<2, 0, 1, 3>(a), swizzle<1, 2, 0, 3>(b)));
+    }
+
+    // 3D dot product of the first three lanes, broadcast to every lane
+    inline float4 dot3(float4 a, float4 b)
+    {
+        const float4 products = mul(a, b);
+        return add(splatLane<0>(products), add(splatLane<1>(products), splatLane<2>(products)));
+    }
+
+    inline void transpose(float4 & r0, float4 & r1, float4 & r2, float4 & r3)
+    {
+        const float4 t0 = shuffle<0, 1, 0, 1>(r0, r1);
+        const float4 t1 = shuffle<0, 1, 0, 1>(r2, r3);
+        const float4 t2 = shuffle<2, 3, 2, 3>(r0, r1);
+        const float4 t3 = shuffle<2, 3, 2, 3>(r2, r3);
+
+        r0 = shuffle<0, 2, 0, 2>(t0, t1);
+        r1 = shuffle<1, 3, 1, 3>(t0, t1);
+        r2 = shuffle<0, 2, 0, 2>(t2, t3);
+        r3 = shuffle<1, 3, 1, 3>(t2, t3);
+    }
+}
+
+#endif
@@ -0,0 +1,255 @@
+#include "triangle_bvh.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "utils/serialization_helpers.hpp"
+
+namespace mud
+{
+    namespace
+    {
+        constexpr uint32_t k_numBins = 12;
+
+        float getHalfSurfaceArea(const AABB & aabb)
+        {
+            if (aabb.isEmpty())
+                return 0;
+
+            const Vector3 size = aabb.max - aabb.min;
+            return size.x * size.y + size.y * size.z + size.z * size.x;
+        }
+    }
+
+    bool TriangleBVH::isEmpty() const
+    {
+        return m_nodes.empty();
+    }
+
+    void TriangleBVH::build(const std::vector<AABB> & triangleBounds)
+    {
+        clear();
+
+        if (triangleBounds.empty())
+            return;
+
+        m_triangleIndices.resize(triangleBounds.size());
+        for (uint32_t idx = 0; idx < m_triangleIndices.size(); ++idx)
+            m_triangleIndices[idx] = idx;
+
+        std::vector<Vector3> centroids(triangleBounds.size());
+        for (size_t idx = 0; idx < triangleBounds.size(); ++idx)
+            centroids[idx] = triangleBounds[idx].getCenter();
+
+        // A binary tree with n leaves has at most 2n - 1 nodes
+        m_nodes.reserve(triangleBounds.size() * 2);
+
+        Node & root = m_nodes.emplace_back();
+        root.leftOrFirst = 0;
+        root.numTriangles = static_cast<uint32_t>(triangleBounds.size());
+
+        subdivide(0, triangleBounds, centroids, 0);
+
+        m_nodes.shrink_to_fit();
+    }
+
+    void TriangleBVH::clear()
+    {
+        m_nodes.clear();
+        m_triangleIndices.clear();
+    }
+
+    bool TriangleBVH::isValid(size_t numTriangles) const
+    {
+        if (m_nodes.empty())
+            return m_triangleIndices.empty() && numTriangles == 0;
+
+        for (uint32_t triangleIdx : m_triangleIndices)
+            if (triangleIdx >= numTriangles)
+                return false;
+
+        struct StackEntry
+        {
+            uint32_t node;
+            uint32_t depth;
+        };
+
+        // Walks the tree from the root, every reachable node is checked and the walk is bounded by the depth
+        std::vector<StackEntry> stack;
+        stack.push_back({ 0, 0 });
+
+        while (!stack.empty())
+        {
+            const StackEntry entry = stack.back();
+            stack.pop_back();
+
+            const Node & node = m_nodes[entry.node];
+
+            if (node.isLeaf())
+            {
+                if (static_cast<uint64_t>(node.leftOrFirst) + node.numTriangles > m_triangleIndices.size())
+                    return false;
+                continue;
+            }
+
+            if (entry.depth >= k_maxDepth || static_cast<uint64_t>(node.leftOrFirst) + 1 >= m_nodes.size())
+                return false;
+
+            stack.push_back({ node.leftOrFirst, entry.depth + 1 });
+            stack.push_back({ node.leftOrFirst + 1, entry.depth + 1 });
+        }
+
+        return true;
+    }
+
+    const std::vector<TriangleBVH::Node> & TriangleBVH::getNodes() const
+    {
+        return m_nodes;
+    }
+
+    const std::vector<uint32_t> & TriangleBVH::getTriangleIndices() const
+    {
+        return m_triangleIndices;
+    }
+
+    bool TriangleBVH::deserialize(std::ifstream & file)
+    {
+        return serialization_helpers::deserializeVector(file, m_nodes) &&
+            serialization_helpers::deserializeVector(file, m_triangleIndices);
+    }
+
+    bool TriangleBVH::serialize(std::ofstream & file) const
+    {
+        return serialization_helpers::serializeVector(file, m_nodes) &&
+            serialization_helpers::serializeVector(file, m_triangleIndices);
+    }
+
+    bool TriangleBVH::rayCastNode(const Node & node, const Vector3 & origin, const Vector3 & inverseDirection, float maxDistance, float & entryDistance)
+    {
+        float tMin = 0;
+        float tMax = maxDistance;
+
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            float t1 = (node.min[axis] - origin[axis]) * inverseDirection[axis];
+            float t2 = (node.max[axis] - origin[axis]) * inverseDirection[axis];
+
+            if (t1 > t2)
+                std::swap(t1, t2);
+
+            if (t1 > tMin)
+                tMin = t1;
+            if (t2 < tMax)
+                tMax = t2;
+
+            if (tMin > tMax)
+                return false;
+        }
+
+        entryDistance = tMin;
+        return true;
+    }
+
+    void TriangleBVH::subdivide(uint32_t nodeIdx, const std::vector<AABB> & triangleBounds, const std::vector<Vector3> & centroids, uint32_t depth)
+    {
+        const uint32_t first = m_nodes[nodeIdx].leftOrFirst;
+        const uint32_t count = m_nodes[nodeIdx].numTriangles;
+
+        AABB nodeBounds = AABB::empty;
+        AABB centroidBounds = AABB::empty;
+        for (uint32_t idx = first; idx < first + count; ++idx)
+        {
+            nodeBounds.merge(triangleBounds[m_triangleIndices[idx]]);
+            centroidBounds.merge(AABB(centroids[m_triangleIndices[idx]], centroids[m_triangleIndices[idx]]));
+        }
+
+        m_nodes[nodeIdx].min = nodeBounds.min;
+        m_nodes[nodeIdx].max = nodeBounds.max;
+
+        if (count <= k_maxLeafTriangles || depth >= k_maxDepth)
+            return;
+
+        // Bin triangle centroids along each axis and find the split plane with the lowest surface area cost
+        float bestCost = std::numeric_limits<float>::max();
+        unsigned int bestAxis = 0;
+        uint32_t bestSplit = 0;
+
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            const float axisMin = centroidBounds.min[axis];
+            const float axisExtent = centroidBounds.max[axis] - axisMin;
+            if (axisExtent <= 0)
+                continue;
+
+            AABB binBounds[k_numBins];
+            uint32_t binCounts[k_numBins] = {};
+            std::fill(std::begin(binBounds), std::end(binBounds), AABB::empty);
+
+            const float binScale = k_numBins / axisExtent;
+            for (uint32_t idx = first; idx < first + count; ++idx)
+            {
+                const uint32_t triangleIdx = m_triangleIndices[idx];
+                const uint32_t bin = std::min(k_numBins - 1, static_cast<uint32_t>((centroids[triangleIdx][axis] - axisMin) * binScale));
+                binBounds[bin].merge(triangleBounds[triangleIdx]);
+                ++binCounts[bin];
+            }
+
+            // Sweep from both ends to get the cost of every split between bins
+            float leftAreas[k_numBins - 1];
+            uint32_t leftCounts[k_numBins - 1];
+            AABB leftBounds = AABB::empty;
+            uint32_t leftCount = 0;
+            for (uint32_t split = 0; split < k_numBins - 1; ++split)
+            {
+                leftBounds.merge(binBounds[split]);
+                leftCount += binCounts[split];
+                leftAreas[split] = getHalfSurfaceArea(leftBounds);
+                leftCounts[split] = leftCount;
+            }
+
+            AABB rightBounds = AABB::empty;
+            uint32_t rightCount = 0;
+            for (uint32_t split = k_numBins - 1; split > 0; --split)
+            {
+                rightBounds.merge(binBounds[split]);
+                rightCount += binCounts[split];
+
+                const float cost = leftCounts[split - 1] * leftAreas[split - 1] + rightCount * getHalfSurfaceArea(rightBounds);
+                if (leftCounts[split - 1] > 0 && rightCount > 0 && cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        // Stay a leaf if no split is cheaper than testing every triangle here
+        if (bestCost >= count * getHalfSurfaceArea(nodeBounds))
+            return;
+
+        const float axisMin = centroidBounds.min[bestAxis];
+        const float binScale = k_numBins / (centroidBounds.max[bestAxis] - axisMin);
+
+        uint32_t * const middle = std::partition(m_triangleIndices.data() + first, m_triangleIndices.data() + first + count, [&](uint32_t triangleIdx) {
+            return std::min(k_numBins - 1, static_cast<uint32_t>((centroids[triangleIdx][bestAxis] - axisMin) * binScale)) < bestSplit;
+        });
+
+        const uint32_t leftCount = static_cast<uint32_t>(middle - m_triangleIndices.data()) - first;
+
+        const uint32_t leftIdx = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+        m_nodes.emplace_back();
+
+        m_nodes[leftIdx].leftOrFirst = first;
+        m_nodes[leftIdx].numTriangles = leftCount;
+        m_nodes[leftIdx + 1].leftOrFirst = first + leftCount;
+        m_nodes[leftIdx + 1].numTriangles = count - leftCount;
+
+        m_nodes[nodeIdx].leftOrFirst = leftIdx;
+        m_nodes[nodeIdx].numTriangles = 0;
+
+        subdivide(leftIdx, triangleBounds, centroids, depth + 1);
+        subdivide(leftIdx + 1, triangleBounds, centroids, depth + 1);
+    }
+}
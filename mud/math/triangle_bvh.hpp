@@ -0,0 +1,174 @@
+#ifndef MUD_TRIANGLE_BVH_HPP
+#define MUD_TRIANGLE_BVH_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+#include "aabb.hpp"
+#include "intersection_test.hpp"
+
+namespace mud
+{
+    // Static bounding volume hierarchy over the triangles of a mesh, built with a binned surface area heuristic.
+    // Nodes are 32 bytes and siblings are stored next to each other, so only the left child index is kept.
+    class TriangleBVH
+    {
+    public:
+
+        struct Node
+        {
+            Vector3 min;
+
+            // Index of the left child for interior nodes (the right child follows it), or of the first entry in the
+            // triangle index list for leaves
+            uint32_t leftOrFirst;
+
+            Vector3 max;
+
+            // Number of triangles in a leaf, 0 for interior nodes
+            uint32_t numTriangles;
+
+            bool isLeaf() const
+            {
+                return numTriangles > 0;
+            }
+        };
+
+        static_assert(sizeof(Vector3) == 12, "TriangleBVH::Node relies on a packed Vector3");
+
+        bool isEmpty() const;
+
+        // Builds the hierarchy from the bounds of each triangle
+        void build(const std::vector<AABB> & triangleBounds);
+
+        void clear();
+
+        // Returns true if every node and triangle index is in range for a mesh with numTriangles triangles and the
+        // depth fits the traversal stack. Used to reject stale or corrupt hierarchies loaded from disk.
+        bool isValid(size_t numTriangles) const;
+
+        const std::vector<Node> & getNodes() const;
+
+        // Triangle indices in leaf order, leaves reference contiguous ranges of this list
+        const std::vector<uint32_t> & getTriangleIndices() const;
+
+        // Visits leaf triangles front to back. callback(triangleIdx, maxDistance) returns the new maximum distance:
+        // the hit distance to clip the ray, or maxDistance to carry on.
+        template<typename Callback>
+        void rayCast(const Vector3 & origin, const Vector3 & direction, float maxDistance, Callback callback) const
+        {
+            if (m_nodes.empty())
+                return;
+
+            const Vector3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+            struct StackEntry
+            {
+                uint32_t node;
+                float entryDistance;
+            };
+
+            StackEntry stack[64];
+            uint32_t stackSize = 0;
+
+            float entryDistance = 0;
+            if (rayCastNode(m_nodes[0], origin, inverseDirection, maxDistance, entryDistance))
+                stack[stackSize++] = { 0, entryDistance };
+
+            while (stackSize > 0)
+            {
+                const StackEntry entry = stack[--stackSize];
+                if (entry.entryDistance > maxDistance)
+                    continue;
+
+                const Node & node = m_nodes[entry.node];
+
+                if (node.isLeaf())
+                {
+                    for (uint32_t idx = node.leftOrFirst; idx < node.leftOrFirst + node.numTriangles; ++idx)
+                        maxDistance = callback(m_triangleIndices[idx], maxDistance);
+                    continue;
+                }
+
+                const uint32_t left = node.leftOrFirst;
+                const uint32_t right = node.leftOrFirst + 1;
+
+                float leftEntryDistance = 0;
+                float rightEntryDistance = 0;
+                const bool isLeftHit = rayCastNode(m_nodes[left], origin, inverseDirection, maxDistance, leftEntryDistance);
+                const bool isRightHit = rayCastNode(m_nodes[right], origin, inverseDirection, maxDistance, rightEntryDistance);
+
+                // Push the farther child first so the nearer one is visited first
+                if (isLeftHit && isRightHit)
+                {
+                    if (leftEntryDistance < rightEntryDistance)
+                    {
+                        stack[stackSize++] = { right, rightEntryDistance };
+                        stack[stackSize++] = { left, leftEntryDistance };
+                    }
+                    else
+                    {
+                        stack[stackSize++] = { left, leftEntryDistance };
+                        stack[stackSize++] = { right, rightEntryDistance };
+                    }
+                }
+                else if (isLeftHit)
+                    stack[stackSize++] = { left, leftEntryDistance };
+                else if (isRightHit)
+                    stack[stackSize++] = { right, rightEntryDistance };
+            }
+        }
+
+        // Visits leaf triangles in nodes that any ray in the packet hits. callback(triangleIdx) tests the packet and
+        // lowers maxDistances for the rays that hit, which stops them from keeping far nodes alive. Nodes are visited
+        // in no particular order, since the rays may disagree on which child is nearer.
+        template<size_t N, typename Callback>
+        void rayCast(const RayPacket<N> & rays, const float * maxDistances, Callback callback) const
+        {
+            if (m_nodes.empty())
+                return;
+
+            uint32_t stack[64];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = 0;
+
+            while (stackSize > 0)
+            {
+                const Node & node = m_nodes[stack[--stackSize]];
+                if (intersection_test::rayCastAABB(rays, AABB(node.min, node.max), maxDistances) == 0)
+                    continue;
+
+                if (node.isLeaf())
+                {
+                    for (uint32_t idx = node.leftOrFirst; idx < node.leftOrFirst + node.numTriangles; ++idx)
+                        callback(m_triangleIndices[idx]);
+                    continue;
+                }
+
+                stack[stackSize++] = node.leftOrFirst + 1;
+                stack[stackSize++] = node.leftOrFirst;
+            }
+        }
+
+        bool deserialize(std::ifstream & file);
+
+        bool serialize(std::ofstream & file) const;
+
+    private:
+
+        static constexpr uint32_t k_maxLeafTriangles = 4;
+
+        // Bounds the depth so the fixed-size traversal stack can never overflow
+        static constexpr uint32_t k_maxDepth = 32;
+
+        static bool rayCastNode(const Node & node, const Vector3 & origin, const Vector3 & inverseDirection, float maxDistance, float & entryDistance);
+
+        void subdivide(uint32_t nodeIdx, const std::vector<AABB> & triangleBounds, const std::vector<Vector3> & centroids, uint32_t depth);
+
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_triangleIndices;
+    };
+}
+
+#endif
@@ -2,6 +2,7 @@
 
 #include <cmath>
 
+#include "../simd.hpp"
 #include "vector_2.hpp"
 #include "vector_3.hpp"
 
@@ -84,56 +85,37 @@ namespace mud
 
 	Vector4& Vector4::operator+=(const Vector4& rhs)
 	{
-		x += rhs.x;
-		y += rhs.y;
-		z += rhs.z;
-		w += rhs.w;
+		simd::storeUnaligned(&x, simd::add(simd::loadUnaligned(&x), simd::loadUnaligned(&rhs.x)));
 		return *this;
 	}
 
 	Vector4& Vector4::operator-=(const Vector4& rhs)
 	{
-		x -= rhs.x;
-		y -= rhs.y;
-		z -= rhs.z;
-		w -= rhs.w;
+		simd::storeUnaligned(&x, simd::sub(simd::loadUnaligned(&x), simd::loadUnaligned(&rhs.x)));
 		return *this;
 	}
 
 	Vector4& Vector4::operator*=(const Vector4& rhs)
 	{
-
-		x *= rhs.x;
-		y *= rhs.y;
-		z *= rhs.z;
-		w *= rhs.w;
+		simd::storeUnaligned(&x, simd::mul(simd::loadUnaligned(&x), simd::loadUnaligned(&rhs.x)));
 		return *this;
 	}
 
 	Vector4& Vector4::operator/=(const Vector4& rhs)
 	{
-		x /= rhs.x;
-		y /= rhs.y;
-		z /= rhs.z;
-		w /= rhs.w;
+		simd::storeUnaligned(&x, simd::div(simd::loadUnaligned(&x), simd::loadUnaligned(&rhs.x)));
 		return *this;
 	}
 
 	Vector4& Vector4::operator*=(float s)
 	{
-		x *= s;
-		y *= s;
-		z *= s;
-		w *= s;
+		simd::storeUnaligned(&x, simd::mul(simd::loadUnaligned(&x), simd::splat(s)));
 		return *this;
 	}
 
 	Vector4& Vector4::operator/=(float s)
 	{
-		x /= s;
-		y /= s;
-		z /= s;
-		w /= s;
+		simd::storeUnaligned(&x, simd::div(simd::loadUnaligned(&x), simd::splat(s)));
 		return *this;
 	}
 
@@ -13,6 +13,7 @@ namespace mud
 	/**
 	 * \brief A mathematical 4-component floating-point vector.
 	 * \details A struct representing a 4-component Vector whose components are stored as floats.
+	 * \note Vector4 is not over-aligned as it is embedded in vertex and GPU buffer layouts. Its arithmetic uses unaligned SIMD loads instead.
 	 */
 	struct Vector4
 	{
@@ -1,39 +1,166 @@
 #include "scene.hpp"
 
+#include <algorithm>
+
 #include "graphics/camera.hpp"
 #include "math/intersection_test.hpp"
+#include "utils/job_system.hpp"
 
 namespace mud
 {
-    void renderSceneGraphNode(const SceneGraph::Node & sceneGraphNode, ForwardRenderer & renderer, const Matrix4 & parentTransform = Matrix4::identity)
+    void addRenderProxyCommand(const RenderProxy & proxy, Scene::RenderList & renderList)
+    {
+        renderList.commands.push_back(RenderCommand{ proxy.mesh, proxy.worldTransform, proxy.material });
+        renderList.commandWorldBounds.push_back(&proxy.worldBounds);
+        ++renderList.statistics.numVisible;
+    }
+
+    // What culling needs to measure render proxies on screen: the row of the view projection giving clip w, and
+    // the thresholds of the scene's LOD settings
+    struct ScreenSizeTest
+    {
+        Vector4 clipW;
+        float pixelsPerUnit;
+        bool isPerspective;
+        const Scene::LodSettings * settings;
+    };
+
+    ScreenSizeTest makeScreenSizeTest(const Camera & camera, const Scene::LodSettings & settings)
+    {
+        const Matrix4 & projection = camera.getProjectionMatrix();
+        const Matrix4 viewProjection = projection * camera.getViewMatrix();
+
+        ScreenSizeTest test;
+        test.clipW = Vector4(viewProjection[0].w, viewProjection[1].w, viewProjection[2].w, viewProjection[3].w);
+        // Orthographic projections built with top below bottom flip y, which only the sign shows
+        test.pixelsPerUnit = std::abs(projection[1].y) * settings.screenHeight;
+        test.isPerspective = projection[3].w == 0.0f;
+        test.settings = &settings;
+        return test;
+    }
+
+    // Pixels across the proxy's bounding sphere, as large as can be when the camera is inside it
+    float getPixelSize(const ScreenSizeTest & test, const RenderProxy & proxy)
+    {
+        const Vector3 & center = proxy.lodCenter;
+        const float w = test.clipW.x * center.x + test.clipW.y * center.y + test.clipW.z * center.z + test.clipW.w;
+
+        if (test.isPerspective && w <= proxy.lodRadius)
+            return std::numeric_limits<float>::max();
+
+        return proxy.lodRadius * test.pixelsPerUnit / w;
+    }
+
+    // Whether the proxy belongs to the level of detail its node draws at this size and is large enough to draw
+    bool passesScreenSizeTest(const ScreenSizeTest & test, const RenderProxy & proxy, Scene::CullingStatistics & statistics)
     {
-        const Matrix4 transform = parentTransform * sceneGraphNode.data.transform;
+        const Scene::LodSettings & settings = *test.settings;
+        const float minPixelSize = proxy.minPixelSize >= 0.0f ? proxy.minPixelSize : settings.minPixelSize;
 
-        bool shouldRender = !sceneGraphNode.data.isHidden;
+        // Nodes without lower levels or a size limit need no measuring
+        if (proxy.numLodLevels == 1 && minPixelSize <= 0.0f)
+            return true;
 
-        // frustrum culling
+        const float pixelSize = getPixelSize(test, proxy);
 
-        if (shouldRender)
+        if (proxy.numLodLevels > 1)
         {
-            for (const auto & pair : sceneGraphNode.data.materialMeshPairs)
+            int32_t lodLevel = proxy.forcedLodLevel;
+            if (lodLevel < 0)
             {
-                renderer.submit(RenderCommand{
-                    pair.second->get(),
-                    transform,
-                    pair.first->get()
-                });
+                lodLevel = 0;
+                while (lodLevel < static_cast<int32_t>(settings.lodPixelSizes.size()) && pixelSize < settings.lodPixelSizes[lodLevel])
+                    ++lodLevel;
             }
 
-            for (const PointLight & light : sceneGraphNode.data.pointLights)
-                renderer.submit(light);
+            // The other levels of the node are not drawn, but not culled either
+            if (std::min(lodLevel, proxy.numLodLevels - 1) != proxy.lodLevel)
+                return false;
         }
 
-        for (const auto & childNode : sceneGraphNode.children)
-            renderSceneGraphNode(*childNode, renderer, transform);
+        if (pixelSize < minPixelSize)
+        {
+            ++statistics.numCulled;
+            ++statistics.numTooSmall;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Frustum culls the render proxies in [first, last) into renderList, after dropping those of other levels of
+    // detail and those too small on screen
+    void cullRenderProxies(const std::vector<RenderProxy> & proxies, size_t first, size_t last, const Frustum & frustum, const ScreenSizeTest & screenSizeTest, Scene::RenderList & renderList)
+    {
+        Scene::CullingStatistics & statistics = renderList.statistics;
+
+        for (size_t idx = first; idx < last; ++idx)
+        {
+            const RenderProxy & proxy = proxies[idx];
+
+            if (!passesScreenSizeTest(screenSizeTest, proxy, statistics))
+                continue;
+
+            ++statistics.numFrustumTests;
+            if (intersection_test::frustumAABB(frustum, proxy.worldBounds) == FrustumTestResult::Outside)
+            {
+                ++statistics.numCulled;
+                continue;
+            }
+
+            addRenderProxyCommand(proxy, renderList);
+        }
+    }
+
+    // Culls a layer indexed by a loose octree into renderList. Only the proxies the query returns count as tested.
+    // Which level of detail the others would have drawn is not known, so they count as culled at full detail.
+    void cullRenderProxies(const RenderWorld & renderWorld, uint32_t layer, const Frustum & frustum, const ScreenSizeTest & screenSizeTest, Scene::RenderList & renderList)
+    {
+        Scene::CullingStatistics & statistics = renderList.statistics;
+        size_t numTested = 0;
+        size_t numFullDetailTested = 0;
+
+        renderWorld.getLayerOctree(layer)->queryFrustum(frustum, [&](int32_t octreeProxyId) {
+            const RenderProxy & proxy = renderWorld.getProxy(static_cast<int32_t>(renderWorld.getLayerOctree(layer)->getUserData(octreeProxyId)));
+
+            ++numTested;
+            if (proxy.lodLevel == 0)
+                ++numFullDetailTested;
+
+            if (passesScreenSizeTest(screenSizeTest, proxy, statistics))
+                addRenderProxyCommand(proxy, renderList);
+            return true;
+        });
+
+        statistics.numFrustumTests += numTested;
+        statistics.numCulled += renderWorld.getNumFullDetailProxies(layer) - numFullDetailTested;
+    }
+
+    void Scene::RenderList::clear()
+    {
+        commands.clear();
+        commandWorldBounds.clear();
+        pointLights.clear();
+        statistics = CullingStatistics{};
+    }
+
+    void Scene::RenderList::append(const RenderList & other)
+    {
+        commands.insert(commands.end(), other.commands.begin(), other.commands.end());
+        commandWorldBounds.insert(commandWorldBounds.end(), other.commandWorldBounds.begin(), other.commandWorldBounds.end());
+        pointLights.insert(pointLights.end(), other.pointLights.begin(), other.pointLights.end());
+
+        statistics.numVisible += other.statistics.numVisible;
+        statistics.numCulled += other.statistics.numCulled;
+        statistics.numFrustumTests += other.statistics.numFrustumTests;
+        statistics.numTooSmall += other.statistics.numTooSmall;
     }
 
     Scene::Scene()
-    { }
+        : m_isOcclusionCullingEnabled(false)
+    {
+        m_graph.setChangeTrackingEnabled(true);
+    }
 
     const SceneGraph & Scene::getGraph() const
     {
@@ -45,96 +172,579 @@ namespace mud
         return m_graph;
     }
 
-    bool rayCastQueryMesh(const Vector3 & rayOrigin, const Vector3 & rayDirection, const Mesh * mesh, float & hitDistance)
+    const ecs::World & Scene::getWorld() const
+    {
+        return m_world;
+    }
+
+    const RenderWorld & Scene::getRenderWorld() const
+    {
+        return m_renderWorld;
+    }
+
+    void Scene::setLayerIndex(uint32_t layer, RenderLayerIndex index, const AABB & octreeBounds, uint32_t octreeMaxDepth)
+    {
+        m_renderWorld.setLayerIndex(layer, index, octreeBounds, octreeMaxDepth);
+    }
+
+    void Scene::updateEntities()
+    {
+        m_graph.updateWorldTransforms();
+
+        m_updatedNodes.clear();
+        m_deletedNodes.clear();
+        m_graph.takeChanges(m_updatedNodes, m_deletedNodes);
+
+        // Deletions go first, a deleted node's slot may already hold a new node listed as updated
+        for (SceneGraph::Handle node : m_deletedNodes)
+            if (node.index < m_nodeEntities.size() && m_nodeEntities[node.index].generation == node.generation)
+                destroyNodeEntities(node.index);
+
+        for (SceneGraph::Handle node : m_updatedNodes)
+            if (m_graph.isValid(node))
+                updateNodeEntities(node);
+    }
+
+    void Scene::updateNodeEntities(SceneGraph::Handle node)
     {
-        const RayCastResult rayCastOBBResult = intersection_test::rayCastOBB(rayOrigin, rayDirection, mesh->getBoundingBox(), Matrix4::identity);         
-        if (rayCastOBBResult.isIntersection && (hitDistance == 0 || rayCastOBBResult.distance < hitDistance))
+        if (node.index >= m_nodeEntities.size())
+            m_nodeEntities.resize(node.index + 1);
+
+        if (m_nodeEntities[node.index].generation != node.generation)
+        {
+            destroyNodeEntities(node.index);
+            m_nodeEntities[node.index].generation = node.generation;
+        }
+
+        NodeEntities & entities = m_nodeEntities[node.index];
+        const SceneGraphNodeData & nodeData = m_graph.getData(node);
+
+        // Meshes merged into static batches are drawn by the batches instead, at full detail
+        const size_t numLodLevels = nodeData.isStaticBatched() ? 0 : nodeData.lodMaterialMeshPairs.size() + 1;
+
+        size_t numMeshes = 0;
+        for (size_t level = 0; level < numLodLevels; ++level)
+            numMeshes += level == 0 ? nodeData.materialMeshPairs.size() : nodeData.lodMaterialMeshPairs[level - 1].size();
+
+        // Entities are reused in place while the node keeps its number of meshes and lights, as moving nodes do
+        while (entities.meshes.size() > numMeshes)
+        {
+            destroyMeshEntity(entities.meshes.back());
+            entities.meshes.pop_back();
+        }
+
+        while (entities.meshes.size() < numMeshes)
+            entities.meshes.push_back(m_world.create(MeshRendererComponent{ RenderWorld::k_nullProxy }));
+
+        while (entities.lights.size() > nodeData.pointLights.size())
+        {
+            m_world.destroy(entities.lights.back());
+            entities.lights.pop_back();
+        }
+
+        while (entities.lights.size() < nodeData.pointLights.size())
+            entities.lights.push_back(m_world.create(PointLightComponent{}, VisibilityComponent{}));
+
+        // Every level of detail is sized by the bounds of the full detail meshes, so that they all switch together.
+        // Nodes with no full detail mesh size each mesh by its own bounds.
+        const AABB & lodBounds = nodeData.getWorldBounds();
+
+        size_t entityIdx = 0;
+        for (size_t level = 0; level < numLodLevels; ++level)
         {
-            const std::vector<MeshVertex> & meshVertices = mesh->getVertices();
-            const std::vector<uint32_t> meshIndices = mesh->getIndices();
+            const auto & materialMeshPairs = level == 0 ? nodeData.materialMeshPairs : nodeData.lodMaterialMeshPairs[level - 1];
 
-            if (meshIndices.size() == 0)
+            for (size_t idx = 0; idx < materialMeshPairs.size(); ++idx)
             {
-                for (size_t idx = 0; idx < meshVertices.size(); idx += 3)
+                const ecs::Entity entity = entities.meshes[entityIdx++];
+                const Mesh * mesh = materialMeshPairs[idx].second->get();
+                const Material * material = materialMeshPairs[idx].first->get();
+
+                // Only visible meshes get a proxy, and those whose assets failed to load are left out
+                int32_t & proxy = m_world.get<MeshRendererComponent>(entity)->proxy;
+                if (nodeData.isHidden || mesh == nullptr || material == nullptr)
                 {
-                    const Vector3 & p0 = meshVertices[idx + 0].position;
-                    const Vector3 & p1 = meshVertices[idx + 1].position;
-                    const Vector3 & p2 = meshVertices[idx + 2].position;
-
-                    if ((p0 - p1).cross(p0 - p2).dot(rayDirection) >= 0)
-                        continue;
-                        
-                    RayCastResult rayCastTriangleResult = intersection_test::rayCastTriangle(rayOrigin, rayDirection, p0, p1, p2);
-                    if (rayCastTriangleResult.isIntersection && (hitDistance == 0 || rayCastTriangleResult.distance < hitDistance))
+                    if (proxy != RenderWorld::k_nullProxy)
                     {
-                        hitDistance = rayCastTriangleResult.distance;
-                        return true;
+                        m_renderWorld.destroyProxy(proxy);
+                        proxy = RenderWorld::k_nullProxy;
                     }
+
+                    continue;
                 }
-            }
-            else
-            {
-                for (size_t idx = 0; idx < meshIndices.size(); idx += 3)
-                {
-                    const Vector3 & p0 = meshVertices[meshIndices[idx + 0]].position;
-                    const Vector3 & p1 = meshVertices[meshIndices[idx + 1]].position;
-                    const Vector3 & p2 = meshVertices[meshIndices[idx + 2]].position;
 
-                    if ((p0 - p1).cross(p0 - p2).dot(rayDirection) >= 0)
-                        continue;
+                // Bounds of the lower levels are not cached by the graph
+                const AABB worldBounds = level == 0 ? nodeData.getMeshWorldBounds(idx) : mesh->getBoundingBox().transform(nodeData.getWorldTransform());
 
-                    RayCastResult rayCastTriangleResult = intersection_test::rayCastTriangle(rayOrigin, rayDirection, p0, p1, p2);
-                    if (rayCastTriangleResult.isIntersection && (hitDistance == 0 || rayCastTriangleResult.distance < hitDistance))
-                    {
-                        hitDistance = rayCastTriangleResult.distance;
-                        return true;
-                    }
+                RenderProxy renderProxy = makeRenderProxy(mesh, material, nodeData.getWorldTransform(), worldBounds, nodeData.layer);
+                if (!lodBounds.isEmpty())
+                {
+                    renderProxy.lodCenter = lodBounds.getCenter();
+                    renderProxy.lodRadius = lodBounds.getExtents().magnitude();
                 }
+                renderProxy.lodLevel = static_cast<uint16_t>(level);
+                renderProxy.numLodLevels = static_cast<uint16_t>(numLodLevels);
+                renderProxy.forcedLodLevel = nodeData.forcedLodLevel;
+                renderProxy.minPixelSize = nodeData.minPixelSize;
+
+                if (proxy == RenderWorld::k_nullProxy)
+                    proxy = m_renderWorld.createProxy(renderProxy);
+                else
+                    m_renderWorld.updateProxy(proxy, renderProxy);
             }
         }
 
-        return false;
+        for (size_t idx = 0; idx < nodeData.pointLights.size(); ++idx)
+        {
+            const ecs::Entity entity = entities.lights[idx];
+
+            *m_world.get<PointLightComponent>(entity) = { nodeData.pointLights[idx] };
+            *m_world.get<VisibilityComponent>(entity) = { nodeData.isHidden };
+        }
     }
 
-    void rayCastQueryNode(SceneGraph::Node * node, const Matrix4 & parentTransform, const Vector3 & rayOrigin, const Vector3 & rayTarget, SceneGraph::Node *& selectedNode, float & hitDistance)
+    void Scene::destroyNodeEntities(uint32_t nodeIndex)
     {
-        const Matrix4 nodeTransform = parentTransform * node->data.transform;
+        NodeEntities & entities = m_nodeEntities[nodeIndex];
 
-        if (!node->data.isHidden)
-        {
-            const Matrix4 inverseNodeTransform = nodeTransform.inverse();
-            const Vector3 rayOriginMeshSpace = inverseNodeTransform * Vector4(rayOrigin, 1.0f);
-            const Vector3 rayTargetMeshSpace = inverseNodeTransform * Vector4(rayTarget, 1.0f);
-            const Vector3 rayDirectionMeshSpace = Vector3(rayTargetMeshSpace - rayOriginMeshSpace).normal();
+        for (ecs::Entity entity : entities.meshes)
+            destroyMeshEntity(entity);
 
-            for (auto & materialMeshPair : node->data.materialMeshPairs)
-                if (rayCastQueryMesh(rayOriginMeshSpace, rayDirectionMeshSpace, materialMeshPair.second->get(), hitDistance))
-                    selectedNode = node;
-        }
+        for (ecs::Entity entity : entities.lights)
+            m_world.destroy(entity);
 
-        for (SceneGraph::Node * child : node->children)
-            rayCastQueryNode(child, nodeTransform, rayOrigin, rayTarget, selectedNode, hitDistance);
+        entities.meshes.clear();
+        entities.lights.clear();
     }
 
-    SceneGraph::Node * Scene::rayCastQuery(const Vector2 & normalisedDeviceCoordinates, Camera & camera)
+    void Scene::destroyMeshEntity(ecs::Entity entity)
     {
-        Vector4 worldSpacePosition = camera.getProjectionViewMatrix().inverse() * Vector4(normalisedDeviceCoordinates.x, -normalisedDeviceCoordinates.y, -1, 1);
+        const int32_t proxy = m_world.get<MeshRendererComponent>(entity)->proxy;
+        if (proxy != RenderWorld::k_nullProxy)
+            m_renderWorld.destroyProxy(proxy);
+
+        m_world.destroy(entity);
+    }
+
+    // Finds the nearest triangle hit closer than hitDistance. The ray direction need not be normalised, distances
+    // are measured in units of it so they stay comparable across differently scaled nodes.
+    bool rayCastQueryMesh(const Vector3 & rayOrigin, const Vector3 & rayDirection, const Mesh * mesh, float & hitDistance)
+    {
+        return mesh != nullptr && mesh->rayCast(rayOrigin, rayDirection, hitDistance);
+    }
+
+    bool rayCastQueryNode(const SceneGraphNodeData & nodeData, const Vector3 & rayOrigin, const Vector3 & rayDirection, float & hitDistance)
+    {
+        if (nodeData.isHidden)
+            return false;
+
+        // Node transforms are affine, so the cheaper affine inverse applies
+        const Matrix4 inverseNodeTransform = inverseAffine(nodeData.getWorldTransform());
+        const Vector3 rayOriginMeshSpace = inverseNodeTransform * Vector4(rayOrigin, 1.0f);
+        const Vector3 rayDirectionMeshSpace = inverseNodeTransform * Vector4(rayDirection, 0.0f);
+
+        bool isHit = false;
+
+        for (auto & materialMeshPair : nodeData.materialMeshPairs)
+            if (rayCastQueryMesh(rayOriginMeshSpace, rayDirectionMeshSpace, materialMeshPair.second->get(), hitDistance))
+                isHit = true;
+
+        return isHit;
+    }
+
+    SceneGraph::Handle Scene::rayCastQuery(const Vector2 & normalisedDeviceCoordinates, Camera & camera)
+    {
+        Vector4 worldSpacePosition = camera.getInverseProjectionViewMatrix() * Vector4(normalisedDeviceCoordinates.x, -normalisedDeviceCoordinates.y, -1, 1);
         worldSpacePosition /= worldSpacePosition.w;
 
-        SceneGraph::Node * selectedNode = nullptr;
-        float hitDistance = 0;
+        return rayCastQuery(camera.getPosition(), Vector3(Vector3(worldSpacePosition) - camera.getPosition()).normal());
+    }
+
+    SceneGraph::Handle Scene::rayCastQuery(const Vector3 & rayOrigin, const Vector3 & rayDirection, float maxDistance, float * hitDistance)
+    {
+        m_graph.updateWorldTransforms();
+
+        SceneGraph::Handle selectedNode;
+        float nearestHitDistance = maxDistance;
 
-        for (SceneGraph::Node * rootNode : m_graph.getRootNodes())
-            rayCastQueryNode(rootNode, Matrix4::identity, camera.getPosition(), worldSpacePosition, selectedNode, hitDistance);
+        // Nodes are visited front to back by their bounds, and the ray is clipped by every hit so farther nodes are skipped
+        m_graph.getBVH().rayCast(rayOrigin, rayDirection, maxDistance, [&](int32_t proxyId, float) -> float {
+            const SceneGraph::Handle node = m_graph.getBVHProxyNode(proxyId);
+            if (rayCastQueryNode(m_graph.getData(node), rayOrigin, rayDirection, nearestHitDistance))
+                selectedNode = node;
+            return nearestHitDistance;
+        });
+
+        if (hitDistance != nullptr && selectedNode.isValid())
+            *hitDistance = nearestHitDistance;
 
         return selectedNode;
     }
 
+    constexpr size_t k_rayCastPacketSize = 8;
+
+    // Below this many rays per job, scheduling the job costs more than it saves
+    constexpr size_t k_minRaysPerRayCastJob = 512;
+
+    // nodeMeshes holds the range of meshes of each visible node, by handle index
+    void rayCastQueryPacket(const SceneGraph & graph, const std::vector<const Mesh *> & meshes, const std::vector<std::pair<uint32_t, uint32_t>> & nodeMeshes,
+        const Scene::Ray * rays, size_t numRays, float maxDistance, Scene::RayCastHit * hits, std::vector<int32_t> & candidateProxies)
+    {
+        RayPacket<k_rayCastPacketSize> packet;
+        float nearestHitDistances[k_rayCastPacketSize];
+        SceneGraph::Handle hitNodes[k_rayCastPacketSize];
+
+        // Unused lanes repeat the first ray with a negative max distance, so they never hit
+        for (size_t lane = 0; lane < k_rayCastPacketSize; ++lane)
+        {
+            const Scene::Ray & ray = rays[lane < numRays ? lane : 0];
+            packet.setRay(lane, ray.origin, ray.direction);
+            nearestHitDistances[lane] = lane < numRays ? maxDistance : -1.0f;
+        }
+
+        // Gather the nodes whose bounds any of the rays hit. Each node's meshes are then tested against the whole
+        // packet at once, so unlike the single ray query the rays are not clipped while gathering.
+        candidateProxies.clear();
+        for (size_t lane = 0; lane < numRays; ++lane)
+            graph.getBVH().rayCast(rays[lane].origin, rays[lane].direction, maxDistance, [&](int32_t proxyId, float proxyMaxDistance) -> float {
+                candidateProxies.push_back(proxyId);
+                return proxyMaxDistance;
+            });
+
+        std::sort(candidateProxies.begin(), candidateProxies.end());
+        candidateProxies.erase(std::unique(candidateProxies.begin(), candidateProxies.end()), candidateProxies.end());
+
+        for (int32_t proxyId : candidateProxies)
+        {
+            const SceneGraph::Handle node = graph.getBVHProxyNode(proxyId);
+            const auto [firstMesh, lastMesh] = nodeMeshes[node.index];
+            if (firstMesh == lastMesh)
+                continue;
+
+            const RayPacket<k_rayCastPacketSize> packetMeshSpace = packet.transform(inverseAffine(graph.getData(node).getWorldTransform()));
+
+            for (uint32_t meshIdx = firstMesh; meshIdx < lastMesh; ++meshIdx)
+            {
+                const Mesh * mesh = meshes[meshIdx];
+                const uint32_t hitMask = mesh->rayCast(packetMeshSpace, nearestHitDistances);
+                for (size_t lane = 0; lane < numRays; ++lane)
+                    if ((hitMask & (1u << lane)) != 0)
+                        hitNodes[lane] = node;
+            }
+        }
+
+        for (size_t lane = 0; lane < numRays; ++lane)
+            hits[lane] = { hitNodes[lane], nearestHitDistances[lane] };
+    }
+
+    void Scene::rayCastQuery(const std::vector<Ray> & rays, std::vector<RayCastHit> & hits, float maxDistance)
+    {
+        hits.resize(rays.size());
+        if (rays.empty())
+            return;
+
+        m_graph.updateWorldTransforms();
+
+        // Asset::get loads meshes that are not loaded yet, so the meshes are looked up here on the main thread and the
+        // jobs only see the loaded ones
+        uint32_t numNodeIndices = 0;
+        for (const SceneGraph::Node & node : m_graph.getNodes())
+            numNodeIndices = std::max(numNodeIndices, m_graph.getHandle(node).index + 1);
+
+        m_rayCastMeshes.clear();
+        m_rayCastNodeMeshes.assign(numNodeIndices, { 0, 0 });
+        for (const SceneGraph::Node & node : m_graph.getNodes())
+        {
+            if (node.data.isHidden)
+                continue;
+
+            const uint32_t firstMesh = static_cast<uint32_t>(m_rayCastMeshes.size());
+            for (auto & materialMeshPair : node.data.materialMeshPairs)
+                if (const Mesh * mesh = materialMeshPair.second->get())
+                    m_rayCastMeshes.push_back(mesh);
+
+            m_rayCastNodeMeshes[m_graph.getHandle(node).index] = { firstMesh, static_cast<uint32_t>(m_rayCastMeshes.size()) };
+        }
+
+        // From here on the graph, the meshes and their hierarchies are only read, so jobs can share them
+        const SceneGraph & graph = m_graph;
+
+        const size_t numPackets = (rays.size() + k_rayCastPacketSize - 1) / k_rayCastPacketSize;
+
+        job_system::parallelFor(numPackets, k_minRaysPerRayCastJob / k_rayCastPacketSize, [&](size_t firstPacket, size_t lastPacket) {
+            std::vector<int32_t> candidateProxies;
+
+            for (size_t packetIdx = firstPacket; packetIdx < lastPacket; ++packetIdx)
+            {
+                const size_t firstRay = packetIdx * k_rayCastPacketSize;
+                const size_t numRays = std::min(k_rayCastPacketSize, rays.size() - firstRay);
+                rayCastQueryPacket(graph, m_rayCastMeshes, m_rayCastNodeMeshes, rays.data() + firstRay, numRays, maxDistance, hits.data() + firstRay, candidateProxies);
+            }
+        });
+    }
+
+    void Scene::queryAABB(const AABB & aabb, std::vector<SceneGraph::Handle> & nodes)
+    {
+        m_graph.updateWorldTransforms();
+
+        m_graph.getBVH().queryAABB(aabb, [&](int32_t proxyId) {
+            const SceneGraph::Handle node = m_graph.getBVHProxyNode(proxyId);
+            const AABB & nodeBounds = m_graph.getData(node).getWorldBounds();
+
+            if (nodeBounds.min.x <= aabb.max.x && aabb.min.x <= nodeBounds.max.x &&
+                nodeBounds.min.y <= aabb.max.y && aabb.min.y <= nodeBounds.max.y &&
+                nodeBounds.min.z <= aabb.max.z && aabb.min.z <= nodeBounds.max.z)
+                nodes.push_back(node);
+            return true;
+        });
+    }
+
+    void Scene::querySphere(const Vector3 & center, float radius, std::vector<SceneGraph::Handle> & nodes)
+    {
+        m_graph.updateWorldTransforms();
+
+        m_graph.getBVH().querySphere(center, radius, [&](int32_t proxyId) {
+            const SceneGraph::Handle node = m_graph.getBVHProxyNode(proxyId);
+            const AABB & nodeBounds = m_graph.getData(node).getWorldBounds();
+
+            const Vector3 closestPoint(
+                std::clamp(center.x, nodeBounds.min.x, nodeBounds.max.x),
+                std::clamp(center.y, nodeBounds.min.y, nodeBounds.max.y),
+                std::clamp(center.z, nodeBounds.min.z, nodeBounds.max.z));
+
+            if ((closestPoint - center).dot(closestPoint - center) <= radius * radius)
+                nodes.push_back(node);
+            return true;
+        });
+    }
+
+    void Scene::setLodSettings(const LodSettings & settings)
+    {
+        m_lodSettings = settings;
+    }
+
+    const Scene::LodSettings & Scene::getLodSettings() const
+    {
+        return m_lodSettings;
+    }
+
+    const Scene::CullingStatistics & Scene::getCullingStatistics() const
+    {
+        return m_cullingStatistics;
+    }
+
+    // Render proxies of linear layers are culled in fixed-size runs, each by one job into its own render list
+    constexpr size_t k_renderProxiesPerCullingTask = 512;
+
     void Scene::render(ForwardRenderer & renderer, const Camera & camera)
     {
-        for (const auto & node : m_graph.getRootNodes())
-            renderSceneGraphNode(*node, renderer);
+        updateEntities();
+
+        const Frustum frustum(camera.getProjectionMatrix() * camera.getViewMatrix());
+        const ScreenSizeTest screenSizeTest = makeScreenSizeTest(camera, m_lodSettings);
+
+        m_renderList.clear();
+
+        // Lights outside the frustum can still reach visible geometry, so all of them are submitted
+        m_world.forEach<PointLightComponent, VisibilityComponent>([&](ecs::Entity, const PointLightComponent & pointLight, const VisibilityComponent & visibility) {
+            if (!visibility.isHidden)
+                m_renderList.pointLights.push_back(pointLight.light);
+        });
+
+        // Linear layers are split into fixed-size runs of proxies, octree layers are queried whole
+        m_cullingTasks.clear();
+        for (uint32_t layer = 0; layer < RenderWorld::k_numLayers; ++layer)
+        {
+            const size_t numProxies = m_renderWorld.getProxies(layer).size();
+            if (numProxies == 0)
+                continue;
+
+            if (m_renderWorld.getLayerIndex(layer) == RenderLayerIndex::LooseOctree)
+            {
+                m_cullingTasks.push_back({ layer, 0, numProxies });
+                continue;
+            }
+
+            for (size_t first = 0; first < numProxies; first += k_renderProxiesPerCullingTask)
+                m_cullingTasks.push_back({ layer, first, std::min(first + k_renderProxiesPerCullingTask, numProxies) });
+        }
+
+        // Jobs only read the render proxies and each fills its own render list, so they need no synchronisation
+        if (m_taskRenderLists.size() < m_cullingTasks.size())
+            m_taskRenderLists.resize(m_cullingTasks.size());
+
+        job_system::parallelFor(m_cullingTasks.size(), 1, [&](size_t first, size_t last) {
+            for (size_t idx = first; idx < last; ++idx)
+            {
+                const CullingTask & task = m_cullingTasks[idx];
+                m_taskRenderLists[idx].clear();
+
+                if (m_renderWorld.getLayerIndex(task.layer) == RenderLayerIndex::LooseOctree)
+                    cullRenderProxies(m_renderWorld, task.layer, frustum, screenSizeTest, m_taskRenderLists[idx]);
+                else
+                    cullRenderProxies(m_renderWorld.getProxies(task.layer), task.first, task.last, frustum, screenSizeTest, m_taskRenderLists[idx]);
+            }
+        });
+
+        // Merging in task order keeps the command order the same from frame to frame, whichever thread ran what
+        for (size_t idx = 0; idx < m_cullingTasks.size(); ++idx)
+            m_renderList.append(m_taskRenderLists[idx]);
+
+        cullStaticBatches(frustum);
+
+        m_cullingStatistics = m_renderList.statistics;
+
+        // Culling runs before draw() records this frame, while the GPU may still be working on the previous one
+        if (m_isOcclusionCullingEnabled)
+            cullOccludedMeshes(camera);
+
+        mergeAdjacentRanges();
+
+        renderer.submit(m_renderList.commands.data(), m_renderList.commands.size());
+        renderer.submit(m_renderList.pointLights.data(), m_renderList.pointLights.size());
 
         renderer.draw(camera);
     }
+
+    void Scene::cullStaticBatches(const Frustum & frustum)
+    {
+        CullingStatistics & statistics = m_renderList.statistics;
+
+        for (const StaticBatch & batch : m_graph.getStaticBatches())
+        {
+            const Material * material = batch.material->get();
+
+            for (const StaticBatch::Piece & piece : batch.pieces)
+            {
+                // Left empty by a node taken out of the batch, which now draws its own meshes
+                if (piece.numIndices == 0)
+                    continue;
+
+                ++statistics.numFrustumTests;
+                if (intersection_test::frustumAABB(frustum, piece.worldBounds) == FrustumTestResult::Outside)
+                {
+                    ++statistics.numCulled;
+                    continue;
+                }
+
+                // Batch vertices are already in world space
+                m_renderList.commands.push_back(RenderCommand{ batch.mesh.get(), Matrix4::identity, material, piece.firstIndex, piece.numIndices });
+                m_renderList.commandWorldBounds.push_back(&piece.worldBounds);
+                ++statistics.numVisible;
+            }
+        }
+    }
+
+    void Scene::mergeAdjacentRanges()
+    {
+        std::vector<RenderCommand> & commands = m_renderList.commands;
+
+        size_t numKept = 0;
+        for (size_t idx = 0; idx < commands.size(); ++idx)
+        {
+            const RenderCommand & command = commands[idx];
+
+            if (numKept > 0)
+            {
+                RenderCommand & previous = commands[numKept - 1];
+                if (command.numIndices != 0 && previous.numIndices != 0 && previous.firstIndex + previous.numIndices == command.firstIndex &&
+                    command.mesh == previous.mesh && command.material == previous.material && command.transform == previous.transform)
+                {
+                    previous.numIndices += command.numIndices;
+                    continue;
+                }
+            }
+
+            commands[numKept] = command;
+            m_renderList.commandWorldBounds[numKept] = m_renderList.commandWorldBounds[idx];
+            ++numKept;
+        }
+
+        commands.resize(numKept);
+        m_renderList.commandWorldBounds.resize(numKept);
+    }
+
+    void Scene::setOcclusionCullingEnabled(bool isEnabled)
+    {
+        m_isOcclusionCullingEnabled = isEnabled;
+    }
+
+    bool Scene::getOcclusionCullingEnabled() const
+    {
+        return m_isOcclusionCullingEnabled;
+    }
+
+    // Occluders are the visible meshes that cover the most of the view, judged by bounding radius over distance. They
+    // are drawn with their own triangles, so only meshes cheap enough to rasterise on the CPU qualify.
+    constexpr size_t k_maxOccluders = 16;
+    constexpr float k_minOccluderSize = 0.2f;
+    constexpr size_t k_maxOccluderTriangles = 2048;
+
+    constexpr size_t k_minMeshesPerOcclusionTestThread = 256;
+
+    void Scene::cullOccludedMeshes(const Camera & camera)
+    {
+        std::vector<std::pair<float, size_t>> occluderCandidates;
+
+        for (size_t idx = 0; idx < m_renderList.commands.size(); ++idx)
+        {
+            // The occlusion buffer draws whole meshes, so parts of static batches are left out
+            if (m_renderList.commands[idx].numIndices != 0)
+                continue;
+
+            const Mesh * mesh = m_renderList.commands[idx].mesh;
+            const size_t numTriangles = (mesh->getIndices().empty() ? mesh->getVertices().size() : mesh->getIndices().size()) / 3;
+            if (numTriangles > k_maxOccluderTriangles)
+                continue;
+
+            const AABB & bounds = *m_renderList.commandWorldBounds[idx];
+            const float radius = bounds.getExtents().magnitude();
+            const float distance = std::max((bounds.getCenter() - camera.getPosition()).magnitude(), camera.getZNear());
+            const float size = radius / distance;
+
+            if (size >= k_minOccluderSize)
+                occluderCandidates.push_back({ size, idx });
+        }
+
+        const size_t numOccluders = std::min(occluderCandidates.size(), k_maxOccluders);
+        std::partial_sort(occluderCandidates.begin(), occluderCandidates.begin() + numOccluders, occluderCandidates.end(), [](const auto & lhs, const auto & rhs) {
+            return lhs.first > rhs.first;
+        });
+
+        m_occluders.clear();
+        m_isMeshOccluder.assign(m_renderList.commands.size(), 0);
+        for (size_t idx = 0; idx < numOccluders; ++idx)
+        {
+            const RenderCommand & occluder = m_renderList.commands[occluderCandidates[idx].second];
+            m_occluders.push_back({ occluder.mesh, occluder.transform });
+            m_isMeshOccluder[occluderCandidates[idx].second] = 1;
+        }
+
+        m_cullingStatistics.numOccluders = m_occluders.size();
+        if (m_occluders.empty())
+            return;
+
+        m_occlusionBuffer.render(camera.getProjectionMatrix() * camera.getViewMatrix(), m_occluders);
+
+        // Occluders are kept without testing, they would only be hidden by other occluders
+        m_isMeshOccluded.assign(m_renderList.commands.size(), 0);
+        job_system::parallelFor(m_renderList.commands.size(), k_minMeshesPerOcclusionTestThread, [&](size_t first, size_t last) {
+            for (size_t idx = first; idx < last; ++idx)
+                m_isMeshOccluded[idx] = !m_isMeshOccluder[idx] && m_occlusionBuffer.isOccluded(*m_renderList.commandWorldBounds[idx]);
+        });
+
+        size_t numKept = 0;
+        for (size_t idx = 0; idx < m_renderList.commands.size(); ++idx)
+            if (!m_isMeshOccluded[idx])
+            {
+                m_renderList.commands[numKept] = m_renderList.commands[idx];
+                m_renderList.commandWorldBounds[numKept] = m_renderList.commandWorldBounds[idx];
+                ++numKept;
+            }
+
+        m_cullingStatistics.numOccluded = m_renderList.commands.size() - numKept;
+        m_cullingStatistics.numVisible -= m_cullingStatistics.numOccluded;
+        m_renderList.commands.resize(numKept);
+        m_renderList.commandWorldBounds.resize(numKept);
+    }
 }
\ No newline at end of file
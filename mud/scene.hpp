@@ -1,28 +1,193 @@
 #ifndef SCENE_HPP
 #define SCENE_HPP
 
+#include <limits>
+#include <vector>
+
+#include "ecs/world.hpp"
 #include "graphics/forward_renderer.hpp"
+#include "graphics/occlusion_buffer.hpp"
+#include "graphics/render_world.hpp"
 #include "graphics/scene_graph.hpp"
+#include "math/frustum.hpp"
+#include "scene_components.hpp"
 
 namespace mud
 {
+    // The graph is where nodes are edited and what is saved. Its visible meshes are extracted into render proxies
+    // that culling and the renderer work from, each owned by an entity, and its lights are copied into entities.
+    // Both are brought up to date with the nodes that changed at the start of every render call.
     class Scene
     {
     public:
 
+        struct CullingStatistics
+        {
+            size_t numVisible = 0;
+            size_t numCulled = 0;
+            size_t numFrustumTests = 0;
+            size_t numOccluded = 0;
+            size_t numOccluders = 0;
+
+            // Of the culled meshes, those smaller on screen than the minimum pixel size
+            size_t numTooSmall = 0;
+        };
+
+        // Screen size thresholds, in pixels across the node's bounding sphere, that pick a node's level of detail and
+        // cull nodes too small to matter. Nodes can override both, see SceneGraphNodeData.
+        struct LodSettings
+        {
+            // Height of the render target the sizes are measured on
+            float screenHeight = 1080.0f;
+
+            // Nodes smaller than this are culled, 0 culls nothing
+            float minPixelSize = 0.0f;
+
+            // Decreasing sizes below which level i + 1 is drawn. Nodes with fewer levels draw their coarsest one.
+            std::vector<float> lodPixelSizes;
+        };
+
+        // What culling part of the scene produced: the render commands of the meshes that passed frustum culling,
+        // waiting on the occlusion stage before they are submitted, and the lights to submit
+        struct RenderList
+        {
+            std::vector<RenderCommand> commands;
+
+            // World bounds of the mesh of the command at the same index
+            std::vector<const AABB *> commandWorldBounds;
+
+            std::vector<PointLight> pointLights;
+            CullingStatistics statistics;
+
+            void clear();
+
+            // Appends other's commands, lights and statistics
+            void append(const RenderList & other);
+        };
+
+        struct Ray
+        {
+            Vector3 origin;
+            Vector3 direction;
+        };
+
+        struct RayCastHit
+        {
+            // Invalid when the ray hit nothing
+            SceneGraph::Handle node;
+            float distance = 0;
+        };
+
         Scene();
 
         const SceneGraph & getGraph() const;
 
         SceneGraph & getGraph();
 
-        SceneGraph::Node * rayCastQuery(const Vector2 & normalisedDeviceCoordinates, Camera & camera);
+        // The entities of the graph's meshes and lights, as of the last render call
+        const ecs::World & getWorld() const;
+
+        // The render proxies of the graph's visible meshes, as of the last render call. Static batches are drawn from
+        // the graph's batches instead.
+        const RenderWorld & getRenderWorld() const;
+
+        // Chooses how render culling finds the meshes of nodes on the layer, see RenderWorld::setLayerIndex. Layers
+        // start as loose octrees, so culling skips empty regions of the scene. Layers whose meshes are mostly in view,
+        // or that span more than the default octree bounds, can be scanned linearly instead.
+        void setLayerIndex(uint32_t layer, RenderLayerIndex index, const AABB & octreeBounds = AABB(Vector3(-1024.0f), Vector3(1024.0f)), uint32_t octreeMaxDepth = 8);
+
+        SceneGraph::Handle rayCastQuery(const Vector2 & normalisedDeviceCoordinates, Camera & camera);
+
+        // Returns the node owning the nearest mesh triangle hit by the ray, or an invalid handle
+        SceneGraph::Handle rayCastQuery(const Vector3 & rayOrigin, const Vector3 & rayDirection, float maxDistance = std::numeric_limits<float>::max(), float * hitDistance = nullptr);
+
+        // Casts many rays at once, for line of sight and placement queries. Rays are tested against each mesh in
+        // packets of 8, and the packets are split into job system jobs when there are enough of them. hits is
+        // resized to match rays.
+        void rayCastQuery(const std::vector<Ray> & rays, std::vector<RayCastHit> & hits, float maxDistance = std::numeric_limits<float>::max());
+
+        // Appends the nodes whose world bounds overlap the box
+        void queryAABB(const AABB & aabb, std::vector<SceneGraph::Handle> & nodes);
+
+        // Appends the nodes whose world bounds overlap the sphere
+        void querySphere(const Vector3 & center, float radius, std::vector<SceneGraph::Handle> & nodes);
 
         void render(ForwardRenderer & renderer, const Camera & camera);
 
+        // When enabled, render draws the largest nearby visible meshes into a software depth buffer and skips meshes
+        // hidden behind them. Off by default.
+        void setOcclusionCullingEnabled(bool isEnabled);
+
+        bool getOcclusionCullingEnabled() const;
+
+        void setLodSettings(const LodSettings & settings);
+
+        const LodSettings & getLodSettings() const;
+
+        // Mesh counts of the last render call
+        const CullingStatistics & getCullingStatistics() const;
+
     private:
 
+        // Proxies of one culling job: a run of a linear layer, or a whole octree layer
+        struct CullingTask
+        {
+            uint32_t layer;
+            size_t first;
+            size_t last;
+        };
+
+        // The entities created for a node, found by the index of the node's handle
+        struct NodeEntities
+        {
+            uint32_t generation = 0;
+            std::vector<ecs::Entity> meshes;
+            std::vector<ecs::Entity> lights;
+        };
+
+        // Recreates, updates or destroys the entities of the nodes the graph changed since the last call
+        void updateEntities();
+
+        void updateNodeEntities(SceneGraph::Handle node);
+
+        void destroyNodeEntities(uint32_t nodeIndex);
+
+        void destroyMeshEntity(ecs::Entity entity);
+
+        // Culls the pieces of the graph's static batches into m_renderList, one command per visible piece
+        void cullStaticBatches(const Frustum & frustum);
+
+        void cullOccludedMeshes(const Camera & camera);
+
+        // Joins runs of commands drawing consecutive index ranges of the same mesh, as the visible pieces of a static
+        // batch mostly are, into single commands. Joined commands keep the world bounds of their first range.
+        void mergeAdjacentRanges();
+
         SceneGraph m_graph;
+        ecs::World m_world;
+        RenderWorld m_renderWorld;
+        std::vector<NodeEntities> m_nodeEntities;
+        std::vector<SceneGraph::Handle> m_updatedNodes;
+        std::vector<SceneGraph::Handle> m_deletedNodes;
+
+        LodSettings m_lodSettings;
+        CullingStatistics m_cullingStatistics;
+        std::vector<CullingTask> m_cullingTasks;
+
+        // One per culling job, kept between frames so their buffers are reused
+        std::vector<RenderList> m_taskRenderLists;
+
+        // Every visible mesh and light of the frame, in render proxy order
+        RenderList m_renderList;
+        bool m_isOcclusionCullingEnabled;
+        OcclusionBuffer m_occlusionBuffer;
+        std::vector<OcclusionBuffer::Occluder> m_occluders;
+        std::vector<uint8_t> m_isMeshOccluder;
+        std::vector<uint8_t> m_isMeshOccluded;
+
+        // The loaded meshes of every visible node for batched ray casts, and each node's range of them by handle index
+        std::vector<const Mesh *> m_rayCastMeshes;
+        std::vector<std::pair<uint32_t, uint32_t>> m_rayCastNodeMeshes;
     };
 }
 
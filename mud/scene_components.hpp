@@ -0,0 +1,32 @@
+#ifndef SCENE_COMPONENTS_HPP
+#define SCENE_COMPONENTS_HPP
+
+#include <cstdint>
+
+#include "graphics/lights.hpp"
+
+// Components of the entities a Scene keeps for its graph. Each mesh of a node gets an entity that owns the mesh's
+// render proxy, culling itself runs over the render world. Each light gets an entity holding a copy of the light, so
+// that render gathers the scene's lights from packed arrays instead of walking the graph.
+namespace mud
+{
+    // The entity's drawable in the scene's render world, which holds its resolved mesh and material and its world
+    // bounds. Hidden entities and those whose assets failed to load have none.
+    struct MeshRendererComponent
+    {
+        int32_t proxy;
+    };
+
+    // Lights are not transformed by their node, their position is in world space
+    struct PointLightComponent
+    {
+        PointLight light;
+    };
+
+    struct VisibilityComponent
+    {
+        bool isHidden;
+    };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,175 @@
+// Job system tests: parallelFor coverage, dependency ordering, nested waits and main thread jobs, each run inline
+// before init and then with worker threads. Returns non-zero if any check fails.
+//
+// usage: mud_job_system_test [--workers <n>]
+
+#include <atomic>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/job_system.hpp"
+#include "utils/logger.hpp"
+
+namespace mud::job_system_test
+{
+	size_t g_numFailed = 0;
+
+	void check(bool condition, const std::string & description)
+	{
+		if (condition)
+			return;
+
+		log(LogLevel::Error, fmt::format("Failed: {0}\n", description), "Test");
+		++g_numFailed;
+	}
+
+	// Every index is visited exactly once, by ranges that stay inside [0, count)
+	void testParallelForCoverage()
+	{
+		for (size_t count : { 0, 1, 7, 1000, 100003 })
+			for (size_t minRangeSize : { 1, 16, 5000 })
+			{
+				std::vector<std::atomic<uint32_t>> visits(count);
+				std::atomic<bool> isRangeValid{ true };
+
+				job_system::parallelFor(count, minRangeSize, [&](size_t first, size_t last) {
+					if (first >= last || last > count)
+						isRangeValid = false;
+
+					for (size_t idx = first; idx < last; ++idx)
+						++visits[idx];
+				});
+
+				bool isEachVisitedOnce = true;
+				for (const std::atomic<uint32_t> & visit : visits)
+					isEachVisitedOnce &= visit == 1;
+
+				check(isRangeValid && isEachVisitedOnce, fmt::format("parallelFor covers {0} items once with ranges of at least {1}", count, minRangeSize));
+			}
+	}
+
+	// Jobs held back by a dependency start only after every job of the counter they depend on has finished
+	void testDependencyOrdering()
+	{
+		constexpr size_t k_numJobs = 64;
+
+		for (size_t round = 0; round < 50; ++round)
+		{
+			job_system::Counter firstStage;
+			job_system::Counter secondStage;
+			std::atomic<size_t> numFirstStageDone{ 0 };
+			std::atomic<size_t> numEarlyStarts{ 0 };
+
+			for (size_t idx = 0; idx < k_numJobs; ++idx)
+				job_system::run([&]() {
+					std::this_thread::yield();
+					++numFirstStageDone;
+				}, &firstStage);
+
+			for (size_t idx = 0; idx < k_numJobs; ++idx)
+				job_system::run([&]() {
+					if (numFirstStageDone != k_numJobs)
+						++numEarlyStarts;
+				}, &secondStage, &firstStage);
+
+			job_system::wait(secondStage);
+
+			check(firstStage.isDone() && secondStage.isDone(), "both stages are done after waiting on the second");
+			check(numEarlyStarts == 0, fmt::format("no dependent job starts before its dependency is done, round {0}", round));
+		}
+	}
+
+	// Jobs that wait on jobs of their own keep running queued work instead of blocking the threads they occupy
+	void testNestedWaits()
+	{
+		constexpr size_t k_numOuter = 32;
+		constexpr size_t k_numInner = 256;
+
+		std::vector<size_t> sums(k_numOuter, 0);
+
+		job_system::parallelFor(k_numOuter, 1, [&](size_t first, size_t last) {
+			for (size_t outerIdx = first; outerIdx < last; ++outerIdx)
+			{
+				std::atomic<size_t> sum{ 0 };
+				job_system::parallelFor(k_numInner, 1, [&](size_t innerFirst, size_t innerLast) {
+					for (size_t idx = innerFirst; idx < innerLast; ++idx)
+						sum += idx;
+				});
+
+				sums[outerIdx] = sum;
+			}
+		});
+
+		bool isEachSumRight = true;
+		for (size_t sum : sums)
+			isEachSumRight &= sum == k_numInner * (k_numInner - 1) / 2;
+
+		check(isEachSumRight, "nested parallelFor calls complete with every inner item visited");
+	}
+
+	// Main thread jobs queued from any thread only run on the main thread, when it waits or processes them
+	void testMainThreadJobs()
+	{
+		constexpr size_t k_numJobs = 16;
+
+		job_system::Counter counter;
+		std::atomic<size_t> numRun{ 0 };
+		std::atomic<size_t> numOffMainThread{ 0 };
+
+		for (size_t idx = 0; idx < k_numJobs; ++idx)
+			job_system::run([&]() {
+				job_system::runOnMainThread([&]() {
+					if (!job_system::isMainThread())
+						++numOffMainThread;
+					++numRun;
+				}, &counter);
+			}, &counter);
+
+		job_system::wait(counter);
+
+		check(numRun == k_numJobs, "every main thread job runs before the wait returns");
+		check(numOffMainThread == 0, "main thread jobs only run on the main thread");
+
+		job_system::runOnMainThread([&]() { ++numRun; });
+		job_system::processMainThreadJobs();
+
+		check(numRun == k_numJobs + 1, "processMainThreadJobs runs queued main thread jobs");
+	}
+
+	void runAll()
+	{
+		testParallelForCoverage();
+		testDependencyOrdering();
+		testNestedWaits();
+		testMainThreadJobs();
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	using namespace mud;
+
+	unsigned int numWorkers = std::max(std::thread::hardware_concurrency(), 4u) - 1;
+	if (argc == 3 && std::string(argv[1]) == "--workers")
+		numWorkers = static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10));
+
+	// Before init every job runs inline on the thread queuing it
+	job_system_test::runAll();
+
+	// Workers are started even on a single core, so that the threaded paths are exercised
+	job_system::init(std::max(numWorkers, 1u));
+	job_system_test::runAll();
+	job_system::destroy();
+
+	if (job_system_test::g_numFailed != 0)
+	{
+		log(LogLevel::Error, fmt::format("{0} job system checks failed\n", job_system_test::g_numFailed), "Test");
+		return EXIT_FAILURE;
+	}
+
+	log(LogLevel::Info, "All job system checks passed\n", "Test");
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
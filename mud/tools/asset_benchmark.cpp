@@ -0,0 +1,486 @@
+// Asset pipeline benchmark: generates synthetic meshes, textures and scene graphs and measures import,
+// save, load and deserialization throughput. Results are written as a JSON array, one object per benchmark.
+//
+// Runs headless: no graphics context is created, so Mesh/Texture::onSetData keep CPU side data only.
+//
+// Everything is written to the benchmark directory, which must be new, empty or left by a previous run. Each run only
+// clears what the previous one generated there.
+//
+// usage: mud_asset_benchmark [--directory <dir>] [--output <file>] [--iterations <n>] [--meshes <n>]
+//                            [--vertices <n>] [--textures <n>] [--texture-size <n>] [--nodes <n>]
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "graphics/material.hpp"
+#include "graphics/mesh.hpp"
+#include "graphics/scene_graph.hpp"
+#include "graphics/texture.hpp"
+#include "math/matrix/transformations.hpp"
+#include "utils/asset_importer.hpp"
+#include "utils/asset_manager.hpp"
+#include "utils/logger.hpp"
+#include "utils/stopwatch.hpp"
+
+namespace
+{
+	std::atomic<uint64_t> g_numAllocations{ 0 };
+	std::atomic<uint64_t> g_allocatedBytes{ 0 };
+}
+
+void * operator new(std::size_t size)
+{
+	++g_numAllocations;
+	g_allocatedBytes += size;
+
+	if (void * p = std::malloc(size == 0 ? 1 : size))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void * p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace mud::asset_benchmark
+{
+	// Written to the benchmark directory when the benchmark creates it. Directories without it are never cleared.
+	const std::string k_markerFilename = ".mud_asset_benchmark";
+
+	struct Options
+	{
+		// Created by the benchmark. An existing directory is only reused if it is empty or a previous run created it.
+		std::string directory = "asset_benchmark";
+		std::string outputFilepath;
+		size_t iterations = 3;
+		size_t numMeshes = 64;
+		size_t numVerticesPerMesh = 4096;
+		size_t numTextures = 16;
+		size_t textureSize = 512;
+		size_t numSceneGraphNodes = 2000;
+	};
+
+	struct Result
+	{
+		std::string name;
+		size_t iterations = 0;
+		size_t numItems = 0;
+		uint64_t numBytes = 0;
+		double seconds = 0.0;
+		uint64_t numAllocations = 0;
+		uint64_t allocatedBytes = 0;
+	};
+
+	// Times func() over options.iterations runs, func returns the number of bytes processed per run
+	template <typename TFunc>
+	Result run(const std::string & name, const Options & options, size_t numItemsPerIteration, TFunc func)
+	{
+		Result result;
+		result.name = name;
+		result.iterations = options.iterations;
+		result.numItems = numItemsPerIteration * options.iterations;
+
+		const uint64_t numAllocationsBefore = g_numAllocations;
+		const uint64_t allocatedBytesBefore = g_allocatedBytes;
+
+		Stopwatch stopwatch;
+		stopwatch.start();
+
+		for (size_t idx = 0; idx < options.iterations; ++idx)
+			result.numBytes += func();
+
+		result.seconds = stopwatch.stop() / 1000.0;
+		result.numAllocations = g_numAllocations - numAllocationsBefore;
+		result.allocatedBytes = g_allocatedBytes - allocatedBytesBefore;
+
+		log(LogLevel::Info, fmt::format("{0}: {1:.3f}s\n", name, result.seconds), "Benchmark");
+
+		return result;
+	}
+
+	std::string toJson(const Result & result)
+	{
+		const double seconds = result.seconds > 0.0 ? result.seconds : 1e-9;
+
+		return fmt::format(
+			"{{\"benchmark\":\"{0}\",\"iterations\":{1},\"items\":{2},\"bytes\":{3},\"seconds\":{4:.6f},\"mb_per_s\":{5:.3f},\"items_per_s\":{6:.3f},\"allocations\":{7},\"allocated_bytes\":{8}}}",
+			result.name, result.iterations, result.numItems, result.numBytes, result.seconds,
+			(result.numBytes / (1024.0 * 1024.0)) / seconds, result.numItems / seconds,
+			result.numAllocations, result.allocatedBytes);
+	}
+
+	uint64_t fileSize(const std::string & filepath)
+	{
+		std::error_code errorCode;
+		const uintmax_t size = std::filesystem::file_size(filepath, errorCode);
+		return errorCode ? 0 : static_cast<uint64_t>(size);
+	}
+
+	// Uncompressed 32-bit TGA with a checker pattern
+	void writeTexture(const std::string & filepath, size_t size)
+	{
+		std::ofstream file(filepath, std::ios::binary);
+
+		uint8_t header[18] = {};
+		header[2] = 2;
+		header[12] = static_cast<uint8_t>(size & 0xFF);
+		header[13] = static_cast<uint8_t>((size >> 8) & 0xFF);
+		header[14] = static_cast<uint8_t>(size & 0xFF);
+		header[15] = static_cast<uint8_t>((size >> 8) & 0xFF);
+		header[16] = 32;
+		header[17] = 8;
+		file.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+		std::vector<uint8_t> pixels(size * size * 4);
+		for (size_t y = 0; y < size; ++y)
+			for (size_t x = 0; x < size; ++x)
+			{
+				uint8_t * pixel = &pixels[(y * size + x) * 4];
+				const uint8_t value = ((x / 16 + y / 16) % 2) ? 255 : 32;
+				pixel[0] = value;
+				pixel[1] = static_cast<uint8_t>(x);
+				pixel[2] = static_cast<uint8_t>(y);
+				pixel[3] = 255;
+			}
+
+		file.write(reinterpret_cast<const char *>(pixels.data()), pixels.size());
+	}
+
+	// Square grid with roughly numVertices vertices in the XZ plane
+	void generateGrid(size_t numVertices, std::vector<MeshVertex> & vertices, std::vector<uint32_t> & indices)
+	{
+		const size_t side = std::max<size_t>(2, static_cast<size_t>(std::sqrt(static_cast<double>(numVertices))));
+
+		vertices.resize(side * side);
+		for (size_t z = 0; z < side; ++z)
+			for (size_t x = 0; x < side; ++x)
+			{
+				MeshVertex & vertex = vertices[z * side + x];
+				vertex.position = Vector3(static_cast<float>(x), std::sin(x * 0.1f) * std::cos(z * 0.1f), static_cast<float>(z));
+				vertex.normal = Vector3(0.0f, 1.0f, 0.0f);
+				vertex.colour = Vector4(1.0f);
+				vertex.textureCoordinates = Vector2(static_cast<float>(x) / side, static_cast<float>(z) / side);
+			}
+
+		indices.clear();
+		for (size_t z = 0; z + 1 < side; ++z)
+			for (size_t x = 0; x + 1 < side; ++x)
+			{
+				const uint32_t i = static_cast<uint32_t>(z * side + x);
+				indices.insert(indices.end(), { i, i + static_cast<uint32_t>(side), i + 1, i + 1, i + static_cast<uint32_t>(side), i + static_cast<uint32_t>(side) + 1 });
+			}
+	}
+
+	// OBJ scene with one object per mesh, all sharing a material that references the first texture
+	void writeScene(const std::string & filepath, const std::string & textureFilename, const Options & options)
+	{
+		const std::string materialFilepath = filepath + ".mtl";
+
+		std::ofstream materialFile(materialFilepath);
+		materialFile << "newmtl benchmark\nKd 1 1 1\nmap_Kd " << textureFilename << "\n";
+
+		std::ofstream file(filepath);
+		file << "mtllib " << std::filesystem::path(materialFilepath).filename().string() << "\n";
+
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		size_t vertexOffset = 1;
+
+		for (size_t meshIdx = 0; meshIdx < options.numMeshes; ++meshIdx)
+		{
+			generateGrid(options.numVerticesPerMesh, vertices, indices);
+
+			file << "o mesh_" << meshIdx << "\nusemtl benchmark\n";
+
+			for (const MeshVertex & vertex : vertices)
+				file << "v " << vertex.position.x + meshIdx * 4.0f << ' ' << vertex.position.y << ' ' << vertex.position.z << '\n';
+			for (const MeshVertex & vertex : vertices)
+				file << "vt " << vertex.textureCoordinates.x << ' ' << vertex.textureCoordinates.y << '\n';
+
+			for (size_t idx = 0; idx < indices.size(); idx += 3)
+				file << "f "
+					<< indices[idx + 0] + vertexOffset << '/' << indices[idx + 0] + vertexOffset << ' '
+					<< indices[idx + 1] + vertexOffset << '/' << indices[idx + 1] + vertexOffset << ' '
+					<< indices[idx + 2] + vertexOffset << '/' << indices[idx + 2] + vertexOffset << '\n';
+
+			vertexOffset += vertices.size();
+		}
+	}
+
+	// Skips the asset file header and meta data so the stream is positioned at the asset object
+	bool skipAssetMetaData(std::ifstream & file)
+	{
+		AssetFileHeader header;
+		UUID uuid;
+		std::string importFilepath;
+
+		return serialization_helpers::deserialize(file, header) && uuid.deserialize(file) && serialization_helpers::deserialize(file, importFilepath);
+	}
+
+	// Makes the benchmark directory the working directory, so AssetManager::assetDirectory resolves there, and removes
+	// what a previous run generated in it. Refuses directories the benchmark did not create, which are left untouched.
+	bool enterBenchmarkDirectory(const std::string & directory)
+	{
+		const std::filesystem::path directoryPath(directory);
+
+		std::error_code errorCode;
+		if (std::filesystem::exists(directoryPath, errorCode))
+		{
+			if (!std::filesystem::is_directory(directoryPath, errorCode))
+			{
+				log(LogLevel::Error, fmt::format("Failed to use benchmark directory '{0}': Path is not a directory\n", directory), "Benchmark");
+				return false;
+			}
+
+			if (!std::filesystem::is_empty(directoryPath, errorCode) && !std::filesystem::exists(directoryPath / k_markerFilename, errorCode))
+			{
+				log(LogLevel::Error, fmt::format("Failed to use benchmark directory '{0}': Directory is not empty and was not created by the benchmark\n", directory), "Benchmark");
+				return false;
+			}
+		}
+
+		std::filesystem::create_directories(directoryPath, errorCode);
+		std::ofstream(directoryPath / k_markerFilename);
+		std::filesystem::current_path(directoryPath, errorCode);
+		if (errorCode)
+		{
+			log(LogLevel::Error, fmt::format("Failed to use benchmark directory '{0}': {1}\n", directory, errorCode.message()), "Benchmark");
+			return false;
+		}
+
+		// Only the paths the benchmark writes to
+		std::filesystem::remove_all("source", errorCode);
+		std::filesystem::remove_all(AssetManager::assetDirectory, errorCode);
+		std::filesystem::create_directories("source", errorCode);
+
+		return !errorCode;
+	}
+
+	bool parseOptions(int argc, char ** argv, Options & options)
+	{
+		for (int idx = 1; idx < argc; ++idx)
+		{
+			const std::string argument = argv[idx];
+
+			if (idx + 1 >= argc)
+			{
+				log(LogLevel::Error, fmt::format("Missing value for option '{0}'\n", argument), "Benchmark");
+				return false;
+			}
+
+			const std::string value = argv[++idx];
+
+			if (argument == "--directory")
+				options.directory = value;
+			else if (argument == "--output")
+				options.outputFilepath = value;
+			else if (argument == "--iterations")
+				options.iterations = std::stoul(value);
+			else if (argument == "--meshes")
+				options.numMeshes = std::stoul(value);
+			else if (argument == "--vertices")
+				options.numVerticesPerMesh = std::stoul(value);
+			else if (argument == "--textures")
+				options.numTextures = std::stoul(value);
+			else if (argument == "--texture-size")
+				options.textureSize = std::stoul(value);
+			else if (argument == "--nodes")
+				options.numSceneGraphNodes = std::stoul(value);
+			else
+			{
+				log(LogLevel::Error, fmt::format("Unknown option '{0}'\n", argument), "Benchmark");
+				return false;
+			}
+		}
+
+		return options.iterations > 0;
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	using namespace mud;
+	using namespace mud::asset_benchmark;
+
+	Options options;
+	try
+	{
+		if (!parseOptions(argc, argv, options))
+			return EXIT_FAILURE;
+	}
+	catch (const std::exception &)
+	{
+		log(LogLevel::Error, "Invalid numeric option value\n", "Benchmark");
+		return EXIT_FAILURE;
+	}
+
+	if (!options.outputFilepath.empty())
+		options.outputFilepath = std::filesystem::absolute(options.outputFilepath).string();
+
+	if (!enterBenchmarkDirectory(options.directory))
+		return EXIT_FAILURE;
+
+	log(LogLevel::Info, "Generating synthetic source assets...\n", "Benchmark");
+
+	std::vector<std::string> textureFilepaths;
+	for (size_t idx = 0; idx < options.numTextures; ++idx)
+	{
+		textureFilepaths.push_back(fmt::format("source/texture_{0}.tga", idx));
+		writeTexture(textureFilepaths.back(), options.textureSize);
+	}
+
+	const std::string sceneFilepath = "source/scene.obj";
+	writeScene(sceneFilepath, textureFilepaths.empty() ? "" : std::filesystem::path(textureFilepaths[0]).filename().string(), options);
+
+	std::vector<Result> results;
+	AssetManager & assetManager = AssetManager::getInstance();
+
+	results.push_back(run("import_texture", options, textureFilepaths.size(), [&]()
+	{
+		uint64_t numBytes = 0;
+		for (size_t idx = 0; idx < textureFilepaths.size(); ++idx)
+		{
+			Asset<Texture> asset;
+			if (asset_importer::import<Texture>(textureFilepaths[idx], &asset, AssetManager::createAssetFilepath(fmt::format("benchmark/textures/texture_{0}", idx))))
+				numBytes += fileSize(textureFilepaths[idx]);
+		}
+		return numBytes;
+	}));
+
+	results.push_back(run("import_scene_graph", options, 1, [&]()
+	{
+		Asset<SceneGraph> asset;
+		return asset_importer::import<SceneGraph>(sceneFilepath, &asset) ? fileSize(sceneFilepath) : 0;
+	}));
+
+	// Mesh and material assets referenced by the synthetic scene graph
+
+	std::vector<Asset<Mesh> *> meshAssets;
+	std::vector<std::string> meshAssetFilepaths;
+	{
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		generateGrid(options.numVerticesPerMesh, vertices, indices);
+
+		for (size_t idx = 0; idx < options.numMeshes; ++idx)
+		{
+			meshAssets.push_back(assetManager.newAsset<Mesh>());
+			meshAssets.back()->allocateObject();
+			meshAssets.back()->get()->setData(vertices, indices);
+			meshAssetFilepaths.push_back(AssetManager::createAssetFilepath(fmt::format("benchmark/meshes/mesh_{0}", idx)));
+		}
+	}
+
+	Asset<Material> * materialAsset = assetManager.newAsset<Material>();
+	materialAsset->allocateObject();
+	materialAsset->get()->baseColor = Vector4(1.0f);
+	materialAsset->save(AssetManager::createAssetFilepath("benchmark/materials/material"));
+
+	results.push_back(run("save_mesh", options, meshAssets.size(), [&]()
+	{
+		uint64_t numBytes = 0;
+		for (size_t idx = 0; idx < meshAssets.size(); ++idx)
+			if (meshAssets[idx]->save(meshAssetFilepaths[idx]))
+				numBytes += fileSize(meshAssetFilepaths[idx]);
+		return numBytes;
+	}));
+
+	for (Asset<Mesh> * meshAsset : meshAssets)
+		meshAsset->unload();
+
+	results.push_back(run("load_mesh", options, meshAssets.size(), [&]()
+	{
+		uint64_t numBytes = 0;
+		for (size_t idx = 0; idx < meshAssets.size(); ++idx)
+		{
+			Asset<Mesh> asset;
+			if (asset.load(meshAssetFilepaths[idx]))
+				numBytes += fileSize(meshAssetFilepaths[idx]);
+		}
+		return numBytes;
+	}));
+
+	// Random tree of numSceneGraphNodes nodes, each drawing one of the meshes
+
+	const std::string sceneGraphAssetFilepath = AssetManager::createAssetFilepath("benchmark/scene_graph");
+	{
+		Asset<SceneGraph> sceneGraphAsset;
+		sceneGraphAsset.allocateObject();
+		SceneGraph & sceneGraph = *sceneGraphAsset.get();
+
+		std::mt19937 random(1234);
+		std::vector<SceneGraph::Handle> nodes;
+
+		for (size_t idx = 0; idx < options.numSceneGraphNodes; ++idx)
+		{
+			const SceneGraph::Handle node = sceneGraph.newNode();
+			sceneGraph.setNodeTransform(node, transform_t(Vector3(static_cast<float>(random() % 100), 0.0f, static_cast<float>(random() % 100))));
+
+			if (!meshAssets.empty())
+				sceneGraph.getData(node).materialMeshPairs.emplace_back(materialAsset, meshAssets[idx % meshAssets.size()]);
+
+			if (!nodes.empty() && random() % 8 != 0)
+				sceneGraph.setNodeParent(node, nodes[random() % nodes.size()]);
+
+			nodes.push_back(node);
+		}
+
+		sceneGraphAsset.save(sceneGraphAssetFilepath);
+	}
+
+	results.push_back(run("scene_graph_deserialize", options, options.numSceneGraphNodes, [&]()
+	{
+		std::ifstream file(sceneGraphAssetFilepath, std::ios::binary);
+		SceneGraph sceneGraph;
+		if (!skipAssetMetaData(file) || !sceneGraph.deserialize(file))
+			return uint64_t(0);
+		return fileSize(sceneGraphAssetFilepath);
+	}));
+
+	size_t numLocalAssetFiles = 0;
+	uint64_t localAssetBytes = 0;
+	for (const auto & directoryEntry : std::filesystem::recursive_directory_iterator(AssetManager::assetDirectory))
+		if (directoryEntry.is_regular_file() && directoryEntry.path().extension().string() == AssetManager::assetFileExtension)
+		{
+			++numLocalAssetFiles;
+			localAssetBytes += directoryEntry.file_size();
+		}
+
+	results.push_back(run("import_local_assets", options, numLocalAssetFiles, [&]()
+	{
+		assetManager.importLocalAssets();
+		return localAssetBytes;
+	}));
+
+	std::string json = "[\n";
+	for (size_t idx = 0; idx < results.size(); ++idx)
+		json += "\t" + toJson(results[idx]) + (idx + 1 < results.size() ? ",\n" : "\n");
+	json += "]\n";
+
+	if (options.outputFilepath.empty())
+		std::cout << json;
+	else
+	{
+		std::ofstream outputFile(options.outputFilepath);
+		outputFile << json;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,229 @@
+// mud-cook: headless offline asset cooker. Imports every supported source file in a directory tree and
+// writes the resulting .masset files to an output directory, without creating a graphics context. Assets are laid
+// out by their source file's path in the tree, so files sharing a name in different directories don't collide.
+//
+// usage: mud-cook <source directory> <output directory> [jobs] [optimize-meshes] [static-batches]
+//
+// Files are cooked in parallel by worker processes (one source file per worker) so importers, which share the
+// AssetManager singleton, never run concurrently within a process.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <filesystem>
+#include <fmt/format.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "utils/asset_importer.hpp"
+#include "utils/asset_manager.hpp"
+#include "utils/cli.hpp"
+#include "utils/logger.hpp"
+#include "utils/stopwatch.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char ** environ;
+#endif
+
+namespace mud::cook
+{
+	const std::string k_workerFlag = "--worker";
+
+	// Imports a single source file into the asset directory of outputDirectory, under its path relative to sourceDirectory
+	int runWorker(const std::string & sourceFilepath, const std::string & sourceDirectory, const std::string & outputDirectory, bool optimizeMeshes, bool buildStaticBatches)
+	{
+		asset_importer::ImportOptions importOptions;
+		importOptions.optimizeMeshes = optimizeMeshes;
+		importOptions.buildStaticBatches = buildStaticBatches;
+		importOptions.sourceDirectory = sourceDirectory;
+		asset_importer::setImportOptions(importOptions);
+
+		std::filesystem::create_directories(outputDirectory);
+		std::filesystem::current_path(outputDirectory);
+
+		return AssetManager::getInstance().importAssetUnknownType(sourceFilepath) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// Runs the program with the arguments and waits for it to exit. No shell is involved, so file names are passed
+	// through as they are whatever characters they hold. Returns false if the program could not be started or failed.
+	bool runProcess(const std::vector<std::string> & arguments)
+	{
+#ifdef _WIN32
+		// CreateProcess takes one command line, which the C runtime splits again. Windows paths cannot hold quotes, so
+		// quoting each argument only needs the backslashes before its closing quote doubled.
+		std::string commandLine;
+		for (const std::string & argument : arguments)
+		{
+			const size_t numTrailingBackslashes = argument.size() - (argument.find_last_not_of('\\') + 1);
+			commandLine += (commandLine.empty() ? "\"" : " \"") + argument + std::string(numTrailingBackslashes, '\\') + "\"";
+		}
+
+		STARTUPINFOA startupInfo = {};
+		startupInfo.cb = sizeof(startupInfo);
+		PROCESS_INFORMATION processInfo = {};
+
+		if (!CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &processInfo))
+			return false;
+
+		WaitForSingleObject(processInfo.hProcess, INFINITE);
+
+		DWORD exitCode = EXIT_FAILURE;
+		GetExitCodeProcess(processInfo.hProcess, &exitCode);
+		CloseHandle(processInfo.hThread);
+		CloseHandle(processInfo.hProcess);
+
+		return exitCode == EXIT_SUCCESS;
+#else
+		std::vector<char *> argv;
+		for (const std::string & argument : arguments)
+			argv.push_back(const_cast<char *>(argument.c_str()));
+		argv.push_back(nullptr);
+
+		// Bare executable names are looked up in PATH, as a shell would
+		pid_t pid;
+		if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0)
+			return false;
+
+		int status = 0;
+		while (waitpid(pid, &status, 0) == -1)
+			if (errno != EINTR)
+				return false;
+
+		return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+#endif
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	using namespace mud;
+
+	const std::vector<std::string> arguments(argv + 1, argv + argc);
+
+	if (arguments.size() == 6 && arguments[0] == cook::k_workerFlag)
+		return cook::runWorker(arguments[1], arguments[2], arguments[3], arguments[4] == "true", arguments[5] == "true");
+
+	const cli::Command command("mud-cook", ": cooks a directory tree of source assets into .masset files",
+		{
+			cli::ParameterString("source", "Directory of source assets to import"),
+			cli::ParameterString("output", "Directory the cooked asset directory is written to")
+		},
+		{
+			cli::ParameterNumber("jobs", "Number of files cooked in parallel, defaults to the number of cores"),
+			cli::ParameterBool("optimize-meshes", "Collapse scene hierarchies and merge meshes, for static content"),
+			cli::ParameterBool("static-batches", "Merge scene meshes sharing a material into pre-transformed static batches, for static content")
+		});
+
+	std::string response;
+	if (!command.execute(arguments, response))
+	{
+		log(LogLevel::Error, fmt::format("{0}\nusage: mud-cook <source> <output> [jobs] [optimize-meshes] [static-batches]\n", response), "Cook");
+		return EXIT_FAILURE;
+	}
+
+	const std::filesystem::path sourceDirectory = std::filesystem::absolute(arguments[0]);
+	const std::filesystem::path outputDirectory = std::filesystem::absolute(arguments[1]);
+	const bool optimizeMeshes = arguments.size() > 3 && (arguments[3] == "true" || arguments[3] == "TRUE");
+	const bool buildStaticBatches = arguments.size() > 4 && (arguments[4] == "true" || arguments[4] == "TRUE");
+
+	size_t numJobs = std::max(1u, std::thread::hardware_concurrency());
+	if (arguments.size() > 2)
+	{
+		// The command only checked that jobs is a number
+		const std::string & jobsArgument = arguments[2];
+		const auto [end, error] = std::from_chars(jobsArgument.data(), jobsArgument.data() + jobsArgument.size(), numJobs);
+
+		if (error != std::errc() || end != jobsArgument.data() + jobsArgument.size() || numJobs == 0)
+		{
+			log(LogLevel::Error, fmt::format("Invalid argument '{0}' for parameter 'jobs': Argument is not a positive integer\n", jobsArgument), "Cook");
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (!std::filesystem::is_directory(sourceDirectory))
+	{
+		log(LogLevel::Error, fmt::format("Failed to cook '{0}': Provided path is not a directory\n", sourceDirectory.string()), "Cook");
+		return EXIT_FAILURE;
+	}
+
+	std::vector<std::string> sourceFilepaths;
+	for (const auto & directoryEntry : std::filesystem::recursive_directory_iterator(sourceDirectory))
+		if (directoryEntry.is_regular_file() && AssetManager::getImportAssetType(directoryEntry.path().string()) != AssetObjectType::Unsupported)
+			sourceFilepaths.push_back(directoryEntry.path().string());
+
+	// Outputs are named by their source's path relative to the source directory. Those that only differ by case would
+	// still overwrite each other on case-insensitive file systems, with workers writing the same files at once.
+	asset_importer::ImportOptions importOptions;
+	importOptions.sourceDirectory = sourceDirectory.string();
+	asset_importer::setImportOptions(importOptions);
+
+	std::vector<std::pair<std::string, size_t>> outputFilepaths;
+	for (size_t fileIdx = 0; fileIdx < sourceFilepaths.size(); ++fileIdx)
+	{
+		std::string outputFilepath = asset_importer::getAssetRelativeFilepath(sourceFilepaths[fileIdx]);
+		std::transform(outputFilepath.begin(), outputFilepath.end(), outputFilepath.begin(), [](unsigned char c) { return std::tolower(c); });
+		outputFilepaths.emplace_back(std::move(outputFilepath), fileIdx);
+	}
+
+	std::sort(outputFilepaths.begin(), outputFilepaths.end());
+
+	bool hasDuplicateOutputs = false;
+	for (size_t idx = 1; idx < outputFilepaths.size(); ++idx)
+		if (outputFilepaths[idx].first == outputFilepaths[idx - 1].first)
+		{
+			log(LogLevel::Error, fmt::format("Failed to cook '{0}': Its output would overwrite that of '{1}'\n", sourceFilepaths[outputFilepaths[idx].second], sourceFilepaths[outputFilepaths[idx - 1].second]), "Cook");
+			hasDuplicateOutputs = true;
+		}
+
+	if (hasDuplicateOutputs)
+		return EXIT_FAILURE;
+
+	log(LogLevel::Info, fmt::format("Cooking {0} source files from '{1}' with {2} jobs...\n", sourceFilepaths.size(), sourceDirectory.string(), numJobs), "Cook");
+
+	// Bare executable names are resolved through PATH, so only make explicit paths absolute
+	const std::string executableFilepath = std::filesystem::path(argv[0]).has_parent_path() ? std::filesystem::absolute(argv[0]).string() : std::string(argv[0]);
+
+	std::atomic<size_t> nextFileIdx{ 0 };
+	std::atomic<size_t> numFailed{ 0 };
+
+	Stopwatch stopwatch;
+	stopwatch.start();
+
+	std::vector<std::thread> workers;
+	for (size_t idx = 0; idx < std::min(numJobs, sourceFilepaths.size()); ++idx)
+		workers.emplace_back([&]()
+		{
+			for (size_t fileIdx = nextFileIdx++; fileIdx < sourceFilepaths.size(); fileIdx = nextFileIdx++)
+			{
+				const std::vector<std::string> workerArguments = {
+					executableFilepath, cook::k_workerFlag, sourceFilepaths[fileIdx], sourceDirectory.string(), outputDirectory.string(),
+					optimizeMeshes ? "true" : "false", buildStaticBatches ? "true" : "false"
+				};
+
+				if (!cook::runProcess(workerArguments))
+				{
+					log(LogLevel::Error, fmt::format("Failed to cook '{0}'\n", sourceFilepaths[fileIdx]), "Cook");
+					++numFailed;
+				}
+			}
+		});
+
+	for (std::thread & worker : workers)
+		worker.join();
+
+	log(LogLevel::Info, fmt::format("Cooked {0} of {1} source files in {2:.2f}s\n", sourceFilepaths.size() - numFailed, sourceFilepaths.size(), stopwatch.stop() / 1000.0), "Cook");
+
+	return numFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
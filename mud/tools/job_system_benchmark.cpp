@@ -0,0 +1,226 @@
+// Job system scaling benchmark: runs the same workloads with 0 (everything inline on the main thread) up to
+// --max-workers worker threads and reports throughput and speedup over the inline run. Results are written as a JSON
+// array, one object per benchmark and worker count.
+//
+// usage: mud_job_system_benchmark [--output <file>] [--iterations <n>] [--items <n>] [--jobs <n>] [--max-workers <n>]
+
+#include <cmath>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/job_system.hpp"
+#include "utils/logger.hpp"
+#include "utils/stopwatch.hpp"
+
+namespace mud::job_system_benchmark
+{
+	struct Options
+	{
+		std::string outputFilepath;
+		size_t iterations = 5;
+		size_t numItems = 1 << 16;
+		size_t numJobs = 1 << 14;
+		unsigned int maxWorkers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	};
+
+	struct Result
+	{
+		std::string name;
+		unsigned int numWorkers = 0;
+		size_t iterations = 0;
+		size_t numItems = 0;
+		double seconds = 0.0;
+		double speedup = 1.0;
+	};
+
+	// Keeps the optimiser from dropping the workloads
+	volatile float g_sink = 0;
+
+	// A few hundred nanoseconds of arithmetic per item
+	float computeItem(size_t idx)
+	{
+		float value = static_cast<float>(idx);
+		for (unsigned int step = 0; step < 64; ++step)
+			value = std::sqrt(value * 1.0001f + static_cast<float>(step));
+		return value;
+	}
+
+	template <typename TFunc>
+	Result run(const std::string & name, const Options & options, unsigned int numWorkers, size_t numItemsPerIteration, TFunc func)
+	{
+		Result result;
+		result.name = name;
+		result.numWorkers = numWorkers;
+		result.iterations = options.iterations;
+		result.numItems = numItemsPerIteration * options.iterations;
+
+		Stopwatch stopwatch;
+		stopwatch.start();
+
+		for (size_t idx = 0; idx < options.iterations; ++idx)
+			func();
+
+		result.seconds = stopwatch.stop() / 1000.0;
+
+		log(LogLevel::Info, fmt::format("{0} ({1} workers): {2:.3f}s\n", name, numWorkers, result.seconds), "Benchmark");
+
+		return result;
+	}
+
+	std::string toJson(const Result & result)
+	{
+		const double seconds = result.seconds > 0.0 ? result.seconds : 1e-9;
+
+		return fmt::format(
+			"{{\"benchmark\":\"{0}\",\"workers\":{1},\"iterations\":{2},\"items\":{3},\"seconds\":{4:.6f},\"items_per_s\":{5:.3f},\"speedup\":{6:.3f}}}",
+			result.name, result.numWorkers, result.iterations, result.numItems, result.seconds, result.numItems / seconds, result.speedup);
+	}
+
+	bool parseOptions(int argc, char ** argv, Options & options)
+	{
+		for (int idx = 1; idx < argc; ++idx)
+		{
+			const std::string argument = argv[idx];
+
+			if (idx + 1 >= argc)
+			{
+				log(LogLevel::Error, fmt::format("Missing value for option '{0}'\n", argument), "Benchmark");
+				return false;
+			}
+
+			const std::string value = argv[++idx];
+
+			if (argument == "--output")
+				options.outputFilepath = value;
+			else if (argument == "--iterations")
+				options.iterations = std::stoul(value);
+			else if (argument == "--items")
+				options.numItems = std::stoul(value);
+			else if (argument == "--jobs")
+				options.numJobs = std::stoul(value);
+			else if (argument == "--max-workers")
+				options.maxWorkers = static_cast<unsigned int>(std::stoul(value));
+			else
+			{
+				log(LogLevel::Error, fmt::format("Unknown option '{0}'\n", argument), "Benchmark");
+				return false;
+			}
+		}
+
+		return options.iterations > 0;
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	using namespace mud;
+	using namespace mud::job_system_benchmark;
+
+	Options options;
+	try
+	{
+		if (!parseOptions(argc, argv, options))
+			return EXIT_FAILURE;
+	}
+	catch (const std::exception &)
+	{
+		log(LogLevel::Error, "Invalid numeric option value\n", "Benchmark");
+		return EXIT_FAILURE;
+	}
+
+	std::vector<Result> results;
+	std::vector<float> values(options.numItems);
+
+	// Inline baselines of each benchmark, for the speedups
+	std::vector<double> baselineSeconds;
+
+	for (unsigned int numWorkers = 0; numWorkers <= options.maxWorkers; numWorkers = numWorkers == 0 ? 1 : numWorkers * 2)
+	{
+		// Without init every job runs inline, which is the single threaded baseline
+		if (numWorkers > 0)
+			job_system::init(numWorkers);
+
+		std::vector<Result> workerResults;
+
+		// Even work split into ranges
+		workerResults.push_back(run("parallel_for", options, numWorkers, options.numItems, [&]()
+		{
+			job_system::parallelFor(values.size(), 256, [&](size_t first, size_t last) {
+				for (size_t idx = first; idx < last; ++idx)
+					values[idx] = computeItem(idx);
+			});
+			g_sink = values[values.size() / 2];
+		}));
+
+		// Ranges whose cost grows along the range, which only scales if idle workers steal
+		workerResults.push_back(run("parallel_for_uneven", options, numWorkers, options.numItems, [&]()
+		{
+			job_system::parallelFor(values.size() / 16, 16, [&](size_t first, size_t last) {
+				for (size_t idx = first; idx < last; ++idx)
+				{
+					float value = 0;
+					for (size_t repeat = 0; repeat < 1 + idx * 32 / (values.size() / 16); ++repeat)
+						value += computeItem(idx + repeat);
+					values[idx] = value;
+				}
+			});
+			g_sink = values[0];
+		}));
+
+		// Many tiny independent jobs, measuring queueing overhead
+		workerResults.push_back(run("small_jobs", options, numWorkers, options.numJobs, [&]()
+		{
+			job_system::Counter counter;
+			for (size_t idx = 0; idx < options.numJobs; ++idx)
+				job_system::run([&values, idx]() { values[idx % values.size()] = computeItem(idx) * 0.0f + 1.0f; }, &counter);
+			job_system::wait(counter);
+		}));
+
+		// Fan-out stages that each depend on the previous stage finishing
+		workerResults.push_back(run("dependent_stages", options, numWorkers, options.numJobs, [&]()
+		{
+			constexpr size_t k_numStages = 16;
+			const size_t numJobsPerStage = std::max<size_t>(options.numJobs / k_numStages, 1);
+
+			std::vector<job_system::Counter> stageCounters(k_numStages);
+			for (size_t stage = 0; stage < k_numStages; ++stage)
+				for (size_t idx = 0; idx < numJobsPerStage; ++idx)
+					job_system::run([&values, stage, idx]() { values[(stage * 7919 + idx) % values.size()] += computeItem(idx); },
+						&stageCounters[stage], stage > 0 ? &stageCounters[stage - 1] : nullptr);
+
+			job_system::wait(stageCounters.back());
+		}));
+
+		if (numWorkers == 0)
+			for (const Result & result : workerResults)
+				baselineSeconds.push_back(result.seconds);
+
+		for (size_t idx = 0; idx < workerResults.size(); ++idx)
+		{
+			workerResults[idx].speedup = baselineSeconds[idx] / (workerResults[idx].seconds > 0.0 ? workerResults[idx].seconds : 1e-9);
+			results.push_back(workerResults[idx]);
+		}
+
+		job_system::destroy();
+	}
+
+	std::string json = "[\n";
+	for (size_t idx = 0; idx < results.size(); ++idx)
+		json += "\t" + toJson(results[idx]) + (idx + 1 < results.size() ? ",\n" : "\n");
+	json += "]\n";
+
+	if (options.outputFilepath.empty())
+		std::cout << json;
+	else
+	{
+		std::ofstream outputFile(options.outputFilepath);
+		outputFile << json;
+	}
+
+	return EXIT_SUCCESS;
+}
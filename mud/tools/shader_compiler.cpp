@@ -0,0 +1,77 @@
+// Offline shader compiler: precompiles every GLSL shader in a directory to versioned SPIR-V blobs named after
+// the build profile (eg. "pbr.frag" -> "pbr.frag.performance.v1.spv") that ShaderModuleBase::loadSource picks up at runtime.
+//
+// usage: mud_shader_compiler <shader directory> [debug|performance]
+
+#include <cstdlib>
+#include <filesystem>
+#include <fmt/format.h>
+
+#include "graphics/backend/spirv/spirv.hpp"
+#include "utils/file_io.hpp"
+#include "utils/logger.hpp"
+
+int main(int argc, char ** argv)
+{
+	if (argc < 2)
+	{
+		mud::log(mud::LogLevel::Error, "usage: mud_shader_compiler <shader directory> [debug|performance]\n", "Shader Compiler");
+		return EXIT_FAILURE;
+	}
+
+	const std::filesystem::path shaderDirectory(argv[1]);
+	const std::string profileName = argc > 2 ? argv[2] : "performance";
+
+	mud::ShaderBuildProfile profile;
+	if (profileName == "debug")
+		profile = mud::ShaderBuildProfile::Debug;
+	else if (profileName == "performance")
+		profile = mud::ShaderBuildProfile::Performance;
+	else
+	{
+		mud::log(mud::LogLevel::Error, fmt::format("Unknown shader build profile '{0}'\n", profileName), "Shader Compiler");
+		return EXIT_FAILURE;
+	}
+
+	std::error_code errorCode;
+	if (!std::filesystem::is_directory(shaderDirectory, errorCode))
+	{
+		mud::log(mud::LogLevel::Error, fmt::format("'{0}' is not a directory\n", shaderDirectory.string()), "Shader Compiler");
+		return EXIT_FAILURE;
+	}
+
+	size_t numCompiled = 0;
+	size_t numFailed = 0;
+
+	for (const std::filesystem::directory_entry & entry : std::filesystem::directory_iterator(shaderDirectory))
+	{
+		if (!entry.is_regular_file())
+			continue;
+
+		mud::ShaderType type;
+		const std::string extension = entry.path().extension().string();
+
+		if (extension == ".vert")
+			type = mud::ShaderType::Vertex;
+		else if (extension == ".frag")
+			type = mud::ShaderType::Fragment;
+		else
+			continue;
+
+		const std::string sourceFilepath = entry.path().string();
+		const std::vector<uint32_t> spirv = mud::graphics_backend::spirv::compileSourceToSPIRV(sourceFilepath, type, mud::file::readText(sourceFilepath), profile);
+
+		if (spirv.empty() || !mud::file::writeBinary(mud::graphics_backend::spirv::getSPIRVBlobFilepath(sourceFilepath, profile), spirv))
+		{
+			++numFailed;
+			continue;
+		}
+
+		mud::log(mud::LogLevel::Trace, fmt::format("Compiled '{0}' ({1} bytes)\n", sourceFilepath, spirv.size() * sizeof(uint32_t)), "Shader Compiler");
+		++numCompiled;
+	}
+
+	mud::log(mud::LogLevel::Info, fmt::format("Compiled {0} shaders with the {1} profile, {2} failed\n", numCompiled, profileName, numFailed), "Shader Compiler");
+
+	return numFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
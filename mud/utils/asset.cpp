@@ -1,15 +1,76 @@
 #include "asset.hpp"
 
+#include <cstring>
 #include <filesystem>
+#include <streambuf>
+#include <vector>
 
 #include "asset_manager.hpp"
 #include "asset_object.hpp"
 #include "asset_importer.hpp"
 #include "logger.hpp"
+#include "xxhash.hpp"
 
 namespace mud
 {
-	const std::string AssetBase::expectedHeaderContent = "mud_asset_file";
+	namespace {
+
+		// Passes writes on to another stream buffer, hashing them and counting their size on the way. Asset
+		// serialization only ever writes forward, so seeking is not supported.
+		class HashingStreamBuffer : public std::streambuf
+		{
+		public:
+
+			explicit HashingStreamBuffer(std::streambuf * target)
+				: m_target(target), m_sizeBytes(0)
+			{ }
+
+			std::streambuf * getTarget() const
+			{
+				return m_target;
+			}
+
+			uint64_t getSizeBytes() const
+			{
+				return m_sizeBytes;
+			}
+
+			uint64_t getHash() const
+			{
+				return m_hash.getHash();
+			}
+
+		protected:
+
+			int_type overflow(int_type character) override
+			{
+				if (traits_type::eq_int_type(character, traits_type::eof()))
+					return traits_type::not_eof(character);
+
+				const char byte = traits_type::to_char_type(character);
+				return xsputn(&byte, 1) == 1 ? character : traits_type::eof();
+			}
+
+			std::streamsize xsputn(const char * data, std::streamsize sizeBytes) override
+			{
+				const std::streamsize numWritten = m_target->sputn(data, sizeBytes);
+				m_hash.update(data, static_cast<size_t>(numWritten));
+				m_sizeBytes += static_cast<uint64_t>(numWritten);
+				return numWritten;
+			}
+
+			int sync() override
+			{
+				return m_target->pubsync();
+			}
+
+		private:
+
+			std::streambuf * m_target;
+			XxHash64State m_hash;
+			uint64_t m_sizeBytes;
+		};
+	}
 
 	AssetBase::AssetBase()
 		: m_object(nullptr)
@@ -89,11 +150,39 @@ namespace mud
 			return false;
 		}
 
-		serialization_helpers::serialize(file, expectedHeaderContent);
-		serialization_helpers::serialize(file, m_object->getType());
+		AssetFileHeader header{};
+		std::memcpy(header.magic, AssetFileHeader::k_magic, sizeof(header.magic));
+		header.version = AssetFileHeader::k_currentVersion;
+		header.flags = AssetFileFlags_None;
+		header.type = static_cast<uint32_t>(m_object->getType());
+
+		// Payload size and checksum are patched in once the payload has been written, it is hashed on its way out
+		serialization_helpers::serialize(file, header);
+
+		HashingStreamBuffer payloadBuffer(file.rdbuf());
+		static_cast<std::ios &>(file).rdbuf(&payloadBuffer);
+
 		m_uuid.serialize(file);
 		serialization_helpers::serialize(file, m_importFilepath);
-		return m_object->serialize(file);
+		const bool isPayloadSerialized = m_object->serialize(file);
+
+		static_cast<std::ios &>(file).rdbuf(payloadBuffer.getTarget());
+		if (!isPayloadSerialized)
+			return false;
+
+		header.payloadSizeBytes = payloadBuffer.getSizeBytes();
+		header.payloadChecksum = payloadBuffer.getHash();
+
+		file.seekp(0);
+		file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+		if (!file.good())
+		{
+			log(LogLevel::Error, fmt::format("Failed to save asset '{0}': Could not write file header\n", m_filepath), "Asset");
+			return false;
+		}
+
+		return true;
 	}
 
 	bool AssetBase::save(const std::string & filepath)
@@ -116,15 +205,7 @@ namespace mud
 		m_importFilepath = metaData.importFilepath;
 
 		if (loadAssetObject)
-		{
-			if (!allocateObjectInternal())
-			{
-				log(LogLevel::Error, fmt::format("Failed to load asset '{0}': Failed to allocate asset object\n", m_filepath), "Asset");
-				return false;
-			}
-
-			return m_object->deserialize(file);
-		}
+			return deserializeObject(file, metaData);
 		
 		return true;
 	}
@@ -168,26 +249,68 @@ namespace mud
 		return deserializeMetaData(file, filepath, metaData);
 	}
 	
-	bool AssetBase::deserializeMetaData(std::ifstream & file, const std::string & filepath, AssetMetaData & metaData)
+	bool AssetBase::validateFileHeader(const AssetFileHeader & header, uint64_t fileSizeBytes, std::string & error, const void * data)
 	{
-		if (!serialization_helpers::deserialize(file, metaData.header))
+		if (std::memcmp(header.magic, AssetFileHeader::k_magic, sizeof(header.magic)) != 0)
 		{
-			log(LogLevel::Error, fmt::format("Failed to deserialize asset meta data from file '{0}': failed to read file header\n", filepath), "Asset");
+			error = "unexpected or corrupt header content (files saved before versioned headers must be re-imported)";
 			return false;
 		}
 
-		if (metaData.header != expectedHeaderContent)
+		if (header.version == 0 || header.version > AssetFileHeader::k_currentVersion)
 		{
-			log(LogLevel::Error, fmt::format("Failed to deserialize asset meta data from file '{0}': unexpected or corrupt header content ({1})\n", filepath, metaData.header), "Asset");
+			error = fmt::format("unsupported file version {0} (current version is {1})", header.version, AssetFileHeader::k_currentVersion);
 			return false;
 		}
 
-		if (!serialization_helpers::deserialize(file, metaData.type))
+		if ((header.flags & ~(AssetFileFlags_Compressed | AssetFileFlags_Quantized)) != 0)
 		{
-			log(LogLevel::Error, fmt::format("Failed to deserialize asset meta data from file '{0}': failed to read file type\n", filepath), "Asset");
+			error = fmt::format("unknown flags 0x{0:x}", header.flags);
 			return false;
 		}
 
+		if (header.type == static_cast<uint32_t>(AssetObjectType::Unsupported) || header.type > static_cast<uint32_t>(AssetObjectType::Texture))
+		{
+			error = fmt::format("unexpected asset type {0}", header.type);
+			return false;
+		}
+
+		if (fileSizeBytes < sizeof(AssetFileHeader) || header.payloadSizeBytes != fileSizeBytes - sizeof(AssetFileHeader))
+		{
+			error = fmt::format("payload size mismatch, file is truncated or corrupt (expected {0} bytes, found {1})", header.payloadSizeBytes, fileSizeBytes < sizeof(AssetFileHeader) ? 0 : fileSizeBytes - sizeof(AssetFileHeader));
+			return false;
+		}
+
+		if (data != nullptr && xxHash64(static_cast<const char *>(data) + sizeof(AssetFileHeader), header.payloadSizeBytes) != header.payloadChecksum)
+		{
+			error = "payload checksum mismatch, file is corrupt";
+			return false;
+		}
+
+		return true;
+	}
+	
+	bool AssetBase::deserializeMetaData(std::ifstream & file, const std::string & filepath, AssetMetaData & metaData)
+	{
+		file.seekg(0, std::ios::end);
+		const uint64_t fileSizeBytes = static_cast<uint64_t>(file.tellg());
+		file.seekg(0);
+
+		if (!serialization_helpers::deserialize(file, metaData.fileHeader))
+		{
+			log(LogLevel::Error, fmt::format("Failed to deserialize asset meta data from file '{0}': failed to read file header\n", filepath), "Asset");
+			return false;
+		}
+
+		std::string error;
+		if (!validateFileHeader(metaData.fileHeader, fileSizeBytes, error))
+		{
+			log(LogLevel::Error, fmt::format("Failed to deserialize asset meta data from file '{0}': {1}\n", filepath, error), "Asset");
+			return false;
+		}
+
+		metaData.type = static_cast<AssetObjectType>(metaData.fileHeader.type);
+
 		if (!metaData.uuid.deserialize(file))
 		{
 			log(LogLevel::Error, fmt::format("Failed to deserialize asset meta data from file '{0}': Failed to read asset UUID\n", filepath), "Asset");
@@ -219,6 +342,24 @@ namespace mud
 		if (!deserializeMetaData(file, m_filepath, metaData))
 			return false;
 
+		return deserializeObject(file, metaData);
+	}
+
+	bool AssetBase::deserializeObject(std::ifstream & file, const AssetMetaData & metaData) const
+	{
+		const std::streampos objectPosition = file.tellg();
+
+		// Verify the whole payload before handing the stream to the object so corrupt files are rejected up front
+		std::vector<char> payload(metaData.fileHeader.payloadSizeBytes);
+		file.seekg(sizeof(AssetFileHeader));
+		if (!serialization_helpers::deserialize(file, payload.data(), payload.size()) || xxHash64(payload.data(), payload.size()) != metaData.fileHeader.payloadChecksum)
+		{
+			log(LogLevel::Error, fmt::format("Failed to load asset '{0}': payload checksum mismatch, file is corrupt\n", m_filepath), "Asset");
+			return false;
+		}
+
+		file.seekg(objectPosition);
+
 		if (!allocateObjectInternal())
 		{
 			log(LogLevel::Error, fmt::format("Failed to load asset '{0}': Failed to allocate asset object\n", m_filepath), "Asset");
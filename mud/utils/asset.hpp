@@ -1,6 +1,7 @@
 #ifndef ASSET_HPP
 #define ASSET_HPP
 
+#include <cstdint>
 #include <fstream>
 #include <string>
 
@@ -11,9 +12,33 @@ namespace mud
 {
 	class AssetObjectBase;
 
+	enum AssetFileFlags : uint16_t
+	{
+		AssetFileFlags_None = 0,
+		AssetFileFlags_Compressed = 1 << 0,
+		AssetFileFlags_Quantized = 1 << 1
+	};
+
+	// Fixed-size header at the start of every asset file. Everything after it is the payload, which the
+	// size and checksum cover, so a file can be validated from memory (eg. mmap) without parsing it.
+	struct AssetFileHeader
+	{
+		static constexpr char k_magic[8] = { 'M', 'U', 'D', 'A', 'S', 'S', 'E', 'T' };
+		static constexpr uint16_t k_currentVersion = 1;
+
+		char magic[8];
+		uint16_t version;
+		uint16_t flags;
+		uint32_t type;
+		uint64_t payloadSizeBytes;
+		uint64_t payloadChecksum;
+	};
+
+	static_assert(sizeof(AssetFileHeader) == 32, "AssetFileHeader must have a fixed on-disk size");
+
 	struct AssetMetaData
 	{
-		std::string header;
+		AssetFileHeader fileHeader;
 		AssetObjectType type;
 		UUID uuid;
 		std::string importFilepath;
@@ -59,6 +84,10 @@ namespace mud
 
 		static bool deserializeMetaDataFromFile(const std::string & filepath, AssetMetaData & metaData);
 
+		// Validates a header against the total size of the file it came from. The checksum is only
+		// verified when the payload is provided, ie. data points at the whole file.
+		static bool validateFileHeader(const AssetFileHeader & header, uint64_t fileSizeBytes, std::string & error, const void * data = nullptr);
+
 	protected:
 
 		mutable AssetObjectBase * m_object;
@@ -69,9 +98,9 @@ namespace mud
 
 		bool deserializeObject() const;
 
-	private:
+		bool deserializeObject(std::ifstream & file, const AssetMetaData & metaData) const;
 
-		static const std::string expectedHeaderContent;
+	private:
 
 		UUID m_uuid;
 		std::string m_filepath;
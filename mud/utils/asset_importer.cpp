@@ -3,6 +3,7 @@
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
+#include <cstring>
 #include <filesystem>
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_FAILURE_USERMSG
@@ -191,7 +192,7 @@ namespace mud
 			}
 
 			const std::string importDirectory = std::filesystem::path(filepath).parent_path().string() + "/";
-			const std::string assetDirectory = std::filesystem::path(filepath).filename().string() + "/";
+			const std::string assetDirectory = asset_importer::getAssetRelativeFilepath(filepath) + "/";
 			const std::string assetTexturesDirectory = assetDirectory + "Textures/";
 			const std::string assetMaterialsDirectory = assetDirectory + "Materials/";
 
@@ -300,7 +301,7 @@ namespace mud
 		std::vector<MeshVertex> vertices;
 		std::vector<uint32_t> indices;
 
-		const std::string assetMeshesDirectory = std::filesystem::path(filepath).filename().string() + "/Meshes/";
+		const std::string assetMeshesDirectory = asset_importer::getAssetRelativeFilepath(filepath) + "/Meshes/";
 
 		for (size_t meshIdx = 0; meshIdx < assimpScene->mNumMeshes; ++meshIdx)
 		{
@@ -320,19 +321,25 @@ namespace mud
 		return meshAssets;
 	}
 
-	SceneGraph::Node * processAssimpNode(SceneGraph & sceneGraph, const std::vector<Asset<Material> *> & materialAssets, const std::vector<Asset<Mesh> *> & meshAssets, const std::string & filepath, const aiNode * assimpNode, const aiScene * assimpScene)
+	SceneGraph::Handle processAssimpNode(SceneGraph & sceneGraph, const std::vector<Asset<Material> *> & materialAssets, const std::vector<Asset<Mesh> *> & meshAssets, const std::string & filepath, const aiNode * assimpNode, const aiScene * assimpScene)
 	{
-		SceneGraph::Node * newSceneGraphNode = sceneGraph.newNode();
+		const SceneGraph::Handle newSceneGraphNode = sceneGraph.newNode();
 
 		aiMatrix4x4 assimpNodeTransform = assimpNode->mTransformation;
 		assimpNodeTransform.Transpose();
-		newSceneGraphNode->data.transform = *reinterpret_cast<Matrix4 *>(&assimpNodeTransform);
+
+		// aiMatrix4x4 is only float aligned while Matrix4 is loaded with aligned SSE loads, so the elements are copied
+		// rather than read in place
+		static_assert(sizeof(aiMatrix4x4) == sizeof(Matrix4), "aiMatrix4x4 and Matrix4 must both be 16 floats");
+		Matrix4 nodeTransform;
+		std::memcpy(&nodeTransform[0][0], &assimpNodeTransform.a1, sizeof(Matrix4));
+		sceneGraph.setNodeTransform(newSceneGraphNode, nodeTransform);
 
 		for (size_t meshIdx = 0; meshIdx < assimpNode->mNumMeshes; ++meshIdx)
 		{
 			aiMesh * assimpMesh = assimpScene->mMeshes[assimpNode->mMeshes[meshIdx]];
 
-			newSceneGraphNode->data.materialMeshPairs.emplace_back(
+			sceneGraph.getData(newSceneGraphNode).materialMeshPairs.emplace_back(
 				materialAssets[assimpMesh->mMaterialIndex],
 				meshAssets[assimpNode->mMeshes[meshIdx]]);
 		}
@@ -368,7 +375,7 @@ namespace mud
 					pointLight.attenuationK = assimpLight->mAttenuationConstant;
 					pointLight.attenuationL = assimpLight->mAttenuationLinear;
 					pointLight.attenuationQ = assimpLight->mAttenuationQuadratic;
-					newSceneGraphNode->data.pointLights.push_back(pointLight);
+					sceneGraph.getData(newSceneGraphNode).pointLights.push_back(pointLight);
 					log(LogLevel::Trace, fmt::format("3D scene Light found (Point): {0}\n", assimpNode->mName.C_Str()));
 					break;
 				}
@@ -396,7 +403,7 @@ namespace mud
 		for (size_t childIdx = 0; childIdx < assimpNode->mNumChildren; childIdx++)
 		{
 			const aiNode * assimpChildNode = assimpNode->mChildren[childIdx];
-			SceneGraph::Node * childNode = processAssimpNode(sceneGraph, materialAssets, meshAssets, filepath, assimpChildNode, assimpScene);
+			const SceneGraph::Handle childNode = processAssimpNode(sceneGraph, materialAssets, meshAssets, filepath, assimpChildNode, assimpScene);
 			sceneGraph.setNodeParent(childNode, newSceneGraphNode);
 		}
 
@@ -406,6 +413,37 @@ namespace mud
 
 namespace mud
 {
+	namespace
+	{
+		asset_importer::ImportOptions _importOptions;
+	}
+
+	const asset_importer::ImportOptions & asset_importer::getImportOptions()
+	{
+		return _importOptions;
+	}
+
+	void asset_importer::setImportOptions(const ImportOptions & options)
+	{
+		_importOptions = options;
+	}
+
+	std::string asset_importer::getAssetRelativeFilepath(const std::string & filepath)
+	{
+		const std::filesystem::path path(filepath);
+
+		if (!_importOptions.sourceDirectory.empty())
+		{
+			std::error_code errorCode;
+			const std::filesystem::path relativePath = std::filesystem::relative(path, _importOptions.sourceDirectory, errorCode);
+
+			if (!errorCode && !relativePath.empty() && *relativePath.begin() != "..")
+				return relativePath.generic_string();
+		}
+
+		return path.filename().string();
+	}
+
 	template<>
 	bool asset_importer::import<FontFamily>(const std::string & filepath, Asset<FontFamily> * asset, const std::string & assetFilepath)
 	{
@@ -413,7 +451,7 @@ namespace mud
 		if (!asset->get()->fromFile(filepath))
 			return false;
 		asset->setImportFilepath(filepath);
-		asset->save(assetFilepath);
+		asset->save(assetFilepath.empty() ? AssetManager::createAssetFilepath(getAssetRelativeFilepath(filepath)) : assetFilepath);
 		asset->unload();
 		return true;
 	}
@@ -423,7 +461,11 @@ namespace mud
 	{
 		Assimp::Importer importer;
 
-		const aiScene * assimpScene = importer.ReadFile(filepath, aiProcessPreset_TargetRealtime_MaxQuality);
+		unsigned int postProcessFlags = aiProcessPreset_TargetRealtime_MaxQuality;
+		if (_importOptions.optimizeMeshes)
+			postProcessFlags |= aiProcess_OptimizeGraph | aiProcess_OptimizeMeshes;
+
+		const aiScene * assimpScene = importer.ReadFile(filepath, postProcessFlags);
 
 		if (!assimpScene)
 		{
@@ -449,8 +491,18 @@ namespace mud
 			processAssimpNode(*asset->get(), materialAssets, meshAssets, filepath, assimpChildNode, assimpScene);
 		}
 
+		if (_importOptions.buildStaticBatches)
+		{
+			log(LogLevel::Trace, "Building static batches...\n");
+
+			for (SceneGraph::Handle rootNode : asset->get()->getRootNodes())
+				asset->get()->getData(rootNode).isStatic = true;
+
+			asset->get()->buildStaticBatches();
+		}
+
 		asset->setImportFilepath(filepath);
-		asset->save(AssetManager::createAssetFilepath(std::filesystem::path(filepath).filename().string() + "/" + std::filesystem::path(filepath).filename().string()));
+		asset->save(AssetManager::createAssetFilepath(getAssetRelativeFilepath(filepath) + "/" + std::filesystem::path(filepath).filename().string()));
 		asset->unload();
 
 		return true;
@@ -484,7 +536,7 @@ namespace mud
 			static_cast<uint32_t>(STBI_rgb_alpha));
 
 		asset->setImportFilepath(filepath);
-		asset->save(assetFilepath);
+		asset->save(assetFilepath.empty() ? AssetManager::createAssetFilepath(getAssetRelativeFilepath(filepath)) : assetFilepath);
 		asset->unload();
 
 		return true;
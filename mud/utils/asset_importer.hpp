@@ -14,6 +14,26 @@ namespace mud
 
 	namespace asset_importer
 	{
+		struct ImportOptions
+		{
+			// Collapses the node hierarchy of imported scenes and merges meshes where possible (only suitable for static content)
+			bool optimizeMeshes = false;
+
+			// Marks imported scenes as static and merges their meshes into static batches saved with the scene (only suitable for static content)
+			bool buildStaticBatches = false;
+
+			// Directory the asset paths of imported files are made relative to, so that files sharing a name in different directories get their own assets.
+			// Files outside it, or every file when it is empty, are named by their file name alone.
+			std::string sourceDirectory;
+		};
+
+		const ImportOptions & getImportOptions();
+
+		void setImportOptions(const ImportOptions & options);
+
+		// Path of the assets imported from a file relative to the asset directory, without the asset file extension (eg. "props/chair.fbx")
+		std::string getAssetRelativeFilepath(const std::string & filepath);
+
 		template<typename T>
 		bool import(const std::string & filepath, Asset<T> * asset, const std::string & assetFilepath = "")
 		{
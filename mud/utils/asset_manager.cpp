@@ -141,30 +141,20 @@ namespace mud
 			pair.second->unload();
 	}
 	
-	bool AssetManager::importAssetUnknownType(const std::string & filepath)
+	AssetObjectType AssetManager::getImportAssetType(const std::string & filepath)
 	{
-		const std::filesystem::path path(filepath);
-
-		if (!path.has_extension())
-		{
-			log(LogLevel::Error, fmt::format("Failed to import asset file '{0}': Could not determine file type - missing file extension", filepath));
-			return false;
-		}
-
-		AssetBase * asset;
-
 		std::string ext = std::filesystem::path(filepath).extension().string();
 		std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c){ return std::tolower(c); });
 
 		if (ext == ".ttf")
-			return importAsset<FontFamily>(filepath) != nullptr;
+			return AssetObjectType::FontFamily;
 
 		if (ext == ".obj" ||
 			ext == ".gltf" ||
 			ext == ".glb" ||
 			ext == ".fbx" ||
 			ext == ".dae")
-			return importAsset<SceneGraph>(filepath) != nullptr;
+			return AssetObjectType::SceneGraph;
 
 		if (ext == ".png" ||
 			ext == ".jpg" ||
@@ -172,9 +162,37 @@ namespace mud
 			ext == ".bmp" ||
 			ext == ".tga" ||
 			ext == ".stl")
+			return AssetObjectType::Texture;
+
+		return AssetObjectType::Unsupported;
+	}
+	
+	bool AssetManager::importAssetUnknownType(const std::string & filepath)
+	{
+		const std::filesystem::path path(filepath);
+
+		if (!path.has_extension())
+		{
+			log(LogLevel::Error, fmt::format("Failed to import asset file '{0}': Could not determine file type - missing file extension", filepath));
+			return false;
+		}
+
+		switch (getImportAssetType(filepath))
+		{
+		case AssetObjectType::FontFamily:
+			return importAsset<FontFamily>(filepath) != nullptr;
+
+		case AssetObjectType::SceneGraph:
+			return importAsset<SceneGraph>(filepath) != nullptr;
+
+		case AssetObjectType::Texture:
 			return importAsset<Texture>(filepath) != nullptr;
+
+		default:
+			break;
+		}
 			
-		log(LogLevel::Error, fmt::format("Failed to import asset file '{0}': Could not determine file type - unsupported file extension '{1}'", filepath, ext));
+		log(LogLevel::Error, fmt::format("Failed to import asset file '{0}': Could not determine file type - unsupported file extension '{1}'", filepath, path.extension().string()));
 		return false;
 	}
 
@@ -23,6 +23,9 @@ namespace mud
 
 		static std::string createAssetFilepath(const std::string & relativeFilepath);
 
+		// Determines the asset type a source file imports as from its extension. Returns Unsupported if it can't be imported
+		static AssetObjectType getImportAssetType(const std::string & filepath);
+
 		template <typename T>
 		static const Asset<T> * getDefaultAsset()
 		{
@@ -1,6 +1,9 @@
 #ifndef ASSET_OBJECT_HPP
 #define ASSET_OBJECT_HPP
 
+#include <atomic>
+#include <cstdint>
+
 #include "i_serializable.hpp"
 
 namespace mud
@@ -24,13 +27,25 @@ namespace mud
 			return m_type;
 		}
 
+		// Small number unique to this object within the process, counting up from 0 in creation order, for packing
+		// into compact keys where a pointer would be too wide
+		uint32_t getRuntimeId() const
+		{
+			return m_runtimeId;
+		}
+
 	protected:
 
 		const AssetObjectType m_type;
+		const uint32_t m_runtimeId;
 
 		AssetObjectBase(AssetObjectType type)
-			: m_type(type)
+			: m_type(type), m_runtimeId(s_nextRuntimeId++)
 		{ }
+
+	private:
+
+		static inline std::atomic<uint32_t> s_nextRuntimeId{ 0 };
 	};
 
 	template <typename T>
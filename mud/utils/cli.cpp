@@ -2,6 +2,7 @@
 
 #include "logger.hpp"
 
+#include <cstdlib>
 #include <unordered_map>
 
 namespace mud::cli {
@@ -63,7 +64,19 @@ namespace mud::cli {
             response = "Invalid argument '" + argumentString + "' for parameter '" + m_name + "': Argument must be one of the suggested values";
             return false;
         }
-        
+
+        if (m_type == ParameterType::Number)
+        {
+            char * end = nullptr;
+            std::strtod(argumentString.c_str(), &end);
+
+            if (end != argumentString.c_str() + argumentString.size())
+            {
+                response = "Invalid argument '" + argumentString + "' for parameter '" + m_name + "': Argument is not a number";
+                return false;
+            }
+        }
+
         return true;
     }
 
@@ -77,13 +90,6 @@ namespace mud::cli {
         : Parameter(name, description, ParameterType::Number)
     { }
 
-    bool ParameterNumber::validateArgument(const std::string & argumentString, std::string & response) const
-    {
-        // todo: validate string is number: negative/floating point
-        response = "Invalid argument '" + argumentString + "' for parameter '" + m_name + "': Argument is not a number";
-        return false;
-    }
-
     ParameterString::ParameterString(const std::string & name, const std::string & description)
         : Parameter(name, description, ParameterType::String)
     { }
@@ -37,7 +37,9 @@ namespace mud::cli {
 
         void setSuggestions(const std::vector<std::string> & suggestions, bool forceUseSuggestions = false);
 
-        virtual bool validateArgument(const std::string & argumentString, std::string & response) const;
+        // Checks the argument against the suggestions and the parameter's type. Commands hold their parameters by
+        // value, so checks go by getType() rather than by overriding this in the typed parameter classes.
+        bool validateArgument(const std::string & argumentString, std::string & response) const;
 
     protected:
 
@@ -64,8 +66,6 @@ namespace mud::cli {
     public:
 
         ParameterNumber(const std::string & name, const std::string & description);
-
-        bool validateArgument(const std::string & argumentString, std::string & response) const override;
     };
 
     class ParameterString : public Parameter
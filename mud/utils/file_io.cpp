@@ -25,6 +25,31 @@ namespace mud::file {
 		return buffer.str();
 	}
 
+    bool readBinary(const std::string & filepath, std::vector<uint32_t> & data)
+    {
+        std::ifstream file(filepath, std::ios::in | std::ios::binary | std::ios::ate);
+
+		if (file.fail())
+		{
+			log(LogLevel::Error, fmt::format("Failed to open file '{0}' for read\n", filepath), "File IO");
+			return false;
+		}
+
+		const std::streamsize sizeBytes = file.tellg();
+		file.seekg(0);
+
+		data.resize(static_cast<size_t>(sizeBytes) / sizeof(uint32_t));
+		file.read(reinterpret_cast<char *>(data.data()), data.size() * sizeof(uint32_t));
+
+		if (!file.good())
+		{
+			log(LogLevel::Error, fmt::format("Error while reading from file '{0}'\n", filepath), "File IO");
+			return false;
+		}
+
+        return true;
+    }
+
     bool writeBinary(const std::string & destination, const std::vector<uint32_t> & data)
     {
         std::ofstream file(destination, std::ios::out | std::ios::binary);
@@ -8,6 +8,8 @@ namespace mud::file {
 
 	std::string readText(const std::string & filepath);
 
+    bool readBinary(const std::string & filepath, std::vector<uint32_t> & data);
+
     bool writeBinary(const std::string & destination, const std::vector<uint32_t> & data);
 }
 
@@ -0,0 +1,295 @@
+#include "job_system.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+
+namespace mud::job_system
+{
+    namespace
+    {
+        struct Job
+        {
+            std::function<void()> function;
+            Counter * counter;
+        };
+
+        struct WorkerQueue
+        {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        // Queue 0 belongs to the main thread, queue i to worker i - 1
+        std::vector<std::unique_ptr<WorkerQueue>> _queues;
+        std::vector<std::thread> _workers;
+
+        WorkerQueue _mainThreadQueue;
+
+        std::atomic<bool> _isStopping{ false };
+        std::atomic<size_t> _numQueuedJobs{ 0 };
+        std::mutex _sleepMutex;
+        std::condition_variable _wakeCondition;
+
+        std::thread::id _mainThreadId;
+        bool _isInitialised = false;
+
+        // Queue the calling thread pushes to and pops from. Threads other than the main thread and the workers share
+        // the main thread's queue.
+        thread_local size_t _queueIdx = 0;
+
+        void push(Job job)
+        {
+            {
+                WorkerQueue & queue = *_queues[_queueIdx];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.jobs.push_back(std::move(job));
+            }
+
+            ++_numQueuedJobs;
+
+            // Taking the lock orders this with a worker checking for work before it sleeps, so the wake-up is not lost
+            {
+                std::lock_guard<std::mutex> lock(_sleepMutex);
+            }
+            _wakeCondition.notify_one();
+        }
+
+        // Pops the newest job of the calling thread's queue, or steals the oldest job of another queue
+        bool tryGetJob(Job & job)
+        {
+            for (size_t offset = 0; offset < _queues.size(); ++offset)
+            {
+                WorkerQueue & queue = *_queues[(_queueIdx + offset) % _queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+
+                if (queue.jobs.empty())
+                    continue;
+
+                if (offset == 0)
+                {
+                    job = std::move(queue.jobs.back());
+                    queue.jobs.pop_back();
+                }
+                else
+                {
+                    job = std::move(queue.jobs.front());
+                    queue.jobs.pop_front();
+                }
+
+                --_numQueuedJobs;
+                return true;
+            }
+
+            return false;
+        }
+
+        bool tryGetMainThreadJob(Job & job)
+        {
+            std::lock_guard<std::mutex> lock(_mainThreadQueue.mutex);
+            if (_mainThreadQueue.jobs.empty())
+                return false;
+
+            job = std::move(_mainThreadQueue.jobs.front());
+            _mainThreadQueue.jobs.pop_front();
+            return true;
+        }
+
+        void execute(Job & job)
+        {
+            job.function();
+
+            if (job.counter != nullptr)
+                decrement(*job.counter);
+        }
+
+        // Runs the job now when there are no workers yet, otherwise queues it
+        void schedule(Job job)
+        {
+            if (!_isInitialised)
+            {
+                execute(job);
+                return;
+            }
+
+            push(std::move(job));
+        }
+
+        void workerMain(size_t queueIdx)
+        {
+            _queueIdx = queueIdx;
+
+            while (true)
+            {
+                Job job;
+                if (tryGetJob(job))
+                {
+                    execute(job);
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(_sleepMutex);
+                _wakeCondition.wait(lock, []() {
+                    return _numQueuedJobs > 0 || _isStopping;
+                });
+
+                if (_isStopping && _numQueuedJobs == 0)
+                    return;
+            }
+        }
+    }
+
+    Counter::Counter()
+        : m_value(0)
+    { }
+
+    bool Counter::isDone() const
+    {
+        return m_value == 0;
+    }
+
+    void init(unsigned int numWorkers)
+    {
+        if (_isInitialised)
+            return;
+
+        if (numWorkers == 0)
+            numWorkers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+        _mainThreadId = std::this_thread::get_id();
+        _queueIdx = 0;
+        _isStopping = false;
+
+        for (unsigned int idx = 0; idx <= numWorkers; ++idx)
+            _queues.push_back(std::make_unique<WorkerQueue>());
+
+        // Workers only start once every queue exists, since they steal from all of them
+        _isInitialised = true;
+        for (unsigned int idx = 1; idx <= numWorkers; ++idx)
+            _workers.emplace_back(workerMain, idx);
+    }
+
+    void destroy()
+    {
+        if (!_isInitialised)
+            return;
+
+        // Workers keep running jobs until the queues are empty before they stop
+        {
+            std::lock_guard<std::mutex> lock(_sleepMutex);
+            _isStopping = true;
+        }
+        _wakeCondition.notify_all();
+
+        for (std::thread & worker : _workers)
+            worker.join();
+
+        // Anything queued by the last jobs, or by main thread jobs, runs here
+        Job job;
+        while (tryGetJob(job) || tryGetMainThreadJob(job))
+            execute(job);
+
+        _workers.clear();
+        _queues.clear();
+        _isInitialised = false;
+    }
+
+    bool isInitialised()
+    {
+        return _isInitialised;
+    }
+
+    unsigned int getNumWorkers()
+    {
+        return static_cast<unsigned int>(_workers.size());
+    }
+
+    bool isMainThread()
+    {
+        return !_isInitialised || std::this_thread::get_id() == _mainThreadId;
+    }
+
+    void run(std::function<void()> function, Counter * counter, Counter * dependency)
+    {
+        if (counter != nullptr)
+            increment(*counter);
+
+        if (dependency != nullptr)
+        {
+            // Checked under the dependency's lock, so the job is either released by the final decrement or sees zero
+            // here, never neither
+            std::lock_guard<std::mutex> lock(dependency->m_mutex);
+            if (dependency->m_value > 0)
+            {
+                dependency->m_dependents.push_back({ std::move(function), counter });
+                return;
+            }
+        }
+
+        schedule(Job{ std::move(function), counter });
+    }
+
+    void runOnMainThread(std::function<void()> function, Counter * counter)
+    {
+        if (counter != nullptr)
+            increment(*counter);
+
+        Job job{ std::move(function), counter };
+
+        if (!_isInitialised)
+        {
+            execute(job);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(_mainThreadQueue.mutex);
+        _mainThreadQueue.jobs.push_back(std::move(job));
+    }
+
+    void wait(Counter & counter)
+    {
+        const bool isMain = isMainThread();
+
+        while (!counter.isDone())
+        {
+            Job job;
+            if (tryGetJob(job) || (isMain && tryGetMainThreadJob(job)))
+                execute(job);
+            else
+                std::this_thread::yield();
+        }
+
+        // The final decrement may still hold the lock, and the caller is free to destroy the counter once this returns
+        std::lock_guard<std::mutex> lock(counter.m_mutex);
+    }
+
+    void processMainThreadJobs()
+    {
+        Job job;
+        while (tryGetMainThreadJob(job))
+            execute(job);
+    }
+
+    void increment(Counter & counter)
+    {
+        ++counter.m_value;
+    }
+
+    void decrement(Counter & counter)
+    {
+        // Reaching zero happens under the lock, so wait() can tell when the counter is no longer being touched
+        std::vector<std::pair<std::function<void()>, Counter *>> dependents;
+        {
+            std::lock_guard<std::mutex> lock(counter.m_mutex);
+            if (--counter.m_value > 0)
+                return;
+
+            dependents.swap(counter.m_dependents);
+        }
+
+        // Their counters were already incremented when they were queued
+        for (auto & dependent : dependents)
+            schedule(Job{ std::move(dependent.first), dependent.second });
+    }
+}
\ No newline at end of file
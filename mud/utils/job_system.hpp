@@ -0,0 +1,115 @@
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Work-stealing job system. Each worker thread owns a deque of jobs: it pushes and pops its own jobs at the back,
+// while idle workers steal from the front of the others. The main thread owns a deque too and runs jobs whenever it
+// waits on a counter, so waiting never blocks progress. Jobs that must run on the main thread, such as anything that
+// calls into GLFW, are queued separately and only run there.
+namespace mud::job_system
+{
+    // Tracks outstanding jobs. Jobs given a counter increment it when they are queued and decrement it when they
+    // finish; jobs can also be held back until a counter reaches zero. Only destroy or reuse a counter after wait() on
+    // it has returned.
+    class Counter
+    {
+    public:
+
+        Counter();
+
+        Counter(const Counter &) = delete;
+
+        Counter & operator=(const Counter &) = delete;
+
+        bool isDone() const;
+
+    private:
+
+        friend void run(std::function<void()> function, Counter * counter, Counter * dependency);
+
+        friend void increment(Counter & counter);
+
+        friend void decrement(Counter & counter);
+
+        friend void wait(Counter & counter);
+
+        std::atomic<uint32_t> m_value;
+        std::mutex m_mutex;
+
+        // Jobs queued with this counter as their dependency, released when it reaches zero
+        std::vector<std::pair<std::function<void()>, Counter *>> m_dependents;
+    };
+
+    // Starts numWorkers worker threads, or one fewer than the hardware threads when 0. Must be called from the main
+    // thread. Until it is called, every job runs immediately on the thread queuing it.
+    void init(unsigned int numWorkers = 0);
+
+    // Runs all queued jobs to completion, then stops and joins the workers
+    void destroy();
+
+    bool isInitialised();
+
+    // Worker threads, not counting the main thread
+    unsigned int getNumWorkers();
+
+    bool isMainThread();
+
+    // Queues function to run on any thread. counter, if given, is incremented now and decremented when the job
+    // finishes. If dependency is given, the job is not started before dependency reaches zero.
+    void run(std::function<void()> function, Counter * counter = nullptr, Counter * dependency = nullptr);
+
+    // Queues function to run on the main thread, the next time it calls processMainThreadJobs() or wait()
+    void runOnMainThread(std::function<void()> function, Counter * counter = nullptr);
+
+    // Runs queued jobs on the calling thread until counter reaches zero. On the main thread this includes main thread
+    // jobs.
+    void wait(Counter & counter);
+
+    // Runs the jobs queued with runOnMainThread(). Must be called from the main thread, the application does so once
+    // per frame.
+    void processMainThreadJobs();
+
+    void increment(Counter & counter);
+
+    void decrement(Counter & counter);
+
+    // Splits [0, count) into contiguous ranges of at least minRangeSize items, about two per thread so that stealing
+    // can even out uneven ranges, and calls function(first, last) for each as a job. Returns once every range is
+    // done, running ranges on the calling thread meanwhile.
+    template<typename Function>
+    void parallelFor(size_t count, size_t minRangeSize, Function function)
+    {
+        if (count == 0)
+            return;
+
+        const size_t maxRanges = (static_cast<size_t>(getNumWorkers()) + 1) * 2;
+        const size_t numRanges = std::clamp<size_t>(count / std::max<size_t>(minRangeSize, 1), 1, maxRanges);
+        const size_t rangeSize = (count + numRanges - 1) / numRanges;
+
+        if (numRanges == 1 || !isInitialised())
+        {
+            function(0, count);
+            return;
+        }
+
+        Counter counter;
+        for (size_t first = rangeSize; first < count; first += rangeSize)
+        {
+            const size_t last = std::min(first + rangeSize, count);
+            run([&function, first, last]() { function(first, last); }, &counter);
+        }
+
+        function(0, std::min(rangeSize, count));
+
+        wait(counter);
+    }
+}
+
+#endif
\ No newline at end of file
@@ -1,136 +1,369 @@
 #ifndef NODE_TREE_HPP
 #define NODE_TREE_HPP
 
-#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 namespace mud
 {
+	// Pooled tree of nodes stored contiguously. Nodes are referenced by generational handles which stay valid while
+	// the node exists, and are linked with parent/first-child/next-sibling indices so reparenting and deletion are
+	// O(1) (plus the size of a deleted subtree). Storage is re-sorted into depth-first order on demand so full-tree
+	// traversals walk memory linearly.
 	template<typename T>
 	class NodeTree
 	{
 	public:
 
+		static constexpr uint32_t k_invalidIndex = UINT32_MAX;
+
+		struct Handle
+		{
+			uint32_t index = k_invalidIndex;
+			uint32_t generation = 0;
+
+			bool isValid() const
+			{
+				return index != k_invalidIndex;
+			}
+
+			bool operator==(const Handle & other) const
+			{
+				return index == other.index && generation == other.generation;
+			}
+
+			bool operator!=(const Handle & other) const
+			{
+				return !(*this == other);
+			}
+		};
+
 		struct Node
 		{
-			Node * parent;
-			std::vector<Node *> children;
 			T data;
+
+		private:
+
+			friend class NodeTree;
+
+			uint32_t slot;
+			uint32_t parent;
+			uint32_t firstChild;
+			uint32_t lastChild;
+			uint32_t prevSibling;
+			uint32_t nextSibling;
 		};
 
-		~NodeTree()
+		virtual ~NodeTree() = default;
+
+		// All nodes in storage order, which is depth-first after sortDepthFirst()
+		const std::vector<Node> & getNodes() const
 		{
-			for (auto & node : m_nodes)
-				delete node;
+			return m_nodes;
 		}
 
-		const std::vector<Node *> & getRootNodes() const
+		size_t getNumNodes() const
 		{
-			return m_rootNodes;
+			return m_nodes.size();
 		}
 
-		const std::vector<Node *> & getNodes() const
+		bool isValid(Handle handle) const
 		{
-			return m_nodes;
+			return handle.index < m_slots.size() && m_slots[handle.index].generation == handle.generation && m_slots[handle.index].denseIndex != k_invalidIndex;
+		}
+
+		Handle getHandle(const Node & node) const
+		{
+			return makeHandle(node.slot);
 		}
 
-		Node * newNode()
+		Node & getNode(Handle handle)
 		{
-			Node * newNode = new Node;
-			newNode->parent = nullptr;
+			return m_nodes[m_slots[handle.index].denseIndex];
+		}
 
-			m_rootNodes.push_back(newNode);
-			m_nodes.push_back(newNode);
+		const Node & getNode(Handle handle) const
+		{
+			return m_nodes[m_slots[handle.index].denseIndex];
+		}
 
-			return newNode;
+		T & getData(Handle handle)
+		{
+			return getNode(handle).data;
+		}
+
+		const T & getData(Handle handle) const
+		{
+			return getNode(handle).data;
 		}
 
-		Node * newNode(const T & data)
+		Handle getParent(Handle handle) const
 		{
-			Node * newNode = newNode();
-			newNode->data = data;
-			return newNode;
+			return makeHandle(getNode(handle).parent);
 		}
 
-		void deleteNode(Node * node, bool deleteChildren = true)
+		Handle getFirstChild(Handle handle) const
 		{
-			if (deleteChildren)
+			return makeHandle(getNode(handle).firstChild);
+		}
+
+		Handle getNextSibling(Handle handle) const
+		{
+			return makeHandle(getNode(handle).nextSibling);
+		}
+
+		// Root nodes are siblings of each other, iterate them with getNextSibling
+		Handle getFirstRootNode() const
+		{
+			return makeHandle(m_firstRoot);
+		}
+
+		std::vector<Handle> getRootNodes() const
+		{
+			std::vector<Handle> rootNodes;
+			for (uint32_t slot = m_firstRoot; slot != k_invalidIndex; slot = nodeAt(slot).nextSibling)
+				rootNodes.push_back(makeHandle(slot));
+			return rootNodes;
+		}
+
+		std::vector<Handle> getChildren(Handle handle) const
+		{
+			std::vector<Handle> children;
+			for (uint32_t slot = getNode(handle).firstChild; slot != k_invalidIndex; slot = nodeAt(slot).nextSibling)
+				children.push_back(makeHandle(slot));
+			return children;
+		}
+
+		size_t getNumChildren(Handle handle) const
+		{
+			size_t numChildren = 0;
+			for (uint32_t slot = getNode(handle).firstChild; slot != k_invalidIndex; slot = nodeAt(slot).nextSibling)
+				++numChildren;
+			return numChildren;
+		}
+
+		Handle newNode()
+		{
+			return newNode(T());
+		}
+
+		Handle newNode(const T & data)
+		{
+			uint32_t slot;
+			if (m_freeSlots.empty())
 			{
-				for (size_t idx = 0; idx < node->children.size(); ++idx)
-					deleteNode(node->children[idx], true);
+				slot = static_cast<uint32_t>(m_slots.size());
+				m_slots.push_back(Slot{ k_invalidIndex, 1 });
 			}
 			else
 			{
-				for (size_t idx = 0; idx < node->children.size(); ++idx)
-					setNodeParent(node->children[idx], nullptr);
+				slot = m_freeSlots.back();
+				m_freeSlots.pop_back();
 			}
 
-			if (node->parent != nullptr)
+			m_slots[slot].denseIndex = static_cast<uint32_t>(m_nodes.size());
+
+			Node node;
+			node.data = data;
+			node.slot = slot;
+			node.parent = node.firstChild = node.lastChild = node.prevSibling = node.nextSibling = k_invalidIndex;
+			m_nodes.push_back(node);
+
+			// Appending a root after every existing node keeps depth-first order intact
+			link(slot, k_invalidIndex);
+
+			const Handle handle = makeHandle(slot);
+			onNodeCreated(handle);
+			return handle;
+		}
+
+		void deleteNode(Handle handle, bool deleteChildren = true)
+		{
+			const uint32_t slot = handle.index;
+
+			while (nodeAt(slot).firstChild != k_invalidIndex)
 			{
-				auto iter = std::find(node->parent->children.begin(), node->parent->children.end(), node);
-				if (iter != node->parent->children.end())
-					node->parent->children.erase(iter);
+				const Handle child = makeHandle(nodeAt(slot).firstChild);
+				if (deleteChildren)
+					deleteNode(child, true);
+				else
+					setNodeParent(child, Handle());
 			}
-			else
+
+			onNodeDeleted(handle);
+
+			unlink(slot);
+
+			// Swap-and-pop keeps storage contiguous, only the moved node's slot needs patching
+			const uint32_t denseIndex = m_slots[slot].denseIndex;
+			if (denseIndex != m_nodes.size() - 1)
 			{
-				auto iter = std::find(m_rootNodes.begin(), m_rootNodes.end(), node);
-				if (iter != m_rootNodes.end())
-					m_rootNodes.erase(iter);
+				m_nodes[denseIndex] = std::move(m_nodes.back());
+				m_slots[m_nodes[denseIndex].slot].denseIndex = denseIndex;
+				m_isDepthFirstOrdered = false;
 			}
+			m_nodes.pop_back();
 
-			auto iter = std::find(m_nodes.begin(), m_nodes.end(), node);
-			if (iter != m_nodes.end())
-				m_nodes.erase(iter);
+			m_slots[slot].denseIndex = k_invalidIndex;
+			++m_slots[slot].generation;
+			m_freeSlots.push_back(slot);
+		}
+
+		// Passing an invalid handle as the new parent makes the node a root node
+		void setNodeParent(Handle handle, Handle newParent)
+		{
+			const uint32_t slot = handle.index;
+			const uint32_t parentSlot = newParent.isValid() ? newParent.index : k_invalidIndex;
 
-			delete node;
+			if (nodeAt(slot).parent == parentSlot)
+				return;
+
+			unlink(slot);
+			link(slot, parentSlot);
+			m_isDepthFirstOrdered = false;
+
+			onNodeParentChanged(handle);
 		}
 
-		void setNodeParent(Node * node, Node * newParent)
+		Handle copyNode(Handle handle)
 		{
-			if (node->parent == newParent)
+			return copyNode(*this, handle.index);
+		}
+
+		Handle copyNodeTree(const NodeTree<T> & otherTree)
+		{
+			const Handle treeCopyRootNode = newNode();
+			for (uint32_t slot = otherTree.m_firstRoot; slot != k_invalidIndex; slot = otherTree.nodeAt(slot).nextSibling)
+				setNodeParent(copyNode(otherTree, slot), treeCopyRootNode);
+			return treeCopyRootNode;
+		}
+
+		// Reorders node storage so every node is followed by its descendants. O(n), and a no-op if the tree has not
+		// been restructured since the last sort
+		void sortDepthFirst()
+		{
+			if (m_isDepthFirstOrdered)
 				return;
 
-			if (node->parent != nullptr)
-			{
-				auto iter = std::find(node->parent->children.begin(), node->parent->children.end(), node);
-				if (iter != node->parent->children.end())
-					node->parent->children.erase(iter);
-			}
+			std::vector<Node> sortedNodes;
+			sortedNodes.reserve(m_nodes.size());
 
-			node->parent = newParent;
+			std::vector<uint32_t> stack;
+			for (uint32_t slot = m_lastRoot; slot != k_invalidIndex; slot = nodeAt(slot).prevSibling)
+				stack.push_back(slot);
 
-			if (node->parent != nullptr)
+			while (!stack.empty())
 			{
-				auto iter = std::find(m_rootNodes.begin(), m_rootNodes.end(), node);
-				if (iter != m_rootNodes.end())
-					m_rootNodes.erase(iter);
-				node->parent->children.push_back(node);
+				const uint32_t slot = stack.back();
+				stack.pop_back();
+
+				const Node & node = nodeAt(slot);
+				for (uint32_t child = node.lastChild; child != k_invalidIndex; child = nodeAt(child).prevSibling)
+					stack.push_back(child);
+
+				sortedNodes.push_back(std::move(m_nodes[m_slots[slot].denseIndex]));
 			}
-			else
-				m_rootNodes.push_back(node);
+
+			m_nodes = std::move(sortedNodes);
+			for (uint32_t idx = 0; idx < m_nodes.size(); ++idx)
+				m_slots[m_nodes[idx].slot].denseIndex = idx;
+
+			m_isDepthFirstOrdered = true;
 		}
 
-		Node * copyNode(const Node * node)
+	protected:
+
+		// Called after a node is created, its data is a copy of the source data
+		virtual void onNodeCreated(Handle node)
+		{ }
+
+		// Called after a node is moved to a new parent
+		virtual void onNodeParentChanged(Handle node)
+		{ }
+
+		// Called before a node is removed, after its children were deleted or detached
+		virtual void onNodeDeleted(Handle node)
+		{ }
+
+	private:
+
+		struct Slot
 		{
-			Node * copy = newNode();
-			for (Node * child : node->children)
-				setNodeParent(copyNode(child), copy);
-			copy->data = node->data;
-			return copy;
+			uint32_t denseIndex;
+			uint32_t generation;
+		};
+
+		Handle makeHandle(uint32_t slot) const
+		{
+			return slot == k_invalidIndex ? Handle() : Handle{ slot, m_slots[slot].generation };
 		}
 
-		Node * copyNodeTree(const NodeTree<T> & otherTree)
+		Node & nodeAt(uint32_t slot)
 		{
-			Node * treeCopyRootNode = newNode();
-			for (const Node * rootNode : otherTree.m_rootNodes)
-				setNodeParent(copyNode(rootNode), treeCopyRootNode);
-			return treeCopyRootNode;
+			return m_nodes[m_slots[slot].denseIndex];
 		}
 
-	private:
+		const Node & nodeAt(uint32_t slot) const
+		{
+			return m_nodes[m_slots[slot].denseIndex];
+		}
+
+		// Appends the node as the last child of parentSlot, or as the last root node
+		void link(uint32_t slot, uint32_t parentSlot)
+		{
+			uint32_t & first = parentSlot == k_invalidIndex ? m_firstRoot : nodeAt(parentSlot).firstChild;
+			uint32_t & last = parentSlot == k_invalidIndex ? m_lastRoot : nodeAt(parentSlot).lastChild;
+
+			Node & node = nodeAt(slot);
+			node.parent = parentSlot;
+			node.prevSibling = last;
+			node.nextSibling = k_invalidIndex;
+
+			if (last != k_invalidIndex)
+				nodeAt(last).nextSibling = slot;
+			else
+				first = slot;
+			last = slot;
+		}
+
+		void unlink(uint32_t slot)
+		{
+			Node & node = nodeAt(slot);
+
+			uint32_t & first = node.parent == k_invalidIndex ? m_firstRoot : nodeAt(node.parent).firstChild;
+			uint32_t & last = node.parent == k_invalidIndex ? m_lastRoot : nodeAt(node.parent).lastChild;
+
+			if (node.prevSibling != k_invalidIndex)
+				nodeAt(node.prevSibling).nextSibling = node.nextSibling;
+			else
+				first = node.nextSibling;
+
+			if (node.nextSibling != k_invalidIndex)
+				nodeAt(node.nextSibling).prevSibling = node.prevSibling;
+			else
+				last = node.prevSibling;
+
+			node.parent = node.prevSibling = node.nextSibling = k_invalidIndex;
+		}
+
+		Handle copyNode(const NodeTree<T> & sourceTree, uint32_t sourceSlot)
+		{
+			// Source nodes may live in this tree, so re-fetch them after every allocation
+			const Handle copy = newNode(sourceTree.nodeAt(sourceSlot).data);
+			for (uint32_t child = sourceTree.nodeAt(sourceSlot).firstChild; child != k_invalidIndex; child = sourceTree.nodeAt(child).nextSibling)
+				setNodeParent(copyNode(sourceTree, child), copy);
+			return copy;
+		}
 
-		std::vector<Node *> m_rootNodes;
-		std::vector<Node *> m_nodes;
+		std::vector<Node> m_nodes;
+		std::vector<Slot> m_slots;
+		std::vector<uint32_t> m_freeSlots;
+		uint32_t m_firstRoot = k_invalidIndex;
+		uint32_t m_lastRoot = k_invalidIndex;
+		bool m_isDepthFirstOrdered = true;
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
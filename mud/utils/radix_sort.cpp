@@ -0,0 +1,55 @@
+#include "radix_sort.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace mud
+{
+    namespace
+    {
+        constexpr size_t k_numDigits = sizeof(uint64_t);
+        constexpr size_t k_numBuckets = 256;
+
+        uint32_t getDigit(uint64_t key, size_t digit)
+        {
+            return static_cast<uint32_t>(key >> (digit * 8)) & 0xff;
+        }
+    }
+
+    void radixSort(RadixSortItem * items, RadixSortItem * scratch, size_t count)
+    {
+        if (count < 2)
+            return;
+
+        // Histograms of every digit in one pass over the keys
+        uint32_t histograms[k_numDigits][k_numBuckets] = {};
+        for (size_t idx = 0; idx < count; ++idx)
+            for (size_t digit = 0; digit < k_numDigits; ++digit)
+                ++histograms[digit][getDigit(items[idx].key, digit)];
+
+        RadixSortItem * source = items;
+        RadixSortItem * destination = scratch;
+
+        for (size_t digit = 0; digit < k_numDigits; ++digit)
+        {
+            uint32_t * histogram = histograms[digit];
+
+            // Every key shares this digit, the pass would not reorder anything
+            if (histogram[getDigit(source[0].key, digit)] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for (size_t bucket = 0; bucket < k_numBuckets; ++bucket)
+                offset += std::exchange(histogram[bucket], offset);
+
+            for (size_t idx = 0; idx < count; ++idx)
+                destination[histogram[getDigit(source[idx].key, digit)]++] = source[idx];
+
+            std::swap(source, destination);
+        }
+
+        if (source != items)
+            std::memcpy(items, source, count * sizeof(RadixSortItem));
+    }
+}
\ No newline at end of file
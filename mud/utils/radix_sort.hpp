@@ -0,0 +1,22 @@
+#ifndef RADIX_SORT_HPP
+#define RADIX_SORT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mud
+{
+    // A sort key and the index of the item it belongs to, so that large items are not moved while sorting
+    struct RadixSortItem
+    {
+        uint64_t key;
+        uint32_t value;
+    };
+
+    // Stable least significant digit radix sort of items by key, a byte at a time. scratch must hold count items, and
+    // its contents are overwritten. Bytes that are equal across every key are skipped, so keys with few distinct
+    // fields only pay for the bytes that vary.
+    void radixSort(RadixSortItem * items, RadixSortItem * scratch, size_t count);
+}
+
+#endif
\ No newline at end of file
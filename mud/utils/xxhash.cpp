@@ -0,0 +1,160 @@
+#include "xxhash.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mud
+{
+	namespace {
+
+		constexpr uint64_t k_prime1 = 0x9E3779B185EBCA87ULL;
+		constexpr uint64_t k_prime2 = 0xC2B2AE3D27D4EB4FULL;
+		constexpr uint64_t k_prime3 = 0x165667B19E3779F9ULL;
+		constexpr uint64_t k_prime4 = 0x85EBCA77C2B2AE63ULL;
+		constexpr uint64_t k_prime5 = 0x27D4EB2F165667C5ULL;
+
+		inline uint64_t rotateLeft(uint64_t x, int r)
+		{
+			return (x << r) | (x >> (64 - r));
+		}
+
+		inline uint64_t read64(const uint8_t * p)
+		{
+			uint64_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		inline uint32_t read32(const uint8_t * p)
+		{
+			uint32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		inline uint64_t round(uint64_t accumulator, uint64_t input)
+		{
+			accumulator += input * k_prime2;
+			accumulator = rotateLeft(accumulator, 31);
+			return accumulator * k_prime1;
+		}
+
+		inline uint64_t mergeRound(uint64_t accumulator, uint64_t value)
+		{
+			accumulator ^= round(0, value);
+			return accumulator * k_prime1 + k_prime4;
+		}
+
+		// Folds the bytes left over after the last whole stripe into the hash and finalises it
+		uint64_t finalise(uint64_t hash, const uint8_t * p, const uint8_t * end)
+		{
+			for (; p + 8 <= end; p += 8)
+			{
+				hash ^= round(0, read64(p));
+				hash = rotateLeft(hash, 27) * k_prime1 + k_prime4;
+			}
+
+			if (p + 4 <= end)
+			{
+				hash ^= static_cast<uint64_t>(read32(p)) * k_prime1;
+				hash = rotateLeft(hash, 23) * k_prime2 + k_prime3;
+				p += 4;
+			}
+
+			for (; p < end; ++p)
+			{
+				hash ^= static_cast<uint64_t>(*p) * k_prime5;
+				hash = rotateLeft(hash, 11) * k_prime1;
+			}
+
+			hash ^= hash >> 33;
+			hash *= k_prime2;
+			hash ^= hash >> 29;
+			hash *= k_prime3;
+			hash ^= hash >> 32;
+
+			return hash;
+		}
+
+		uint64_t mergeAccumulators(const uint64_t accumulators[4])
+		{
+			uint64_t hash = rotateLeft(accumulators[0], 1) + rotateLeft(accumulators[1], 7) + rotateLeft(accumulators[2], 12) + rotateLeft(accumulators[3], 18);
+			for (size_t idx = 0; idx < 4; ++idx)
+				hash = mergeRound(hash, accumulators[idx]);
+			return hash;
+		}
+	}
+
+	// Assumes a little-endian host, as does the rest of the asset serialization
+	uint64_t xxHash64(const void * data, size_t sizeBytes, uint64_t seed)
+	{
+		const uint8_t * p = static_cast<const uint8_t *>(data);
+		const uint8_t * const end = p + sizeBytes;
+		uint64_t hash;
+
+		if (sizeBytes >= 32)
+		{
+			const uint8_t * const limit = end - 32;
+			uint64_t accumulators[4] = { seed + k_prime1 + k_prime2, seed + k_prime2, seed, seed - k_prime1 };
+
+			do
+			{
+				for (size_t idx = 0; idx < 4; ++idx)
+					accumulators[idx] = round(accumulators[idx], read64(p + idx * 8));
+				p += 32;
+			} while (p <= limit);
+
+			hash = mergeAccumulators(accumulators);
+		}
+		else
+		{
+			hash = seed + k_prime5;
+		}
+
+		hash += static_cast<uint64_t>(sizeBytes);
+
+		return finalise(hash, p, end);
+	}
+
+	XxHash64State::XxHash64State(uint64_t seed)
+		: m_accumulators{ seed + k_prime1 + k_prime2, seed + k_prime2, seed, seed - k_prime1 }, m_seed(seed), m_totalSizeBytes(0), m_bufferSizeBytes(0)
+	{ }
+
+	void XxHash64State::update(const void * data, size_t sizeBytes)
+	{
+		const uint8_t * p = static_cast<const uint8_t *>(data);
+		const uint8_t * const end = p + sizeBytes;
+		m_totalSizeBytes += sizeBytes;
+
+		// Complete a stripe started by an earlier update first
+		if (m_bufferSizeBytes > 0)
+		{
+			const size_t numCopied = std::min(sizeof(m_buffer) - m_bufferSizeBytes, sizeBytes);
+			std::memcpy(m_buffer + m_bufferSizeBytes, p, numCopied);
+			m_bufferSizeBytes += numCopied;
+			p += numCopied;
+
+			if (m_bufferSizeBytes < sizeof(m_buffer))
+				return;
+
+			for (size_t idx = 0; idx < 4; ++idx)
+				m_accumulators[idx] = round(m_accumulators[idx], read64(m_buffer + idx * 8));
+			m_bufferSizeBytes = 0;
+		}
+
+		for (; p + 32 <= end; p += 32)
+			for (size_t idx = 0; idx < 4; ++idx)
+				m_accumulators[idx] = round(m_accumulators[idx], read64(p + idx * 8));
+
+		std::memcpy(m_buffer, p, static_cast<size_t>(end - p));
+		m_bufferSizeBytes = static_cast<size_t>(end - p);
+	}
+
+	uint64_t XxHash64State::getHash() const
+	{
+		uint64_t hash = m_totalSizeBytes >= 32 ? mergeAccumulators(m_accumulators) : m_seed + k_prime5;
+		hash += m_totalSizeBytes;
+
+		return finalise(hash, m_buffer, m_buffer + m_bufferSizeBytes);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef XXHASH_HPP
+#define XXHASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mud
+{
+	// 64-bit xxHash (XXH64) of a contiguous block of memory
+	uint64_t xxHash64(const void * data, size_t sizeBytes, uint64_t seed = 0);
+
+	// XXH64 of data fed in pieces, such as a stream being written. Gives the same hash as xxHash64 over all the pieces
+	// joined.
+	class XxHash64State
+	{
+	public:
+
+		explicit XxHash64State(uint64_t seed = 0);
+
+		void update(const void * data, size_t sizeBytes);
+
+		uint64_t getHash() const;
+
+	private:
+
+		uint64_t m_accumulators[4];
+		uint64_t m_seed;
+		uint64_t m_totalSizeBytes;
+
+		// Input not yet consumed by a whole 32 byte stripe
+		uint8_t m_buffer[32];
+		size_t m_bufferSizeBytes;
+	};
+}
+
+#endif